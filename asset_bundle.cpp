@@ -0,0 +1,112 @@
+#include "asset_bundle.h"
+#include "score_log.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static size_t AlignData(size_t offset) {
+    return (offset + 7) & ~(size_t)7;
+}
+
+void EncodeAssetBundle(const vector<AssetFile> &files, vector<unsigned char> &bytes) {
+    vector<AssetEntry> entries(files.size());
+    size_t offset = sizeof(AssetBundleHeader) + files.size() * sizeof(AssetEntry);
+    for (size_t i = 0; i < files.size(); i++) {
+        AssetEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, files[i].name.c_str(), MAX_ASSET_NAME - 1);
+        offset = AlignData(offset);
+        entry.offset = (uint32_t)offset;
+        entry.size = (uint32_t)files[i].data.size();
+        entry.checksum = Crc32(files[i].data.empty() ? NULL : &files[i].data[0], files[i].data.size());
+        offset += files[i].data.size();
+    }
+
+    AssetBundleHeader header;
+    memcpy(header.magic, ASSET_BUNDLE_MAGIC, sizeof(header.magic));
+    header.version = ASSET_BUNDLE_VERSION;
+    header.count = (uint32_t)files.size();
+    header.checksum = Crc32(entries.empty() ? NULL : &entries[0], entries.size() * sizeof(AssetEntry));
+
+    bytes.assign(offset, 0);
+    memcpy(&bytes[0], &header, sizeof(header));
+    if (!entries.empty()) memcpy(&bytes[sizeof(header)], &entries[0], entries.size() * sizeof(AssetEntry));
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!files[i].data.empty()) memcpy(&bytes[entries[i].offset], &files[i].data[0], files[i].data.size());
+    }
+}
+
+void AssetBundleInit(AssetBundle &bundle) {
+    bundle.data = NULL;
+    bundle.size = 0;
+    bundle.entries = NULL;
+    bundle.count = 0;
+    bundle.mapped = false;
+}
+
+bool AssetBundleOpenMemory(AssetBundle &bundle, const unsigned char* data, size_t size) {
+    AssetBundleInit(bundle);
+    if (size < sizeof(AssetBundleHeader)) return false;
+
+    AssetBundleHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, ASSET_BUNDLE_MAGIC, sizeof(header.magic)) != 0) return false;
+    if (header.version != ASSET_BUNDLE_VERSION) return false;
+    size_t tableSize = (size_t)header.count * sizeof(AssetEntry);
+    if (tableSize > size - sizeof(header)) return false;
+    if (Crc32(data + sizeof(header), tableSize) != header.checksum) return false;
+
+    const AssetEntry* entries = (const AssetEntry*)(data + sizeof(header));
+    for (uint32_t i = 0; i < header.count; i++) {
+        if (entries[i].offset > size || entries[i].size > size - entries[i].offset) return false;
+    }
+
+    bundle.data = data;
+    bundle.size = size;
+    bundle.entries = entries;
+    bundle.count = (int)header.count;
+    return true;
+}
+
+bool AssetBundleOpen(AssetBundle &bundle, const char* path) {
+    AssetBundleInit(bundle);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(AssetBundleHeader)) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    if (!AssetBundleOpenMemory(bundle, (const unsigned char*)map, info.st_size)) {
+        munmap(map, info.st_size);
+        return false;
+    }
+    bundle.mapped = true;
+    return true;
+}
+
+void AssetBundleClose(AssetBundle &bundle) {
+    if (bundle.mapped) munmap((void*)bundle.data, bundle.size);
+    AssetBundleInit(bundle);
+}
+
+bool AssetBundleFind(const AssetBundle &bundle, const char* name, const unsigned char* &data, size_t &size) {
+    for (int i = 0; i < bundle.count; i++) {
+        const AssetEntry &entry = bundle.entries[i];
+        if (strncmp(entry.name, name, MAX_ASSET_NAME) != 0) continue;
+        if (Crc32(bundle.data + entry.offset, entry.size) != entry.checksum) return false;
+        data = bundle.data + entry.offset;
+        size = entry.size;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Packed asset bundle (assets.ppa): every file the game loads in one file,
+// mapped once instead of opened one by one.
+//
+//   header     16 bytes: "PPAB", version, entry count, CRC-32 of the entries
+//   entries    64 bytes each: name, offset and size of the data, its CRC-32
+//   data       the files back to back, each starting on an 8 byte boundary
+//
+// The same bytes can be compiled into the executable (asset_packer --cpp).
+// The header and entries are the structs below in native byte order;
+// asset_bundle.cpp includes score_log.h, which rejects big-endian hosts.
+
+const char ASSET_BUNDLE_MAGIC[4] = {'P', 'P', 'A', 'B'};
+const uint32_t ASSET_BUNDLE_VERSION = 1;
+const int MAX_ASSET_NAME = 52;
+
+struct AssetBundleHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t checksum;          // Crc32 of the entry table
+};
+
+struct AssetEntry {
+    char name[MAX_ASSET_NAME];  // NUL padded file name, no directory
+    uint32_t offset;            // From the start of the bundle
+    uint32_t size;
+    uint32_t checksum;          // Crc32 of the data
+};
+static_assert(sizeof(AssetEntry) == 64, "asset entries are 64 bytes on disk");
+
+struct AssetFile {
+    std::string name;
+    std::vector<unsigned char> data;
+};
+
+struct AssetBundle {
+    const unsigned char* data;
+    size_t size;
+    const AssetEntry* entries;
+    int count;
+    bool mapped;                // Unmapped on close; embedded bundles are not
+};
+
+void EncodeAssetBundle(const std::vector<AssetFile> &files, std::vector<unsigned char> &bytes);
+
+void AssetBundleInit(AssetBundle &bundle);
+// Checks the header and entry table; the data is checked by AssetBundleFind
+bool AssetBundleOpenMemory(AssetBundle &bundle, const unsigned char* data, size_t size);
+bool AssetBundleOpen(AssetBundle &bundle, const char* path);
+void AssetBundleClose(AssetBundle &bundle);
+
+// Finds an asset by file name. False if it is missing or fails its checksum.
+// The data stays valid until the bundle is closed.
+bool AssetBundleFind(const AssetBundle &bundle, const char* name, const unsigned char* &data, size_t &size);
+
+#endif
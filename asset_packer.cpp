@@ -0,0 +1,78 @@
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include "asset_bundle.h"
+
+using namespace std;
+
+// Packs files into an asset bundle the game loads at startup, or into a C++
+// source file that compiles the bundle into the executable. Example:
+//   ./asset_packer assets.ppa resources/*.wav
+//   ./asset_packer --cpp embedded_assets.cpp resources/*.wav
+
+static bool ReadWholeFile(const char* path, vector<unsigned char> &data) {
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+static bool WriteBundle(const char* path, const vector<unsigned char> &bytes) {
+    ofstream out(path, ios::binary);
+    out.write((const char*)&bytes[0], bytes.size());
+    return (bool)out;
+}
+
+// Defines the symbols game_assets.cpp looks for when built with -DEMBED_ASSETS
+static bool WriteSource(const char* path, const vector<unsigned char> &bytes) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "// Generated by asset_packer; do not edit\n");
+    fprintf(out, "#include <stddef.h>\n\n");
+    fprintf(out, "alignas(8) extern const unsigned char embeddedAssetBundle[] = {");
+    for (size_t i = 0; i < bytes.size(); i++) {
+        fprintf(out, i % 16 == 0 ? "\n    %u," : " %u,", bytes[i]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "extern const size_t embeddedAssetBundleSize = %lu;\n", (unsigned long)bytes.size());
+    return fclose(out) == 0;
+}
+
+int main(int argc, char** argv) {
+    bool source = argc > 1 && strcmp(argv[1], "--cpp") == 0;
+    int first = source ? 2 : 1;
+    if (argc - first < 2) {
+        cerr << "usage: " << argv[0] << " [--cpp] OUTPUT FILE..." << endl;
+        return 1;
+    }
+
+    vector<AssetFile> files;
+    for (int i = first + 1; i < argc; i++) {
+        AssetFile file;
+        const char* slash = strrchr(argv[i], '/');
+        file.name = slash ? slash + 1 : argv[i];
+        if (file.name.size() >= (size_t)MAX_ASSET_NAME) {
+            cerr << "Name too long for the bundle: " << file.name << endl;
+            return 1;
+        }
+        if (!ReadWholeFile(argv[i], file.data)) {
+            cerr << "Could not read " << argv[i] << endl;
+            return 1;
+        }
+        files.push_back(file);
+    }
+
+    vector<unsigned char> bytes;
+    EncodeAssetBundle(files, bytes);
+    const char* outPath = argv[first];
+    if (!(source ? WriteSource(outPath, bytes) : WriteBundle(outPath, bytes))) {
+        cerr << "Could not write " << outPath << endl;
+        return 1;
+    }
+    cout << "Packed " << files.size() << " files, " << bytes.size() << " bytes, into " << outPath << endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "audio_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+struct SoundEvent {
+    int sound;
+    float volume;
+    float pitch;
+};
+
+struct Voice {
+    Sound alias;
+    long long startedAt;        // Play order, for stealing the oldest
+};
+
+// Ring buffer: the game thread writes tail, the audio thread writes head
+static SoundEvent events[AUDIO_QUEUE_SIZE];
+static atomic<unsigned> queueHead(0);
+static atomic<unsigned> queueTail(0);
+static int tickEvents = 0;              // Game thread only
+
+// Owned by the audio thread while it runs
+static Voice voices[MAX_AUDIO_SOUNDS][VOICES_PER_SOUND];
+static float baseVolume[MAX_AUDIO_SOUNDS];
+static bool soundLoaded[MAX_AUDIO_SOUNDS];  // Sounds that failed to load have no voices
+static int soundCount = 0;
+static long long playCount = 0;
+
+static thread audioThread;
+static mutex wakeMutex;
+static condition_variable wakeCondition;
+static atomic<bool> running(false);
+static atomic<bool> stopping(false);
+
+static atomic<long long> postedEvents(0);
+static atomic<long long> droppedFull(0);
+static atomic<long long> droppedCap(0);
+static atomic<long long> playedEvents(0);
+static atomic<long long> stolenVoices(0);
+
+static void PlayEvent(const SoundEvent &event) {
+    if (!soundLoaded[event.sound]) return;
+    Voice* pool = voices[event.sound];
+
+    // First idle voice, or else the one that started longest ago
+    Voice* voice = &pool[0];
+    bool idle = false;
+    for (int i = 0; i < VOICES_PER_SOUND && !idle; i++) {
+        if (!IsSoundPlaying(pool[i].alias)) {
+            voice = &pool[i];
+            idle = true;
+        } else if (pool[i].startedAt < voice->startedAt) {
+            voice = &pool[i];
+        }
+    }
+    if (!idle) {
+        StopSound(voice->alias);
+        stolenVoices++;
+    }
+
+    SetSoundVolume(voice->alias, baseVolume[event.sound] * event.volume);
+    SetSoundPitch(voice->alias, event.pitch);
+    PlaySound(voice->alias);
+    voice->startedAt = playCount++;
+    playedEvents++;
+}
+
+static void AudioWorker() {
+    while (true) {
+        unsigned head = queueHead.load(memory_order_relaxed);
+        unsigned tail = queueTail.load(memory_order_acquire);
+        while (head != tail) {
+            PlayEvent(events[head & (AUDIO_QUEUE_SIZE - 1)]);
+            head++;
+            queueHead.store(head, memory_order_release);
+        }
+        if (stopping.load()) break;
+
+        // The timeout covers a post landing between the check and the wait
+        unique_lock<mutex> lock(wakeMutex);
+        wakeCondition.wait_for(lock, chrono::milliseconds(50), [] {
+            return stopping.load() || queueTail.load(memory_order_acquire) != queueHead.load(memory_order_relaxed);
+        });
+    }
+}
+
+void AudioStart(const SoundAsset* assets, int count) {
+    soundCount = count < MAX_AUDIO_SOUNDS ? count : MAX_AUDIO_SOUNDS;
+    for (int s = 0; s < soundCount; s++) {
+        baseVolume[s] = assets[s].volume;
+        soundLoaded[s] = IsSoundValid(*assets[s].sound);
+        for (int v = 0; v < VOICES_PER_SOUND && soundLoaded[s]; v++) {
+            voices[s][v].alias = LoadSoundAlias(*assets[s].sound);
+            voices[s][v].startedAt = -1;
+        }
+    }
+    queueHead = queueTail = 0;
+    stopping = false;
+    running = true;
+    audioThread = thread(AudioWorker);
+}
+
+bool AudioPost(int sound, float volume, float pitch) {
+    if (!running.load(memory_order_relaxed) || sound < 0 || sound >= soundCount) return false;
+    postedEvents++;
+    if (tickEvents >= MAX_SOUND_EVENTS_PER_TICK) {
+        droppedCap++;
+        return false;
+    }
+
+    unsigned tail = queueTail.load(memory_order_relaxed);
+    if (tail - queueHead.load(memory_order_acquire) >= (unsigned)AUDIO_QUEUE_SIZE) {
+        droppedFull++;
+        return false;
+    }
+    SoundEvent &event = events[tail & (AUDIO_QUEUE_SIZE - 1)];
+    event.sound = sound;
+    event.volume = volume;
+    event.pitch = pitch;
+    queueTail.store(tail + 1, memory_order_release);
+    tickEvents++;
+
+    // Only wakes the thread; never waits for it
+    wakeCondition.notify_one();
+    return true;
+}
+
+void AudioBeginTick() {
+    tickEvents = 0;
+}
+
+AudioStats AudioGetStats() {
+    AudioStats stats = {postedEvents.load(), droppedFull.load(), droppedCap.load(), playedEvents.load(), stolenVoices.load()};
+    return stats;
+}
+
+void AudioStop() {
+    if (!running.load()) return;
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_one();
+    audioThread.join();
+    running = false;
+
+    for (int s = 0; s < soundCount; s++) {
+        for (int v = 0; v < VOICES_PER_SOUND && soundLoaded[s]; v++) UnloadSoundAlias(voices[s][v].alias);
+    }
+    soundCount = 0;
+}
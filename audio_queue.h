@@ -0,0 +1,42 @@
+#ifndef AUDIO_QUEUE_H
+#define AUDIO_QUEUE_H
+
+#include "game_assets.h"
+
+// Sound playback off the game thread. The game posts sound events into a
+// single-producer, single-consumer ring buffer; an audio thread drains it
+// and plays each event on one of several voices (raylib sound aliases
+// sharing the sample data), so rapid bounces overlap instead of cutting
+// each other off. Posting never takes a lock or touches the audio device:
+// when the ring is full or the tick's event cap is reached the event is
+// dropped.
+
+const int AUDIO_QUEUE_SIZE = 64;            // Power of two
+const int VOICES_PER_SOUND = 4;
+const int MAX_SOUND_EVENTS_PER_TICK = 3;
+const int MAX_AUDIO_SOUNDS = 8;
+
+struct AudioStats {
+    long long posted;
+    long long droppedFull;      // Ring buffer was full
+    long long droppedCap;       // Over MAX_SOUND_EVENTS_PER_TICK
+    long long played;
+    long long stolen;           // Played on a voice that was still sounding
+};
+
+// Creates the voices for loaded sounds (ids are indexes into assets) and
+// starts the audio thread. Call from the main thread once the sounds are ready.
+void AudioStart(const SoundAsset* assets, int count);
+
+// Game thread only. Volume and pitch scale the sound's own; false if dropped.
+bool AudioPost(int sound, float volume, float pitch);
+
+// Game thread only: starts a new per-tick event budget
+void AudioBeginTick();
+
+AudioStats AudioGetStats();
+
+// Plays what is queued, stops the thread and unloads the voices
+void AudioStop();
+
+#endif
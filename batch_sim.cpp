@@ -0,0 +1,278 @@
+#include "batch_sim.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Distance the ball must stay away from every wall and the paddle for a lane
+// to take the SIMD path. Any contact closer than this is left to SimStep.
+const float SAFE_MARGIN = 1.0f;
+
+static float* AllocLaneFloats(int count) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, BATCH_LANE_ALIGN * sizeof(float), count * sizeof(float)) != 0) abort();
+    memset(memory, 0, count * sizeof(float));
+    return (float*)memory;
+}
+
+static int* AllocLaneInts(int count) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, BATCH_LANE_ALIGN * sizeof(int), count * sizeof(int)) != 0) abort();
+    memset(memory, 0, count * sizeof(int));
+    return (int*)memory;
+}
+
+void BatchInit(BatchSim &batch, int lanes, float deadZone) {
+    batch.capacity = (lanes + BATCH_LANE_ALIGN - 1) / BATCH_LANE_ALIGN * BATCH_LANE_ALIGN;
+    batch.lanes = batch.capacity;
+    batch.deadZone = deadZone;
+    batch.ballX = AllocLaneFloats(batch.capacity);
+    batch.ballY = AllocLaneFloats(batch.capacity);
+    batch.ballVelocityX = AllocLaneFloats(batch.capacity);
+    batch.ballVelocityY = AllocLaneFloats(batch.capacity);
+    batch.paddleY = AllocLaneFloats(batch.capacity);
+    batch.aimOffset = AllocLaneFloats(batch.capacity);
+    batch.score = AllocLaneInts(batch.capacity);
+    batch.gameOver = AllocLaneInts(batch.capacity);
+    batch.tick = AllocLaneInts(batch.capacity);
+
+    // Lanes start idle until a match is loaded into them
+    for (int i = 0; i < batch.capacity; i++) batch.gameOver[i] = 1;
+}
+
+void BatchFree(BatchSim &batch) {
+    free(batch.ballX);
+    free(batch.ballY);
+    free(batch.ballVelocityX);
+    free(batch.ballVelocityY);
+    free(batch.paddleY);
+    free(batch.aimOffset);
+    free(batch.score);
+    free(batch.gameOver);
+    free(batch.tick);
+    batch.capacity = 0;
+    batch.lanes = 0;
+}
+
+void BatchLoadLane(const BatchSim &batch, int lane, GameSimState &state) {
+    state.ballX = batch.ballX[lane];
+    state.ballY = batch.ballY[lane];
+    state.ballVelocityX = batch.ballVelocityX[lane];
+    state.ballVelocityY = batch.ballVelocityY[lane];
+    state.paddleY = batch.paddleY[lane];
+    state.score = batch.score[lane];
+    state.gameOver = batch.gameOver[lane] != 0;
+    state.tick = batch.tick[lane];
+}
+
+void BatchStoreLane(BatchSim &batch, int lane, const GameSimState &state) {
+    batch.ballX[lane] = state.ballX;
+    batch.ballY[lane] = state.ballY;
+    batch.ballVelocityX[lane] = state.ballVelocityX;
+    batch.ballVelocityY[lane] = state.ballVelocityY;
+    batch.paddleY[lane] = state.paddleY;
+    batch.score[lane] = state.score;
+    batch.gameOver[lane] = state.gameOver ? 1 : 0;
+    batch.tick[lane] = (int)state.tick;
+}
+
+void BatchMoveLane(BatchSim &batch, int from, int to) {
+    GameSimState state;
+    BatchLoadLane(batch, from, state);
+    BatchStoreLane(batch, to, state);
+    batch.aimOffset[to] = batch.aimOffset[from];
+}
+
+void BatchResetLane(BatchSim &batch, int lane, float ballSpeed, float aimOffset) {
+    GameSimState state;
+    SimReset(state, ballSpeed);
+    BatchStoreLane(batch, lane, state);
+    batch.aimOffset[lane] = aimOffset;
+}
+
+// One full SimStep for a single lane
+static void StepLane(BatchSim &batch, int lane, float deltaTime) {
+    GameSimState state;
+    BatchLoadLane(batch, lane, state);
+    PaddleAI ai = {batch.aimOffset[lane], batch.deadZone};
+    SimStep(state, PaddleAIInput(ai, state), deltaTime);
+    BatchStoreLane(batch, lane, state);
+}
+
+static void BatchStepScalar(BatchSim &batch, float deltaTime, int maxTicks) {
+    for (int i = 0; i < batch.lanes; i++) {
+        if (!batch.gameOver[i] && batch.tick[i] < maxTicks) StepLane(batch, i, deltaTime);
+    }
+}
+
+#if defined(__SSE2__)
+static inline __m128 Select4(__m128 mask, __m128 whenTrue, __m128 whenFalse) {
+    return _mm_or_ps(_mm_and_ps(mask, whenTrue), _mm_andnot_ps(mask, whenFalse));
+}
+
+static void BatchStepSSE(BatchSim &batch, float deltaTime, int maxTicks) {
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 radius = _mm_set1_ps((float)ballRadius);
+    const __m128 margin = _mm_set1_ps(SAFE_MARGIN);
+    const __m128 bottomLimit = _mm_set1_ps(screenHeight - SAFE_MARGIN);
+    const __m128 rightLimit = _mm_set1_ps(screenWidth - SAFE_MARGIN);
+    const __m128 paddleLimit = _mm_set1_ps(paddleX + paddleWidth + SAFE_MARGIN);
+    const __m128 halfPaddle = _mm_set1_ps(paddleHeight / 2.0f);
+    const __m128 deadZone = _mm_set1_ps(batch.deadZone);
+    const __m128 paddleStep = _mm_set1_ps(paddleSpeed * deltaTime);
+    const __m128 paddleMaxY = _mm_set1_ps((float)(screenHeight - paddleHeight));
+    const __m128i maxTick = _mm_set1_epi32(maxTicks);
+    const __m128i zeroInt = _mm_setzero_si128();
+
+    for (int i = 0; i < batch.lanes; i += 4) {
+        __m128i over = _mm_load_si128((const __m128i*)(batch.gameOver + i));
+        __m128i tick = _mm_load_si128((const __m128i*)(batch.tick + i));
+        __m128 active = _mm_castsi128_ps(_mm_and_si128(_mm_cmpeq_epi32(over, zeroInt), _mm_cmpgt_epi32(maxTick, tick)));
+        if (_mm_movemask_ps(active) == 0) continue;
+
+        __m128 x = _mm_load_ps(batch.ballX + i);
+        __m128 y = _mm_load_ps(batch.ballY + i);
+        __m128 vx = _mm_load_ps(batch.ballVelocityX + i);
+        __m128 vy = _mm_load_ps(batch.ballVelocityY + i);
+        __m128 py = _mm_load_ps(batch.paddleY + i);
+
+        // PaddleAI input, taken from the state before the step
+        __m128 target = _mm_sub_ps(y, _mm_load_ps(batch.aimOffset + i));
+        __m128 center = _mm_add_ps(py, halfPaddle);
+        __m128 up = _mm_cmplt_ps(target, _mm_sub_ps(center, deadZone));
+        __m128 down = _mm_cmpgt_ps(target, _mm_add_ps(center, deadZone));
+
+        // Ball moves freely when it ends the tick clear of the walls and the paddle
+        __m128 endX = _mm_add_ps(x, _mm_mul_ps(vx, dt));
+        __m128 endY = _mm_add_ps(y, _mm_mul_ps(vy, dt));
+        __m128 safe = _mm_and_ps(_mm_cmpgt_ps(_mm_sub_ps(endY, radius), margin),
+                                 _mm_cmplt_ps(_mm_add_ps(endY, radius), bottomLimit));
+        safe = _mm_and_ps(safe, _mm_cmplt_ps(_mm_add_ps(endX, radius), rightLimit));
+        safe = _mm_and_ps(safe, _mm_or_ps(_mm_cmpgt_ps(vx, zero),
+                                          _mm_cmpgt_ps(_mm_sub_ps(endX, radius), paddleLimit)));
+
+        // Paddle movement with boundary checking
+        __m128 newPy = Select4(up, _mm_max_ps(zero, _mm_sub_ps(py, paddleStep)), py);
+        newPy = Select4(down, _mm_min_ps(paddleMaxY, _mm_add_ps(py, paddleStep)), newPy);
+
+        __m128 fast = _mm_and_ps(active, safe);
+        _mm_store_ps(batch.ballX + i, Select4(fast, endX, x));
+        _mm_store_ps(batch.ballY + i, Select4(fast, endY, y));
+        _mm_store_ps(batch.paddleY + i, Select4(fast, newPy, py));
+        _mm_store_si128((__m128i*)(batch.tick + i), _mm_sub_epi32(tick, _mm_castps_si128(fast)));
+
+        int slow = _mm_movemask_ps(_mm_andnot_ps(safe, active));
+        for (int lane = 0; slow != 0; lane++, slow >>= 1) {
+            if (slow & 1) StepLane(batch, i + lane, deltaTime);
+        }
+    }
+}
+#endif
+
+#if defined(__AVX2__)
+static void BatchStepAVX2(BatchSim &batch, float deltaTime, int maxTicks) {
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 radius = _mm256_set1_ps((float)ballRadius);
+    const __m256 margin = _mm256_set1_ps(SAFE_MARGIN);
+    const __m256 bottomLimit = _mm256_set1_ps(screenHeight - SAFE_MARGIN);
+    const __m256 rightLimit = _mm256_set1_ps(screenWidth - SAFE_MARGIN);
+    const __m256 paddleLimit = _mm256_set1_ps(paddleX + paddleWidth + SAFE_MARGIN);
+    const __m256 halfPaddle = _mm256_set1_ps(paddleHeight / 2.0f);
+    const __m256 deadZone = _mm256_set1_ps(batch.deadZone);
+    const __m256 paddleStep = _mm256_set1_ps(paddleSpeed * deltaTime);
+    const __m256 paddleMaxY = _mm256_set1_ps((float)(screenHeight - paddleHeight));
+    const __m256i maxTick = _mm256_set1_epi32(maxTicks);
+    const __m256i zeroInt = _mm256_setzero_si256();
+
+    for (int i = 0; i < batch.lanes; i += 8) {
+        __m256i over = _mm256_load_si256((const __m256i*)(batch.gameOver + i));
+        __m256i tick = _mm256_load_si256((const __m256i*)(batch.tick + i));
+        __m256 active = _mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpeq_epi32(over, zeroInt), _mm256_cmpgt_epi32(maxTick, tick)));
+        if (_mm256_movemask_ps(active) == 0) continue;
+
+        __m256 x = _mm256_load_ps(batch.ballX + i);
+        __m256 y = _mm256_load_ps(batch.ballY + i);
+        __m256 vx = _mm256_load_ps(batch.ballVelocityX + i);
+        __m256 vy = _mm256_load_ps(batch.ballVelocityY + i);
+        __m256 py = _mm256_load_ps(batch.paddleY + i);
+
+        // PaddleAI input, taken from the state before the step
+        __m256 target = _mm256_sub_ps(y, _mm256_load_ps(batch.aimOffset + i));
+        __m256 center = _mm256_add_ps(py, halfPaddle);
+        __m256 up = _mm256_cmp_ps(target, _mm256_sub_ps(center, deadZone), _CMP_LT_OQ);
+        __m256 down = _mm256_cmp_ps(target, _mm256_add_ps(center, deadZone), _CMP_GT_OQ);
+
+        // Ball moves freely when it ends the tick clear of the walls and the paddle
+        __m256 endX = _mm256_add_ps(x, _mm256_mul_ps(vx, dt));
+        __m256 endY = _mm256_add_ps(y, _mm256_mul_ps(vy, dt));
+        __m256 safe = _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(endY, radius), margin, _CMP_GT_OQ),
+                                    _mm256_cmp_ps(_mm256_add_ps(endY, radius), bottomLimit, _CMP_LT_OQ));
+        safe = _mm256_and_ps(safe, _mm256_cmp_ps(_mm256_add_ps(endX, radius), rightLimit, _CMP_LT_OQ));
+        safe = _mm256_and_ps(safe, _mm256_or_ps(_mm256_cmp_ps(vx, zero, _CMP_GT_OQ),
+                                                _mm256_cmp_ps(_mm256_sub_ps(endX, radius), paddleLimit, _CMP_GT_OQ)));
+
+        // Paddle movement with boundary checking
+        __m256 newPy = _mm256_blendv_ps(py, _mm256_max_ps(zero, _mm256_sub_ps(py, paddleStep)), up);
+        newPy = _mm256_blendv_ps(newPy, _mm256_min_ps(paddleMaxY, _mm256_add_ps(py, paddleStep)), down);
+
+        __m256 fast = _mm256_and_ps(active, safe);
+        _mm256_store_ps(batch.ballX + i, _mm256_blendv_ps(x, endX, fast));
+        _mm256_store_ps(batch.ballY + i, _mm256_blendv_ps(y, endY, fast));
+        _mm256_store_ps(batch.paddleY + i, _mm256_blendv_ps(py, newPy, fast));
+        _mm256_store_si256((__m256i*)(batch.tick + i), _mm256_sub_epi32(tick, _mm256_castps_si256(fast)));
+
+        int slow = _mm256_movemask_ps(_mm256_andnot_ps(safe, active));
+        for (int lane = 0; slow != 0; lane++, slow >>= 1) {
+            if (slow & 1) StepLane(batch, i + lane, deltaTime);
+        }
+    }
+}
+#endif
+
+void BatchStep(BatchSim &batch, float deltaTime, int maxTicks, BatchPath path) {
+    switch (path) {
+#if defined(__AVX2__)
+        case BATCH_PATH_AVX2: BatchStepAVX2(batch, deltaTime, maxTicks); return;
+#endif
+#if defined(__SSE2__)
+        case BATCH_PATH_SSE: BatchStepSSE(batch, deltaTime, maxTicks); return;
+#endif
+        default: BatchStepScalar(batch, deltaTime, maxTicks); return;
+    }
+}
+
+bool BatchPathAvailable(BatchPath path) {
+    switch (path) {
+        case BATCH_PATH_SCALAR: return true;
+#if defined(__SSE2__)
+        case BATCH_PATH_SSE: return true;
+#endif
+#if defined(__AVX2__)
+        case BATCH_PATH_AVX2: return true;
+#endif
+        default: return false;
+    }
+}
+
+BatchPath BestBatchPath() {
+    if (BatchPathAvailable(BATCH_PATH_AVX2)) return BATCH_PATH_AVX2;
+    if (BatchPathAvailable(BATCH_PATH_SSE)) return BATCH_PATH_SSE;
+    return BATCH_PATH_SCALAR;
+}
+
+const char* BatchPathName(BatchPath path) {
+    switch (path) {
+        case BATCH_PATH_SSE: return "sse";
+        case BATCH_PATH_AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
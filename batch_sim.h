@@ -0,0 +1,51 @@
+#ifndef BATCH_SIM_H
+#define BATCH_SIM_H
+
+#include "game_sim.h"
+
+// Structure-of-arrays simulator that steps many independent matches at once.
+// Each lane is one match played by a PaddleAI. Lanes whose ball cannot touch
+// anything during the tick are advanced with SIMD; the rest go through
+// SimStep, so every lane stays bit-for-bit identical to the scalar rules.
+// Build without floating point contraction (-ffp-contract=off, the default
+// for -std=c++11) so the scalar path does not fuse multiply-adds.
+
+// Lane count is padded to a multiple of this, and arrays are aligned to it in bytes
+const int BATCH_LANE_ALIGN = 8;
+
+enum BatchPath {
+    BATCH_PATH_SCALAR,
+    BATCH_PATH_SSE,     // 4 lanes per instruction
+    BATCH_PATH_AVX2     // 8 lanes per instruction
+};
+
+struct BatchSim {
+    int capacity;           // Lanes allocated, a multiple of BATCH_LANE_ALIGN
+    int lanes;              // Lanes stepped by BatchStep, a multiple of BATCH_LANE_ALIGN up to capacity
+    float deadZone;         // PaddleAI dead zone shared by all lanes
+    float* ballX;
+    float* ballY;
+    float* ballVelocityX;
+    float* ballVelocityY;
+    float* paddleY;
+    float* aimOffset;       // PaddleAI aim offset per lane
+    int* score;
+    int* gameOver;          // 0 or 1; idle lanes are kept at 1
+    int* tick;
+};
+
+void BatchInit(BatchSim &batch, int lanes, float deadZone);
+void BatchFree(BatchSim &batch);
+void BatchResetLane(BatchSim &batch, int lane, float ballSpeed, float aimOffset);
+void BatchLoadLane(const BatchSim &batch, int lane, GameSimState &state);
+void BatchStoreLane(BatchSim &batch, int lane, const GameSimState &state);
+void BatchMoveLane(BatchSim &batch, int from, int to);
+
+// Advances every lane that is not over and has run fewer than maxTicks ticks
+void BatchStep(BatchSim &batch, float deltaTime, int maxTicks, BatchPath path);
+
+bool BatchPathAvailable(BatchPath path);
+BatchPath BestBatchPath();
+const char* BatchPathName(BatchPath path);
+
+#endif
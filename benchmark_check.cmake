@@ -0,0 +1,15 @@
+# Run by the benchmark_check target: compares the benchmarks against
+# BASELINE, or says how to record one when there is none yet.
+if(NOT EXISTS "${BASELINE}")
+    message(STATUS "No benchmark baseline at ${BASELINE}, skipping the check. Record one with:\n"
+                   "  ${BENCHMARKS} --json ${BASELINE}")
+    return()
+endif()
+execute_process(
+    COMMAND "${BENCHMARKS}" --json "${RESULTS}" --baseline "${BASELINE}"
+            --threshold "${THRESHOLD}" --repeat "${REPEAT}"
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Benchmarks regressed against ${BASELINE}")
+endif()
@@ -0,0 +1,823 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include "collision.h"
+#include "game_sim.h"
+#include "leaderboard.h"
+#include "score_store.h"
+#include "score_log.h"
+#include "score_view.h"
+#include "player_stats.h"
+#include "stress_field.h"
+#include <unistd.h>
+
+using namespace std;
+
+// Microbenchmarks for the game's hot paths. Build with optimizations, e.g.
+// g++ -O2 -std=c++11 -pthread benchmarks.cpp game_sim.cpp collision.cpp leaderboard.cpp score_store.cpp player_stats.cpp score_log.cpp score_view.cpp stress_field.cpp -o benchmarks
+// Pass section names (physics, collision, stress, leaderboard, gameover, history, playerstats) to run only those.
+// Every section runs --repeat times (default 5) and each result is the median
+// of the runs. --json FILE writes the results; --baseline FILE compares
+// against an earlier --json file and exits with 1 if any result got more than
+// --threshold percent (default 10) plus three times its spread worse, or if a
+// baseline result of a section that ran is missing.
+
+// Randomized ball states around the paddle, generated once per run
+struct CollisionCase {
+    float x, y, vx, vy, paddleY;
+};
+
+// Small deterministic generator so runs are comparable
+unsigned int benchSeed = 12345;
+float BenchRandom(float minValue, float maxValue) {
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+    return minValue + (maxValue - minValue) * ((benchSeed >> 8) / 16777216.0f);
+}
+
+double SecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// One number for the JSON output and the baseline comparison. With --repeat
+// the value is the median of the runs and spread is their median absolute
+// deviation, in percent of the median, which one slow run does not move.
+struct BenchResult {
+    string name;
+    double value;
+    string unit;
+    bool higherIsBetter;
+    double spread;
+    vector<double> samples;
+};
+
+vector<BenchResult> benchResults;
+
+void Record(const string &name, double value, const char* unit, bool higherIsBetter) {
+    for (size_t i = 0; i < benchResults.size(); i++) {
+        if (benchResults[i].name == name) {
+            benchResults[i].samples.push_back(value);
+            return;
+        }
+    }
+    BenchResult result = {name, value, unit, higherIsBetter, 0.0, vector<double>(1, value)};
+    benchResults.push_back(result);
+}
+
+double Median(vector<double> values) {
+    sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+// Turns the samples from every run into the median and the spread
+void SummarizeResults() {
+    for (size_t i = 0; i < benchResults.size(); i++) {
+        BenchResult &r = benchResults[i];
+        r.value = Median(r.samples);
+        vector<double> deviations;
+        for (size_t j = 0; j < r.samples.size(); j++) deviations.push_back(fabs(r.samples[j] - r.value));
+        r.spread = r.value > 0.0 ? Median(deviations) / r.value * 100.0 : 0.0;
+    }
+}
+
+// Steps through the runtime rules, as the game did before presets were compiled in
+struct GenericStep {
+    SimEvents operator()(GameSimState &state, const SimInput &input, float deltaTime) const {
+        return SimStep(state, input, deltaTime);
+    }
+    SimEvents operator()(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime) const {
+        return SimStepVersus(state, input, opponentInput, deltaTime);
+    }
+};
+
+// Steps through the rules compiled in, as the game does
+struct SpecializedStep {
+    SimEvents operator()(GameSimState &state, const SimInput &input, float deltaTime) const {
+        return SimStepRules<DefaultRules>(state, input, deltaTime);
+    }
+    SimEvents operator()(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime) const {
+        return SimStepVersusRules<DefaultRules>(state, input, opponentInput, deltaTime);
+    }
+};
+
+// Ticks/s of game after game with a computer paddle; state is left as the last tick left it
+template <class Step>
+double SoloTicksPerSecond(Step step, long long ticks, GameSimState &state, long long &games) {
+    const float tickTime = 1.0f / 240.0f;
+    PaddleAI ai = {10.0f, 2.0f};
+    SimReset(state, BALL_SPEED_MEDIUM);
+    games = 0;
+    long long sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long long t = 0; t < ticks; t++) {
+        SimEvents events = step(state, PaddleAIInput(ai, state), tickTime);
+        sink += events.wallBounces;
+        if (state.gameOver || state.tick >= 240 * 600) {
+            SimReset(state, BALL_SPEED_MEDIUM);
+            games++;
+        }
+    }
+    double elapsed = SecondsSince(start);
+    if (sink < 0) cout << sink;
+    return ticks / elapsed;
+}
+
+// Two-paddle ticks, with the predicting opponent deciding every tick
+template <class Step>
+double VersusTicksPerSecond(Step step, long long ticks, GameSimState &state, long long &games) {
+    const float tickTime = 1.0f / 240.0f;
+    PaddleAI ai = {10.0f, 2.0f};
+    PredictorAI opponent;
+    PredictorAIReset(opponent, OPPONENT_HARD, 240, 1);
+    SimReset(state, BALL_SPEED_MEDIUM, true);
+    games = 0;
+    long long sink = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long long t = 0; t < ticks; t++) {
+        SimEvents events = step(state, PaddleAIInput(ai, state), PredictorAIInput(opponent, state), tickTime);
+        sink += events.opponentHits;
+        if (state.gameOver || state.tick >= 240 * 600) {
+            SimReset(state, BALL_SPEED_MEDIUM, true);
+            games++;
+        }
+    }
+    double elapsed = SecondsSince(start);
+    if (sink < 0) cout << sink;
+    return ticks / elapsed;
+}
+
+const char* SameState(const GameSimState &a, const GameSimState &b) {
+    bool same = memcmp(&a.ballX, &b.ballX, sizeof(float)) == 0 && memcmp(&a.ballY, &b.ballY, sizeof(float)) == 0
+             && memcmp(&a.ballVelocityX, &b.ballVelocityX, sizeof(float)) == 0
+             && memcmp(&a.ballVelocityY, &b.ballVelocityY, sizeof(float)) == 0
+             && memcmp(&a.paddleY, &b.paddleY, sizeof(float)) == 0 && memcmp(&a.opponentY, &b.opponentY, sizeof(float)) == 0
+             && a.score == b.score && a.gameOver == b.gameOver && a.tick == b.tick;
+    return same ? "same final state" : "FINAL STATE DIFFERS";
+}
+
+// Game ticks with a computer paddle, the work UpdateGame does each tick
+// minus input and sound, through the runtime rules (step) and through the
+// compiled-in rules (step_specialized)
+void BenchPhysics() {
+    const long long ticks = 20000000;
+    GameSimState state, specialized;
+    long long games = 0;
+
+    double rate = SoloTicksPerSecond(GenericStep(), ticks, state, games);
+    cout << "physics/step        " << rate / 1e6 << " M ticks/s  (" << games << " games)" << endl;
+    Record("physics/step", rate, "ticks/s", true);
+    rate = SoloTicksPerSecond(SpecializedStep(), ticks, specialized, games);
+    cout << "physics/step_specialized " << rate / 1e6 << " M ticks/s  (" << SameState(state, specialized) << ")" << endl;
+    Record("physics/step_specialized", rate, "ticks/s", true);
+
+    rate = VersusTicksPerSecond(GenericStep(), ticks, state, games);
+    cout << "physics/versus      " << rate / 1e6 << " M ticks/s  (" << games << " games)" << endl;
+    Record("physics/versus", rate, "ticks/s", true);
+    rate = VersusTicksPerSecond(SpecializedStep(), ticks, specialized, games);
+    cout << "physics/versus_specialized " << rate / 1e6 << " M ticks/s  (" << SameState(state, specialized) << ")" << endl;
+    Record("physics/versus_specialized", rate, "ticks/s", true);
+
+    // The opponent's decision on its own: one analytic intercept
+    const int predictions = 10000000;
+    float predicted = 0.0f;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    state.ballVelocityX = BALL_SPEED_MEDIUM;
+    for (int i = 0; i < predictions; i++) {
+        state.ballVelocityY = (float)(i % 2001 - 1000);
+        predicted += PredictBallY(state, opponentX - ballRadius);
+    }
+    double elapsed = SecondsSince(start);
+    cout << "physics/predict     " << elapsed * 1e9 / predictions << " ns/call" << (predicted == 0.5f ? " " : "") << endl;
+    Record("physics/predict", elapsed * 1e9 / predictions, "ns", false);
+}
+
+// Milliseconds per stress mode step with this many balls, after the field has settled
+double StressStepMs(StressField &field, int balls) {
+    const float stepTime = 1.0f / 120.0f;
+    SimInput input = {false, false, 0};
+    field.count = 0;
+    field.particleCount = 0;
+    StressSetCount(field, balls, 200.0f);
+    for (int i = 0; i < 30; i++) StressStep(field, input, stepTime);
+
+    int steps = (int)(2000000LL / balls) + 10;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) StressStep(field, input, stepTime);
+    return SecondsSince(start) * 1000.0 / steps;
+}
+
+void BenchStress() {
+    const int maxBalls = 200000;
+    StressField field;
+    StressInit(field, maxBalls, 65536, 12345);
+
+    const int counts[] = {1000, 10000, 50000};
+    for (int i = 0; i < 3; i++) {
+        double ms = StressStepMs(field, counts[i]);
+        printf("stress/step_%-7d %.3f ms/step  (%d particles)\n", counts[i], ms, field.particleCount);
+        Record("stress/step_" + to_string(counts[i]), ms, "ms", false);
+    }
+
+    // Most balls whose physics fits in a 120 FPS frame: double until a step
+    // misses, then bisect. Drawing is not included; the game's auto stress mode measures both.
+    const double budgetMs = 1000.0 / 120.0;
+    int holds = 0, misses = 0, balls = 1000;
+    while (true) {
+        if (StressStepMs(field, balls) <= budgetMs) holds = balls;
+        else misses = balls;
+        if (misses == 0 ? balls >= maxBalls : misses - holds <= max(16, holds / 32)) break;
+        balls = misses == 0 ? min(balls * 2, maxBalls) : (holds + misses) / 2;
+    }
+    cout << "stress/balls_120fps  " << holds << " balls" << endl;
+    Record("stress/balls_120fps", holds, "balls", true);
+    StressFree(field);
+}
+
+void BenchCollision() {
+    const int caseCount = 4096;
+    const int rounds = 2000;
+    const float tickTime = 1.0f / 240.0f;
+
+    vector<CollisionCase> cases(caseCount);
+    for (int i = 0; i < caseCount; i++) {
+        cases[i].x = BenchRandom(0.0f, 200.0f);
+        cases[i].y = BenchRandom(0.0f, (float)screenHeight);
+        cases[i].vx = BenchRandom(-5000.0f, 5000.0f);
+        cases[i].vy = BenchRandom(-5000.0f, 5000.0f);
+        cases[i].paddleY = BenchRandom(0.0f, (float)(screenHeight - paddleHeight));
+    }
+
+    // Current discrete check: move, then test for overlap
+    int hits = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < caseCount; i++) {
+            const CollisionCase &c = cases[i];
+            float x = c.x + c.vx * tickTime;
+            float y = c.y + c.vy * tickTime;
+            hits += CircleOverlapsRect(x, y, ballRadius, paddleX, c.paddleY, paddleWidth, paddleHeight);
+        }
+    }
+    double discreteTime = SecondsSince(start);
+    int discreteHits = hits;
+
+    // Swept check: exact time of impact within the tick
+    hits = 0;
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < caseCount; i++) {
+            const CollisionCase &c = cases[i];
+            float t = SweepCircleRect(c.x, c.y, c.vx, c.vy, ballRadius,
+                                      paddleX, c.paddleY, paddleWidth, paddleHeight, tickTime);
+            hits += t != NO_HIT;
+        }
+    }
+    double sweptTime = SecondsSince(start);
+    int sweptHits = hits;
+
+    double calls = (double)caseCount * rounds;
+    cout << "collision/discrete  " << discreteTime * 1e9 / calls << " ns/call  (" << discreteHits / rounds << " hits per " << caseCount << ")" << endl;
+    cout << "collision/swept     " << sweptTime * 1e9 / calls << " ns/call  (" << sweptHits / rounds << " hits per " << caseCount << ")" << endl;
+    Record("collision/discrete", calls / discreteTime, "checks/s", true);
+    Record("collision/swept", calls / sweptTime, "checks/s", true);
+}
+
+// Copies of the original fixed-array leaderboard code, kept as the baseline
+void LegacySortLeaderboard(char (*names)[MAX_NAME_LENGTH], int* scores, int size) {
+    for (int i = 0; i < size - 1; i++) {
+        for (int j = 0; j < size - i - 1; j++) {
+            if (scores[j] < scores[j + 1]) {
+                int tempScore = scores[j];
+                scores[j] = scores[j + 1];
+                scores[j + 1] = tempScore;
+
+                char tempName[MAX_NAME_LENGTH];
+                strcpy(tempName, names[j]);
+                strcpy(names[j], names[j + 1]);
+                strcpy(names[j + 1], tempName);
+            }
+        }
+    }
+}
+
+int LegacyFindNameIndex(char (*names)[MAX_NAME_LENGTH], const char* name, int size) {
+    for (int i = 0; i < size; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Name of the player who played game i; about ten games per player
+void BenchPlayerName(char* name, int game, int entries) {
+    snprintf(name, MAX_NAME_LENGTH, "player%d", game % (entries / 10 + 1));
+}
+
+void BenchLeaderboard(int entries) {
+    const int queries = 100000;
+    char name[MAX_NAME_LENGTH];
+    long long sink = 0;
+
+    vector<int> scores(entries);
+    for (int i = 0; i < entries; i++) scores[i] = (int)BenchRandom(0.0f, 1000.0f);
+
+    // Fixed arrays: bubble sort is quadratic, so only small sizes are timed
+    // and larger ones are extrapolated from them
+    const int maxLegacySort = 10000;
+    int legacySize = entries < maxLegacySort ? entries : maxLegacySort;
+    char (*legacyNames)[MAX_NAME_LENGTH] = new char[entries][MAX_NAME_LENGTH];
+    int* legacyScores = new int[entries];
+    for (int i = 0; i < entries; i++) {
+        BenchPlayerName(legacyNames[i], i, entries);
+        legacyScores[i] = scores[i];
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    LegacySortLeaderboard(legacyNames, legacyScores, legacySize);
+    double legacySort = SecondsSince(start) * ((double)entries / legacySize) * ((double)entries / legacySize);
+
+    const int legacyQueries = 200;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < legacyQueries; q++) {
+        BenchPlayerName(name, q * 7919, entries);
+        sink += LegacyFindNameIndex(legacyNames, name, entries);
+    }
+    double legacyFind = SecondsSince(start) / legacyQueries;
+    delete[] legacyNames;
+    delete[] legacyScores;
+
+    // Indexed leaderboard, bulk loaded the way LoadLeaderboard does
+    Leaderboard board;
+    LeaderboardInit(board);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < entries; i++) {
+        BenchPlayerName(name, i, entries);
+        LeaderboardAppend(board, name, scores[i]);
+    }
+    LeaderboardRebuild(board);
+    double build = SecondsSince(start);
+
+    // Then single games added on top, the way the game submits scores
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        BenchPlayerName(name, q * 7919, entries);
+        LeaderboardAdd(board, name, q % 1000);
+    }
+    double insert = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += LeaderboardTopScore(board);
+    double top = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += LeaderboardRankForScore(board, q % 1000);
+    double rankForScore = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += LeaderboardRankOf(board, (int)(((long long)q * 7919) % entries));
+    double rankOf = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) sink += LeaderboardEntryAtRank(board, 1 + (int)(((long long)q * 7919) % entries));
+    double atRank = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        BenchPlayerName(name, q * 7919, entries);
+        sink += LeaderboardFindPlayer(board, name);
+    }
+    double find = SecondsSince(start) / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) LeaderboardSetScore(board, (int)(((long long)q * 7919) % entries), q % 1000);
+    double update = SecondsSince(start) / queries;
+
+    cout << "leaderboard n=" << entries << (sink == 42 ? " " : "") << endl;
+    cout << "  arrays   sort " << legacySort << " s" << (legacySize < entries ? " (extrapolated)" : "")
+         << ", find name " << legacyFind * 1e9 << " ns" << endl;
+    cout << "  indexed  load " << build << " s, insert " << insert * 1e9 << " ns"
+         << ", top " << top * 1e9 << " ns, rank of score " << rankForScore * 1e9 << " ns"
+         << ", rank of entry " << rankOf * 1e9 << " ns, entry at rank " << atRank * 1e9 << " ns"
+         << ", find name " << find * 1e9 << " ns, update " << update * 1e9 << " ns" << endl;
+
+    string prefix = "leaderboard/n=" + to_string(entries) + "/";
+    Record(prefix + "load", build * 1000.0, "ms", false);
+    Record(prefix + "insert", insert * 1e9, "ns", false);
+    Record(prefix + "rank_of_score", rankForScore * 1e9, "ns", false);
+    Record(prefix + "entry_at_rank", atRank * 1e9, "ns", false);
+    Record(prefix + "find_name", find * 1e9, "ns", false);
+    Record(prefix + "update", update * 1e9, "ns", false);
+}
+
+// The old text loader, kept to compare against the binary score log
+int LegacyLoadScoreFile(const char* path, Leaderboard &board) {
+    ifstream file(path);
+    LeaderboardClear(board);
+
+    string name;
+    int score;
+    while (file >> name >> score) {
+        LeaderboardAppend(board, name.c_str(), score);
+    }
+    LeaderboardRebuild(board);
+
+    return LeaderboardSize(board);
+}
+
+// Main-thread cost of the game-over frame: the old path re-read and sorted
+// scores.txt, the new one checks the in-memory leaderboard and queues the
+// write for the score store's worker thread. Also times loading the same
+// scores from text and from the binary log.
+void BenchGameOver(int entries) {
+    const char* textPath = "bench_scores.txt";
+    const char* logPath = "bench_scores.bin";
+    const int rounds = 1000;
+    {
+        ofstream file(textPath, ios::trunc);
+        char name[MAX_NAME_LENGTH];
+        for (int i = 0; i < entries; i++) {
+            BenchPlayerName(name, i, entries);
+            file << name << " " << (int)BenchRandom(0.0f, 1000.0f) << "\n";
+        }
+    }
+    remove(logPath);
+
+    Leaderboard board;
+    LeaderboardInit(board);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    LegacyLoadScoreFile(textPath, board);
+    bool high = LeaderboardTopScore(board) < 500;
+    double reload = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    ImportTextScores(textPath, logPath);
+    double import = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    LoadScoreLog(logPath, board);
+    double logLoad = SecondsSince(start);
+
+    ScoreLogView history;
+    ScoreLogViewInit(history);
+    LeaderboardClear(board);
+    ScoreStoreStart(logPath, textPath);
+    while (!ScoreStorePoll(history)) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        high = high != (RankedScoreCount(history, board) == 0 || 500 > RankedTopScore(history, board));
+        ScoreStoreSubmit(board, "bench", r % 1000);
+    }
+    double inMemory = SecondsSince(start) / rounds;
+    ScoreStoreStop();
+    ScoreLogViewClose(history);
+
+    // What the worker pays per save: one record appended and synced
+    const int appends = 50;
+    int fd = OpenScoreLogForAppend(logPath);
+    ScoreRecord record;
+    MakeScoreRecord(record, "bench", 500, 0);
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < appends && fd >= 0; r++) AppendScoreRecords(fd, &record, 1);
+    double append = SecondsSince(start) / appends;
+    if (fd >= 0) close(fd);
+    remove(textPath);
+    remove(logPath);
+
+    cout << "gameover n=" << entries << (high ? "" : " ") << "  reload file " << reload * 1000.0 << " ms"
+         << ", in-memory check + queued save " << inMemory * 1e6 << " us" << endl;
+    cout << "  import text " << import * 1000.0 << " ms, load binary log " << logLoad * 1000.0 << " ms"
+         << ", synced append " << append * 1000.0 << " ms" << endl;
+
+    string prefix = "gameover/n=" + to_string(entries) + "/";
+    Record(prefix + "queued_save", inMemory * 1e6, "us", false);
+    Record(prefix + "load_log", logLoad * 1000.0, "ms", false);
+    Record(prefix + "synced_append", append * 1000.0, "ms", false);
+}
+
+// Per-player stats kept up as games end, against working them out from
+// every game on record the way the score log alone would have to
+void BenchPlayerStats(int games) {
+    const int queries = 100000;
+    const int scans = 20;
+    char name[MAX_NAME_LENGTH];
+    long long sink = 0;
+
+    vector<ScoreRecord> history(games);
+    for (int i = 0; i < games; i++) {
+        BenchPlayerName(name, i, games);
+        MakeScoreRecord(history[i], name, (int)BenchRandom(0.0f, 1000.0f), 0);
+    }
+
+    PlayerStatsTable stats;
+    PlayerStatsInit(stats);
+    GameSummary game = {0, 0, 0.0f};
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < games; i++) {
+        game.score = history[i].score;
+        game.longestRally = history[i].score / 10;
+        game.maxBallSpeed = 600.0f + history[i].score;
+        PlayerStatsAdd(stats, history[i].name, game);
+    }
+    double add = SecondsSince(start) / games;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        BenchPlayerName(name, q * 7919, games);
+        PlayerSummary summary = PlayerStatsSummary(stats, name);
+        sink += summary.games + (long long)summary.percentile;
+    }
+    double summary = SecondsSince(start) / queries;
+
+    // From history: the player's games, then every game below their best
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < scans; q++) {
+        BenchPlayerName(name, q * 7919, games);
+        int best = -1;
+        long long played = 0, below = 0;
+        for (int i = 0; i < games; i++) {
+            if (strcmp(history[i].name, name) != 0) continue;
+            played++;
+            if (history[i].score > best) best = history[i].score;
+        }
+        for (int i = 0; i < games; i++) below += history[i].score < best;
+        sink += played + below;
+    }
+    double recompute = SecondsSince(start) / scans;
+
+    cout << "playerstats n=" << games << (sink == 42 ? " " : "") << "  add game " << add * 1e9 << " ns"
+         << ", summary " << summary * 1e9 << " ns, recompute from history " << recompute * 1e6 << " us" << endl;
+
+    string prefix = "playerstats/n=" + to_string(games) + "/";
+    Record(prefix + "add", add * 1e9, "ns", false);
+    Record(prefix + "summary", summary * 1e9, "ns", false);
+    Record(prefix + "recompute", recompute * 1e6, "us", false);
+}
+
+// Resident memory, and how much of it is file pages mapped from disk
+// (shared with the page cache and dropped first under memory pressure)
+double ResidentMegabytes(double* fileBacked) {
+    long pages = 0, resident = 0, shared = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld %ld", &pages, &resident, &shared) != 3) resident = shared = 0;
+        fclose(statm);
+    }
+    double megabytes = sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+    if (fileBacked) *fileBacked = shared * megabytes;
+    return resident * megabytes;
+}
+
+// Startup with a long score history: mapping the log and showing the first
+// leaderboard page, against loading every record into a Leaderboard. Run
+// the mapped view first so the loader's freed memory does not count.
+void BenchHistory(int entries) {
+    const char* path = "bench_history.bin";
+    const int pageRows = 20;
+    {
+        vector<ScoreRecord> records(entries);
+        char name[MAX_NAME_LENGTH];
+        for (int i = 0; i < entries; i++) {
+            BenchPlayerName(name, i, entries);
+            MakeScoreRecord(records[i], name, (int)BenchRandom(0.0f, 100000.0f), 0);
+        }
+        WriteScoreLog(path, &records[0], entries);
+    }
+
+    double baselineFile;
+    double baseline = ResidentMegabytes(&baselineFile);
+    ScoreLogView history;
+    ScoreLogViewInit(history);
+    Leaderboard recent;
+    LeaderboardInit(recent);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ScoreLogViewOpen(history, path);
+    double mapTime = SecondsSince(start);
+    double mapResident = ResidentMegabytes(NULL) - baseline;
+
+    start = chrono::steady_clock::now();
+    long long sink = 0;
+    for (int rank = 1; rank <= pageRows; rank++) {
+        const char* name;
+        int score;
+        if (RankedScoreAt(history, recent, rank, name, score)) sink += score + name[0];
+    }
+    double firstPage = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (int rank = 1; rank <= pageRows; rank++) {
+        const char* name;
+        int score;
+        if (RankedScoreAt(history, recent, rank, name, score)) sink += score + name[0];
+    }
+    double nextPage = SecondsSince(start);
+    double viewFile;
+    double viewResident = ResidentMegabytes(&viewFile) - baseline;
+    viewFile -= baselineFile;
+    ScoreLogViewClose(history);
+
+    baseline = ResidentMegabytes(NULL);
+    Leaderboard board;
+    LeaderboardInit(board);
+    start = chrono::steady_clock::now();
+    LoadScoreLog(path, board);
+    double loadTime = SecondsSince(start);
+    double loadResident = ResidentMegabytes(NULL) - baseline;
+    for (int rank = 1; rank <= pageRows; rank++) sink += LeaderboardScore(board, LeaderboardEntryAtRank(board, rank));
+    LeaderboardClear(board);
+    remove(path);
+
+    cout << "history n=" << entries << (sink ? "" : " ") << "  mapped: open " << mapTime * 1000.0 << " ms ("
+         << mapResident << " MB), first page " << firstPage * 1000.0 << " ms, next page " << nextPage * 1e6
+         << " us, resident " << viewResident << " MB (" << viewFile << " MB mapped file)" << endl;
+    cout << "  loaded into Leaderboard: " << loadTime * 1000.0 << " ms, resident " << loadResident << " MB" << endl;
+
+    string prefix = "history/n=" + to_string(entries) + "/";
+    Record(prefix + "open", mapTime * 1000.0, "ms", false);
+    Record(prefix + "first_page", firstPage * 1000.0, "ms", false);
+    Record(prefix + "load_all", loadTime * 1000.0, "ms", false);
+}
+
+// One result per line, so a baseline can be read back without a JSON parser
+bool WriteResultsJson(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < benchResults.size(); i++) {
+        const BenchResult &r = benchResults[i];
+        fprintf(out, "    {\"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\", \"spread\": %.3g}%s\n",
+                r.name.c_str(), r.value, r.unit.c_str(), r.higherIsBetter ? "higher" : "lower", r.spread,
+                i + 1 < benchResults.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return fclose(out) == 0;
+}
+
+bool ReadResultsJson(const char* path, vector<BenchResult> &results) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        char name[256], unit[64], better[16];
+        double value;
+        double spread = 0.0;
+        size_t entry = line.find("{\"name\"");
+        if (entry == string::npos) continue;
+        // Files written before --repeat have no spread
+        if (sscanf(line.c_str() + entry, "{\"name\": \"%255[^\"]\", \"value\": %lf, \"unit\": \"%63[^\"]\", \"better\": \"%15[^\"]\", \"spread\": %lf",
+                   name, &value, unit, better, &spread) < 4) {
+            continue;
+        }
+        BenchResult result = {name, value, unit, strcmp(better, "higher") == 0, spread, vector<double>()};
+        results.push_back(result);
+    }
+    return true;
+}
+
+bool ShouldRun(const vector<string> &sections, const char* section) {
+    if (sections.empty()) return true;
+    for (size_t i = 0; i < sections.size(); i++) {
+        if (sections[i] == section) return true;
+    }
+    return false;
+}
+
+void RunSections(const vector<string> &sections) {
+    // Same cases every run
+    benchSeed = 12345;
+    if (ShouldRun(sections, "physics")) {
+        BenchPhysics();
+    }
+    if (ShouldRun(sections, "collision")) {
+        BenchCollision();
+    }
+    if (ShouldRun(sections, "stress")) {
+        BenchStress();
+    }
+    if (ShouldRun(sections, "leaderboard")) {
+        BenchLeaderboard(10000);
+        BenchLeaderboard(1000000);
+        BenchLeaderboard(10000000);
+    }
+    if (ShouldRun(sections, "gameover")) {
+        BenchGameOver(10000);
+        BenchGameOver(1000000);
+    }
+    if (ShouldRun(sections, "history")) {
+        BenchHistory(1000000);
+        BenchHistory(10000000);
+    }
+    if (ShouldRun(sections, "playerstats")) {
+        BenchPlayerStats(10000);
+        BenchPlayerStats(1000000);
+        BenchPlayerStats(10000000);
+    }
+}
+
+// Prints every result next to its baseline; returns how many regressed plus
+// how many baseline results of the sections that ran are missing. Each result
+// may get worse by the threshold plus three times the larger of its two
+// spreads, so noisy results need a bigger change to fail than steady ones.
+int CompareWithBaseline(const vector<BenchResult> &baseline, const vector<string> &sections, double thresholdPercent) {
+    int failures = 0;
+    printf("\n%-40s %14s %14s %8s %8s\n", "result", "baseline", "now", "change", "allowed");
+    for (size_t i = 0; i < benchResults.size(); i++) {
+        const BenchResult &now = benchResults[i];
+        const BenchResult* before = NULL;
+        for (size_t j = 0; j < baseline.size() && !before; j++) {
+            if (baseline[j].name == now.name) before = &baseline[j];
+        }
+        if (!before || before->value <= 0.0) {
+            printf("%-40s %14s %14.4g %8s\n", now.name.c_str(), "-", now.value, "new");
+            continue;
+        }
+
+        // Positive when worse, whichever direction is better
+        double change = (now.value - before->value) / before->value * 100.0;
+        double worse = now.higherIsBetter ? -change : change;
+        double allowed = thresholdPercent + 3.0 * max(before->spread, now.spread);
+        bool regressed = worse > allowed;
+        if (regressed) failures++;
+        printf("%-40s %14.4g %14.4g %+7.1f%% %7.1f%%%s\n", now.name.c_str(), before->value, now.value, change,
+               allowed, regressed ? "  REGRESSION" : "");
+    }
+
+    // A result that stopped being recorded would otherwise pass silently
+    for (size_t j = 0; j < baseline.size(); j++) {
+        const BenchResult &before = baseline[j];
+        string section = before.name.substr(0, before.name.find('/'));
+        if (!ShouldRun(sections, section.c_str())) continue;
+        bool found = false;
+        for (size_t i = 0; i < benchResults.size() && !found; i++) {
+            found = benchResults[i].name == before.name;
+        }
+        if (!found) {
+            failures++;
+            printf("%-40s %14.4g %14s %8s  MISSING\n", before.name.c_str(), before.value, "-", "");
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = NULL;
+    const char* baselinePath = NULL;
+    double thresholdPercent = 10.0;
+    int repeat = 5;
+    vector<string> sections;
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--json") == 0 && value) {
+            jsonPath = value;
+            i++;
+        } else if (strcmp(argv[i], "--baseline") == 0 && value) {
+            baselinePath = value;
+            i++;
+        } else if (strcmp(argv[i], "--threshold") == 0 && value) {
+            thresholdPercent = atof(value);
+            i++;
+        } else if (strcmp(argv[i], "--repeat") == 0 && value) {
+            repeat = max(1, atoi(value));
+            i++;
+        } else if (argv[i][0] == '-') {
+            cerr << "usage: " << argv[0] << " [--json FILE] [--baseline FILE] [--threshold PERCENT] [--repeat RUNS]"
+                 << " [physics] [collision] [stress] [leaderboard] [gameover] [history] [playerstats]" << endl;
+            return 1;
+        } else {
+            sections.push_back(argv[i]);
+        }
+    }
+    vector<BenchResult> baseline;
+    if (baselinePath && !ReadResultsJson(baselinePath, baseline)) {
+        cerr << "Could not read baseline " << baselinePath << endl;
+        return 1;
+    }
+
+    for (int run = 0; run < repeat; run++) {
+        if (repeat > 1) printf("\nrun %d of %d\n", run + 1, repeat);
+        RunSections(sections);
+    }
+    SummarizeResults();
+
+    if (jsonPath && !WriteResultsJson(jsonPath)) {
+        cerr << "Could not write " << jsonPath << endl;
+        return 1;
+    }
+    if (baselinePath) {
+        int failures = CompareWithBaseline(baseline, sections, thresholdPercent);
+        if (failures > 0) {
+            cerr << failures << " results worse than allowed or missing compared with " << baselinePath << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "collision.h"
+#include <cmath>
+
+using namespace std;
+
+bool CircleOverlapsRect(float cx, float cy, float radius, float rx, float ry, float rw, float rh) {
+    // Distance from the circle center to the closest point of the rectangle
+    float closestX = fmax(rx, fmin(cx, rx + rw));
+    float closestY = fmax(ry, fmin(cy, ry + rh));
+    float dx = cx - closestX;
+    float dy = cy - closestY;
+    return dx * dx + dy * dy <= radius * radius;
+}
+
+float SweepCircleWall(float pos, float vel, float radius, float wall, float maxTime) {
+    if (vel == 0.0f) return NO_HIT;
+
+    // Contact happens when the leading edge of the circle reaches the wall
+    float edge = vel < 0.0f ? pos - radius : pos + radius;
+    float t = (wall - edge) / vel;
+    if (t < 0.0f) return 0.0f;
+    if (t > maxTime) return NO_HIT;
+    return t;
+}
+
+// Earliest time in [0, maxTime] at which a moving point comes within radius of (kx, ky)
+static float SweepPointCircle(float px, float py, float vx, float vy, float kx, float ky, float radius, float maxTime) {
+    float dx = px - kx;
+    float dy = py - ky;
+    float a = vx * vx + vy * vy;
+    float b = dx * vx + dy * vy;
+    float c = dx * dx + dy * dy - radius * radius;
+
+    if (c <= 0.0f) return 0.0f;             // Already touching
+    if (b >= 0.0f || a == 0.0f) return NO_HIT;  // Moving away or not moving
+
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return NO_HIT;
+
+    float t = (-b - sqrt(disc)) / a;
+    if (t > maxTime) return NO_HIT;
+    return t < 0.0f ? 0.0f : t;
+}
+
+float SweepCircleRect(float cx, float cy, float vx, float vy, float radius,
+                      float rx, float ry, float rw, float rh, float maxTime) {
+    // Treat the circle as a point moving against the rectangle grown by the radius
+    float minX = rx - radius, maxX = rx + rw + radius;
+    float minY = ry - radius, maxY = ry + rh + radius;
+
+    // Cheap reject: the box covering the whole path misses the grown rectangle
+    float endX = cx + vx * maxTime;
+    float endY = cy + vy * maxTime;
+    if (fmax(cx, endX) < minX || fmin(cx, endX) > maxX) return NO_HIT;
+    if (fmax(cy, endY) < minY || fmin(cy, endY) > maxY) return NO_HIT;
+
+    if (CircleOverlapsRect(cx, cy, radius, rx, ry, rw, rh)) return 0.0f;
+
+    float tEnter = -INFINITY, tExit = INFINITY;
+    if (vx == 0.0f) {
+        if (cx < minX || cx > maxX) return NO_HIT;
+    } else {
+        float t1 = (minX - cx) / vx;
+        float t2 = (maxX - cx) / vx;
+        if (t1 > t2) { float tmp = t1; t1 = t2; t2 = tmp; }
+        tEnter = fmax(tEnter, t1);
+        tExit = fmin(tExit, t2);
+    }
+    if (vy == 0.0f) {
+        if (cy < minY || cy > maxY) return NO_HIT;
+    } else {
+        float t1 = (minY - cy) / vy;
+        float t2 = (maxY - cy) / vy;
+        if (t1 > t2) { float tmp = t1; t1 = t2; t2 = tmp; }
+        tEnter = fmax(tEnter, t1);
+        tExit = fmin(tExit, t2);
+    }
+    if (tEnter > tExit || tExit < 0.0f || tEnter > maxTime) return NO_HIT;
+    if (tEnter < 0.0f) tEnter = 0.0f;
+
+    // Entry point on the grown rectangle; if it lies beyond both edges of the
+    // real rectangle the contact is with a rounded corner instead
+    float hx = cx + vx * tEnter;
+    float hy = cy + vy * tEnter;
+    bool beyondX = hx < rx || hx > rx + rw;
+    bool beyondY = hy < ry || hy > ry + rh;
+    if (beyondX && beyondY) {
+        float kx = hx < rx ? rx : rx + rw;
+        float ky = hy < ry ? ry : ry + rh;
+        return SweepPointCircle(cx, cy, vx, vy, kx, ky, radius, maxTime);
+    }
+    return tEnter;
+}
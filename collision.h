@@ -0,0 +1,25 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+// Continuous (swept) collision helpers for the ball.
+// Everything here is plain float math with no raylib dependency, so the
+// same routines can be used by the game, headless tools and benchmarks.
+
+// Returned by the sweep functions when there is no contact within maxTime
+const float NO_HIT = -1.0f;
+
+// Discrete overlap test between a circle and an axis-aligned rectangle
+// (same result as raylib's CheckCollisionCircleRec).
+bool CircleOverlapsRect(float cx, float cy, float radius, float rx, float ry, float rw, float rh);
+
+// Time in [0, maxTime] at which a circle moving along one axis first touches
+// an axis-aligned wall, or NO_HIT. Returns 0 if the circle is already past it.
+float SweepCircleWall(float pos, float vel, float radius, float wall, float maxTime);
+
+// Time in [0, maxTime] at which a moving circle first touches a rectangle,
+// or NO_HIT. Returns 0 if the circle already overlaps the rectangle.
+// Handles the rounded corners of the swept shape exactly.
+float SweepCircleRect(float cx, float cy, float vx, float vy, float radius,
+                      float rx, float ry, float rw, float rh, float maxTime);
+
+#endif
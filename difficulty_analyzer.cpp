@@ -0,0 +1,284 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "game_sim.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Monte Carlo sweep over the difficulty constants. Every combination of
+// ball speed, paddle speed, bounce angle and AI reaction delay plays --games
+// games with a DelayedPaddleAI, spread over a work-stealing thread pool.
+// Results only depend on --seed, never on --threads. Example:
+//   ./difficulty_analyzer --games 100000 --paddle-speeds 350,450,550 --out sweep.csv
+
+// Highest score tracked individually in the histogram; higher scores share the last bucket
+const int MAX_TRACKED_SCORE = 200;
+
+// Games played by a single task
+const int GAMES_PER_TASK = 2000;
+
+struct AnalyzerOptions {
+    int games;              // Per parameter combination
+    int tickRate;
+    int threads;
+    unsigned int seed;
+    double maxGameSeconds;
+    vector<float> ballSpeeds;
+    vector<float> paddleSpeeds;
+    vector<float> bounceAngles;
+    vector<float> reactionSeconds;
+    float aimError;         // AI aim offset is drawn from +/- this fraction of half the paddle
+    string outPath;         // Summary CSV, stdout when empty
+    string histogramPath;   // Score distribution CSV, skipped when empty
+};
+
+// One point of the sweep
+struct SweepPoint {
+    float ballSpeed;
+    SimParams params;
+    float reactionSeconds;
+};
+
+// Totals for one task or one sweep point; all integers so merging is exact in any order
+struct SweepTotals {
+    long long games;
+    long long ticks;
+    long long scoreSum;
+    long long timedOut;
+    vector<long long> scoreCounts;  // Games per final score
+};
+
+vector<float> ParseList(const char* text) {
+    vector<float> values;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) values.push_back((float)atof(item.c_str()));
+    }
+    return values;
+}
+
+void PrintUsage() {
+    cout << "Usage: difficulty_analyzer [--games N] [--rate HZ] [--threads N] [--seed S] [--max-seconds T]" << endl;
+    cout << "                           [--ball-speeds a,b,..] [--paddle-speeds a,b,..] [--bounce-angles a,b,..]" << endl;
+    cout << "                           [--reaction-ms a,b,..] [--aim-error F] [--out FILE] [--histogram FILE]" << endl;
+}
+
+int ReactionTicks(float reactionSeconds, int tickRate) {
+    return (int)floorf(reactionSeconds * tickRate + 0.5f);
+}
+
+bool ParseOptions(int argc, char** argv, AnalyzerOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) return false;
+
+        if (strcmp(arg, "--games") == 0) options.games = atoi(value);
+        else if (strcmp(arg, "--rate") == 0) options.tickRate = atoi(value);
+        else if (strcmp(arg, "--threads") == 0) options.threads = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) options.seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--max-seconds") == 0) options.maxGameSeconds = atof(value);
+        else if (strcmp(arg, "--ball-speeds") == 0) options.ballSpeeds = ParseList(value);
+        else if (strcmp(arg, "--paddle-speeds") == 0) options.paddleSpeeds = ParseList(value);
+        else if (strcmp(arg, "--bounce-angles") == 0) options.bounceAngles = ParseList(value);
+        else if (strcmp(arg, "--aim-error") == 0) options.aimError = (float)atof(value);
+        else if (strcmp(arg, "--out") == 0) options.outPath = value;
+        else if (strcmp(arg, "--histogram") == 0) options.histogramPath = value;
+        else if (strcmp(arg, "--reaction-ms") == 0) {
+            options.reactionSeconds = ParseList(value);
+            for (size_t r = 0; r < options.reactionSeconds.size(); r++) options.reactionSeconds[r] /= 1000.0f;
+        }
+        else return false;
+        i++;
+    }
+    if (!(options.games > 0 && options.tickRate > 0 && options.threads > 0 && options.maxGameSeconds > 0
+          && !options.ballSpeeds.empty() && !options.paddleSpeeds.empty()
+          && !options.bounceAngles.empty() && !options.reactionSeconds.empty())) {
+        return false;
+    }
+
+    // The AI remembers MAX_REACTION_TICKS ticks of ball positions, so longer
+    // delays would be played as the longest one while reported as asked
+    for (size_t r = 0; r < options.reactionSeconds.size(); r++) {
+        int ticks = ReactionTicks(options.reactionSeconds[r], options.tickRate);
+        if (ticks < 0 || ticks >= MAX_REACTION_TICKS) {
+            cout << "Reaction delay " << options.reactionSeconds[r] * 1000.0f << " ms is outside 0 to "
+                 << (MAX_REACTION_TICKS - 1) * 1000.0f / options.tickRate << " ms at " << options.tickRate << " Hz" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Seed for one task, mixed from the run seed, sweep point and task index
+unsigned int TaskSeed(unsigned int seed, int point, int task) {
+    unsigned int h = seed ^ 0x9E3779B9u;
+    h = (h ^ (unsigned int)point) * 0x85EBCA6Bu;
+    h = (h ^ (h >> 13) ^ (unsigned int)task) * 0xC2B2AE35u;
+    return h ^ (h >> 16);
+}
+
+void PlayGames(const SweepPoint &point, const AnalyzerOptions &options, int games, unsigned int seed, SweepTotals &totals) {
+    const float tickTime = 1.0f / options.tickRate;
+    const long long maxTicks = (long long)(options.maxGameSeconds * options.tickRate);
+    const int reactionTicks = ReactionTicks(point.reactionSeconds, options.tickRate);
+
+    DelayedPaddleAI ai;
+    for (int g = 0; g < games; g++) {
+        GameSimState state;
+        SimReset(state, point.ballSpeed);
+
+        PaddleAI aim;
+        aim.aimOffset = SimRandomFloat(seed, -1.0f, 1.0f) * options.aimError * paddleHeight / 2.0f;
+        aim.deadZone = 2.0f;
+        DelayedPaddleAIReset(ai, aim, reactionTicks, state);
+
+        while (!state.gameOver && state.tick < maxTicks) {
+            SimStep(state, DelayedPaddleAIInput(ai, state), tickTime, point.params);
+        }
+
+        totals.games++;
+        totals.ticks += state.tick;
+        totals.scoreSum += state.score;
+        if (!state.gameOver) totals.timedOut++;
+        totals.scoreCounts[state.score < MAX_TRACKED_SCORE ? state.score : MAX_TRACKED_SCORE]++;
+    }
+}
+
+// Smallest score that at least fraction of the games did not exceed
+int ScorePercentile(const SweepTotals &totals, double fraction) {
+    long long needed = (long long)(fraction * totals.games + 0.5);
+    long long seen = 0;
+    for (int score = 0; score <= MAX_TRACKED_SCORE; score++) {
+        seen += totals.scoreCounts[score];
+        if (seen >= needed && seen > 0) return score;
+    }
+    return MAX_TRACKED_SCORE;
+}
+
+int main(int argc, char** argv) {
+    AnalyzerOptions options;
+    options.games = 100000;
+    options.tickRate = 240;
+    options.threads = (int)thread::hardware_concurrency();
+    if (options.threads < 1) options.threads = 1;
+    options.seed = 1;
+    options.maxGameSeconds = 300.0;
+    options.ballSpeeds.push_back(BALL_SPEED_SLOW);
+    options.ballSpeeds.push_back(BALL_SPEED_MEDIUM);
+    options.ballSpeeds.push_back(BALL_SPEED_FAST);
+    options.paddleSpeeds.push_back(paddleSpeed);
+    options.bounceAngles.push_back(DEFAULT_SIM_PARAMS.maxBounceAngle);
+    options.reactionSeconds.push_back(0.15f);
+    options.aimError = 1.0f;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+    // Expand the sweep grid
+    vector<SweepPoint> points;
+    for (size_t b = 0; b < options.ballSpeeds.size(); b++)
+        for (size_t p = 0; p < options.paddleSpeeds.size(); p++)
+            for (size_t a = 0; a < options.bounceAngles.size(); a++)
+                for (size_t r = 0; r < options.reactionSeconds.size(); r++) {
+                    SweepPoint point;
+                    point.ballSpeed = options.ballSpeeds[b];
+                    point.params = DEFAULT_SIM_PARAMS;
+                    point.params.paddleSpeed = options.paddleSpeeds[p];
+                    point.params.maxBounceAngle = options.bounceAngles[a];
+                    point.reactionSeconds = options.reactionSeconds[r];
+                    points.push_back(point);
+                }
+
+    // Fixed task layout: the split depends only on --games, so each task's seed
+    // and game list are the same whatever the thread count
+    const int tasksPerPoint = (options.games + GAMES_PER_TASK - 1) / GAMES_PER_TASK;
+    vector<SweepTotals> taskTotals(points.size() * tasksPerPoint);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.threads);
+        for (size_t p = 0; p < points.size(); p++) {
+            for (int t = 0; t < tasksPerPoint; t++) {
+                SweepTotals* totals = &taskTotals[p * tasksPerPoint + t];
+                const SweepPoint* point = &points[p];
+                int games = t == tasksPerPoint - 1 ? options.games - t * GAMES_PER_TASK : GAMES_PER_TASK;
+                unsigned int seed = TaskSeed(options.seed, (int)p, t);
+                const AnalyzerOptions* opts = &options;
+                pool.Submit([=] {
+                    SweepTotals local = {0, 0, 0, 0, vector<long long>(MAX_TRACKED_SCORE + 1, 0)};
+                    PlayGames(*point, *opts, games, seed, local);
+                    *totals = local;
+                });
+            }
+        }
+        pool.Wait();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Merge tasks in a fixed order
+    vector<SweepTotals> pointTotals(points.size());
+    long long allGames = 0, allTicks = 0;
+    for (size_t p = 0; p < points.size(); p++) {
+        SweepTotals &merged = pointTotals[p];
+        merged.games = merged.ticks = merged.scoreSum = merged.timedOut = 0;
+        merged.scoreCounts.assign(MAX_TRACKED_SCORE + 1, 0);
+        for (int t = 0; t < tasksPerPoint; t++) {
+            const SweepTotals &task = taskTotals[p * tasksPerPoint + t];
+            merged.games += task.games;
+            merged.ticks += task.ticks;
+            merged.scoreSum += task.scoreSum;
+            merged.timedOut += task.timedOut;
+            for (int s = 0; s <= MAX_TRACKED_SCORE; s++) merged.scoreCounts[s] += task.scoreCounts[s];
+        }
+        allGames += merged.games;
+        allTicks += merged.ticks;
+    }
+
+    // Summary CSV: one row per sweep point
+    ofstream outFile;
+    if (!options.outPath.empty()) outFile.open(options.outPath.c_str());
+    ostream &out = options.outPath.empty() ? cout : outFile;
+    out << "ball_speed,paddle_speed,bounce_angle,reaction_ms,games,mean_score,p50_score,p90_score,p99_score,max_score,"
+           "mean_rally_seconds,timed_out" << endl;
+    for (size_t p = 0; p < points.size(); p++) {
+        const SweepPoint &point = points[p];
+        const SweepTotals &totals = pointTotals[p];
+        int maxScore = 0;
+        for (int s = 0; s <= MAX_TRACKED_SCORE; s++) if (totals.scoreCounts[s] > 0) maxScore = s;
+        double meanScore = (double)totals.scoreSum / totals.games;
+
+        // A game ends on the first miss, so the score is the rally length in hits
+        out << point.ballSpeed << "," << point.params.paddleSpeed << "," << point.params.maxBounceAngle << ","
+            << point.reactionSeconds * 1000.0f << "," << totals.games << "," << meanScore << ","
+            << ScorePercentile(totals, 0.5) << "," << ScorePercentile(totals, 0.9) << "," << ScorePercentile(totals, 0.99) << ","
+            << maxScore << "," << (double)totals.ticks / totals.games / options.tickRate << ","
+            << totals.timedOut << endl;
+    }
+
+    // Histogram CSV: games per final score for each sweep point
+    if (!options.histogramPath.empty()) {
+        ofstream histogram(options.histogramPath.c_str());
+        histogram << "ball_speed,paddle_speed,bounce_angle,reaction_ms,score,games" << endl;
+        for (size_t p = 0; p < points.size(); p++) {
+            for (int s = 0; s <= MAX_TRACKED_SCORE; s++) {
+                if (pointTotals[p].scoreCounts[s] == 0) continue;
+                histogram << points[p].ballSpeed << "," << points[p].params.paddleSpeed << "," << points[p].params.maxBounceAngle << ","
+                          << points[p].reactionSeconds * 1000.0f << "," << s << "," << pointTotals[p].scoreCounts[s] << endl;
+            }
+        }
+    }
+
+    cerr << points.size() << " sweep points, " << allGames << " games, " << allTicks << " ticks in " << seconds << " s on "
+         << options.threads << " threads (" << allGames / seconds << " games/sec, " << allTicks / seconds << " ticks/sec)" << endl;
+    return 0;
+}
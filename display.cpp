@@ -0,0 +1,165 @@
+#include "display.h"
+#include "game_sim.h"
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+using namespace std;
+
+const double MIN_SPIN_MARGIN = 0.0002;  // Seconds
+const double MAX_SPIN_MARGIN = 0.004;
+
+DisplaySettings DefaultDisplaySettings() {
+    DisplaySettings settings = {screenWidth, screenHeight, false, false, 120, true};
+    return settings;
+}
+
+void DisplayInit(Display &display, const DisplaySettings &settings, const char* title) {
+    display.settings = settings;
+    unsigned int flags = FLAG_WINDOW_RESIZABLE;
+    if (settings.vsync) flags |= FLAG_VSYNC_HINT;
+    if (settings.fullscreen) flags |= FLAG_FULLSCREEN_MODE;
+    SetConfigFlags(flags);
+    InitWindow(settings.windowWidth, settings.windowHeight, title);
+    SetWindowMinSize(screenWidth / 4, screenHeight / 4);
+    SetTargetFPS(settings.targetFps);
+
+    display.targetLoaded = false;
+    display.direct = true;
+    display.windowWidth = display.windowHeight = 0;
+    display.frameMode = FRAME_ACTIVE;
+    display.wokeFromIdle = false;
+    display.nextPresent = 0.0;
+    display.spinMargin = 0.001;
+    display.lastPresent = 0.0;
+    display.presentErrorMs = 0.0;
+}
+
+static bool UsePacer(const Display &display) {
+    return display.frameMode == FRAME_GAMEPLAY && display.settings.precisePacing
+        && display.settings.targetFps > 0 && !display.settings.vsync;
+}
+
+// Raylib's frame limit and event waiting for the current mode and settings
+static void ApplyFrameMode(Display &display) {
+    int fps = display.settings.targetFps;
+    if (display.frameMode == FRAME_BACKGROUND && (fps == 0 || fps > BACKGROUND_FPS)) fps = BACKGROUND_FPS;
+    if (UsePacer(display)) fps = 0;
+    SetTargetFPS(fps);
+
+    if (display.frameMode == FRAME_IDLE) EnableEventWaiting();
+    else DisableEventWaiting();
+    display.nextPresent = 0.0;
+}
+
+void DisplaySetFrameMode(Display &display, FrameMode mode) {
+    if (mode == display.frameMode) return;
+    display.frameMode = mode;
+    ApplyFrameMode(display);
+}
+
+float DisplayFrameTime(const Display &display) {
+    if (!display.wokeFromIdle) return GetFrameTime();
+    return 1.0f / (display.settings.targetFps > 0 ? display.settings.targetFps : MIN_TARGET_FPS);
+}
+
+void DisplayPace(Display &display) {
+    if (!UsePacer(display)) return;
+    double period = 1.0 / display.settings.targetFps;
+    double now = GetTime();
+
+    // Start a new grid on the first frame, or after falling a whole frame behind
+    if (display.nextPresent == 0.0 || now > display.nextPresent + period) {
+        display.nextPresent = now;
+        return;
+    }
+
+    // The OS may oversleep; learn by how much and stop sleeping that much earlier
+    double sleepUntil = display.nextPresent - display.spinMargin;
+    if (sleepUntil > now) {
+        this_thread::sleep_for(chrono::duration<double>(sleepUntil - now));
+        double overslept = GetTime() - sleepUntil;
+        double wanted = overslept * 1.5 + MIN_SPIN_MARGIN;
+        display.spinMargin += (wanted - display.spinMargin) * (wanted > display.spinMargin ? 0.5 : 0.02);
+        display.spinMargin = fmax(MIN_SPIN_MARGIN, fmin(MAX_SPIN_MARGIN, display.spinMargin));
+    }
+    while (GetTime() < display.nextPresent) {}
+}
+
+void DisplayPresented(Display &display) {
+    double now = GetTime();
+    display.wokeFromIdle = display.frameMode == FRAME_IDLE;
+    if (display.frameMode == FRAME_GAMEPLAY && display.settings.targetFps > 0 && display.lastPresent > 0.0) {
+        double errorMs = fabs((now - display.lastPresent) - 1.0 / display.settings.targetFps) * 1000.0;
+        display.presentErrorMs += (errorMs - display.presentErrorMs) * 0.05;
+    }
+    display.lastPresent = now;
+    if (UsePacer(display) && display.nextPresent != 0.0) display.nextPresent += 1.0 / display.settings.targetFps;
+}
+
+void DisplayClose(Display &display) {
+    if (display.targetLoaded) UnloadRenderTexture(display.target);
+    display.targetLoaded = false;
+}
+
+void DisplaySetTargetFps(Display &display, int fps) {
+    display.settings.targetFps = fps;
+    ApplyFrameMode(display);
+}
+
+void DisplaySetVsync(Display &display, bool vsync) {
+    display.settings.vsync = vsync;
+    if (vsync) SetWindowState(FLAG_VSYNC_HINT);
+    else ClearWindowState(FLAG_VSYNC_HINT);
+    ApplyFrameMode(display);
+}
+
+void DisplayToggleFullscreen(Display &display) {
+    ToggleFullscreen();
+    display.settings.fullscreen = IsWindowFullscreen();
+}
+
+// Works out the scaled playfield rectangle for the current window size
+static void UpdateLayout(Display &display, int width, int height) {
+    display.windowWidth = width;
+    display.windowHeight = height;
+    display.direct = width == screenWidth && height == screenHeight;
+
+    float scale = (float)width / screenWidth;
+    if ((float)height / screenHeight < scale) scale = (float)height / screenHeight;
+    display.dest.width = screenWidth * scale;
+    display.dest.height = screenHeight * scale;
+    display.dest.x = (width - display.dest.width) / 2;
+    display.dest.y = (height - display.dest.height) / 2;
+
+    if (display.direct) {
+        SetMouseOffset(0, 0);
+        SetMouseScale(1.0f, 1.0f);
+    } else {
+        SetMouseOffset(-(int)display.dest.x, -(int)display.dest.y);
+        SetMouseScale(1.0f / scale, 1.0f / scale);
+        if (!display.targetLoaded) {
+            display.target = LoadRenderTexture(screenWidth, screenHeight);
+            SetTextureFilter(display.target.texture, TEXTURE_FILTER_BILINEAR);
+            display.targetLoaded = true;
+        }
+    }
+}
+
+void DisplayBeginFrame(Display &display) {
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    if (width != display.windowWidth || height != display.windowHeight) UpdateLayout(display, width, height);
+    if (!display.direct) BeginTextureMode(display.target);
+}
+
+void DisplayEndFrame(Display &display) {
+    if (display.direct) return;
+    EndTextureMode();
+
+    // Render textures are stored upside down, hence the negative source height
+    Rectangle source = {0.0f, 0.0f, (float)screenWidth, -(float)screenHeight};
+    Vector2 origin = {0.0f, 0.0f};
+    ClearBackground(BLACK);
+    DrawTexturePro(display.target.texture, source, display.dest, origin, 0.0f, WHITE);
+}
@@ -0,0 +1,83 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "raylib.h"
+
+// Window and frame presentation. The game always draws in playfield
+// coordinates (screenWidth x screenHeight from game_sim.h), whatever the
+// window size. When the window matches the playfield, frames are drawn
+// straight to it; otherwise they are drawn into a playfield-sized render
+// texture that is scaled to fit the window, letterboxed to keep the aspect
+// ratio. The mouse is mapped back to playfield coordinates, so the rules,
+// layout and input code never see window pixels.
+
+const int MIN_TARGET_FPS = 60;
+const int MAX_TARGET_FPS = 500;
+const int FRAME_RATE_CHOICES[] = {60, 120, 144, 240, 500, 0};    // 0 is uncapped
+const int FRAME_RATE_CHOICE_COUNT = 6;
+const int BACKGROUND_FPS = 20;      // While a screen waits on background work
+
+// How the next frame is paced
+enum FrameMode {
+    FRAME_ACTIVE,       // Something is moving: the target frame rate, paced by raylib
+    FRAME_GAMEPLAY,     // The target frame rate, paced by DisplayPace unless vsync is on
+    FRAME_BACKGROUND,   // Waiting on a worker thread: BACKGROUND_FPS
+    FRAME_IDLE          // Nothing changes until input arrives: sleep in EndDrawing until then
+};
+
+struct DisplaySettings {
+    int windowWidth;
+    int windowHeight;
+    bool fullscreen;
+    bool vsync;
+    int targetFps;          // MIN_TARGET_FPS to MAX_TARGET_FPS, or 0 for uncapped
+    bool precisePacing;     // Pace gameplay with DisplayPace instead of raylib's wait
+};
+
+struct Display {
+    DisplaySettings settings;
+    RenderTexture2D target;
+    bool targetLoaded;
+    bool direct;            // Window matches the playfield: no render texture this frame
+    int windowWidth;        // Size the layout below was worked out for
+    int windowHeight;
+    Rectangle dest;         // Where the playfield lands in the window
+
+    FrameMode frameMode;
+    bool wokeFromIdle;      // The last frame slept in EndDrawing
+    double nextPresent;     // DisplayPace deadline, 0 to start a new schedule
+    double spinMargin;      // Seconds before the deadline at which sleeping stops and spinning starts
+    double lastPresent;
+    double presentErrorMs;  // Moving average of |present interval - frame period|
+};
+
+DisplaySettings DefaultDisplaySettings();
+
+// Opens the window
+void DisplayInit(Display &display, const DisplaySettings &settings, const char* title);
+void DisplayClose(Display &display);
+
+void DisplaySetTargetFps(Display &display, int fps);
+void DisplaySetVsync(Display &display, bool vsync);
+void DisplayToggleFullscreen(Display &display);
+
+// Call right after BeginDrawing and right before EndDrawing
+void DisplayBeginFrame(Display &display);
+void DisplayEndFrame(Display &display);
+
+// Pacing for the frames after this one; cheap to call every frame
+void DisplaySetFrameMode(Display &display, FrameMode mode);
+
+// GetFrameTime, except that the frame after an idle wait counts as one
+// normal frame rather than however long the wait lasted
+float DisplayFrameTime(const Display &display);
+
+// In FRAME_GAMEPLAY, waits until the next present deadline: sleeps until
+// just short of it, then spins. Deadlines are a fixed grid, so an early or
+// late frame does not shift the ones after it. Call just before EndDrawing.
+void DisplayPace(Display &display);
+
+// Call just after EndDrawing
+void DisplayPresented(Display &display);
+
+#endif
@@ -0,0 +1,406 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include "score_protocol.h"
+#include "player_stats.h"
+#include "asset_bundle.h"
+#include "replay.h"
+#include "score_log.h"
+#include "score_view.h"
+#include <unistd.h>
+
+using namespace std;
+
+// Round-trip and corruption tests for the wire and file formats: the score
+// protocol, the score log, the player stats file, asset bundles and
+// replays. Each format must read back what was written and reject damaged
+// or truncated input instead of reading past it. Run by ctest; exits with 1
+// if any check fails.
+
+int failedChecks = 0;
+
+#define CHECK(condition) Check((condition), #condition, __FILE__, __LINE__)
+
+void Check(bool passed, const char* condition, const char* file, int line) {
+    if (passed) return;
+    failedChecks++;
+    cerr << file << ":" << line << ": check failed: " << condition << endl;
+}
+
+void TestScoreRequest() {
+    vector<unsigned char> bytes;
+    EncodeScoreRequest(bytes, 7, SCORE_OP_SUBMIT, "alice", 1234, 0, 17, 812.5f);
+    EncodeScoreRequest(bytes, 8, SCORE_OP_TOP, NULL, 0, 10);
+    const int first = (int)(sizeof(ScoreRequest) + strlen("alice"));
+    CHECK(bytes.size() == first + sizeof(ScoreRequest));
+
+    // Pipelined requests decode one after the other
+    ScoreRequest request;
+    char name[MAX_NAME_LENGTH];
+    CHECK(DecodeScoreRequest(&bytes[0], bytes.size(), request, name) == first);
+    CHECK(request.id == 7 && request.op == SCORE_OP_SUBMIT && request.value == 1234);
+    CHECK(request.rally == 17 && request.ballSpeed == 812.5f);
+    CHECK(strcmp(name, "alice") == 0);
+    CHECK(DecodeScoreRequest(&bytes[first], bytes.size() - first, request, name) == (int)sizeof(ScoreRequest));
+    CHECK(request.id == 8 && request.op == SCORE_OP_TOP && request.count == 10 && name[0] == '\0');
+
+    // Anything short of a whole request waits for more bytes
+    for (int size = 0; size < first; size++) {
+        CHECK(DecodeScoreRequest(&bytes[0], size, request, name) == 0);
+    }
+
+    // Long names are cut, counts clamped
+    bytes.clear();
+    string longName(MAX_NAME_LENGTH * 2, 'x');
+    EncodeScoreRequest(bytes, 9, SCORE_OP_RANGE, longName.c_str(), 1, MAX_SCORE_ROWS * 10);
+    CHECK(DecodeScoreRequest(&bytes[0], bytes.size(), request, name) == (int)bytes.size());
+    CHECK(strlen(name) == MAX_NAME_LENGTH - 1 && request.count == MAX_SCORE_ROWS);
+
+    // A name too long for the buffer is malformed, not truncated
+    bytes.resize(sizeof(ScoreRequest) + MAX_NAME_LENGTH);
+    bytes[offsetof(ScoreRequest, nameLength)] = MAX_NAME_LENGTH;
+    CHECK(DecodeScoreRequest(&bytes[0], bytes.size(), request, name) == -1);
+    CHECK(DecodeScoreRequest(&bytes[0], sizeof(ScoreRequest), request, name) == -1);
+}
+
+void TestScoreAnswer() {
+    ScoreAnswerHeader header;
+    memset(&header, 0, sizeof(header));
+    header.id = 3;
+    header.op = SCORE_OP_TOP;
+    header.status = SCORE_STATUS_OK;
+    header.rowCount = 2;
+    header.rank = 1;
+    header.total = 40;
+    header.topScore = 900;
+    vector<unsigned char> bytes;
+    EncodeScoreAnswer(bytes, header);
+    EncodeScoreRow(bytes, "bob", 900);
+    EncodeScoreRow(bytes, "carol", 850);
+
+    ScoreAnswer answer;
+    CHECK(DecodeScoreAnswer(&bytes[0], bytes.size(), answer) == (int)bytes.size());
+    CHECK(answer.header.id == 3 && answer.header.total == 40 && answer.header.topScore == 900);
+    CHECK(answer.rows.size() == 2);
+    if (answer.rows.size() == 2) {
+        CHECK(strcmp(answer.rows[0].name, "bob") == 0 && answer.rows[0].score == 900);
+        CHECK(strcmp(answer.rows[1].name, "carol") == 0 && answer.rows[1].score == 850);
+    }
+    for (size_t size = 0; size < bytes.size(); size++) {
+        CHECK(DecodeScoreAnswer(&bytes[0], size, answer) == 0);
+    }
+
+    // A row whose name would overrun the buffer
+    vector<unsigned char> badRow = bytes;
+    badRow[sizeof(ScoreAnswerHeader) + offsetof(ScoreRowHeader, nameLength)] = MAX_NAME_LENGTH;
+    CHECK(DecodeScoreAnswer(&badRow[0], badRow.size(), answer) == -1);
+
+    // More rows than any answer carries
+    header.rowCount = MAX_SCORE_ROWS + 1;
+    bytes.clear();
+    EncodeScoreAnswer(bytes, header);
+    CHECK(DecodeScoreAnswer(&bytes[0], bytes.size(), answer) == -1);
+
+    // A successful PLAYER_STATS answer carries the player's summary
+    header.op = SCORE_OP_PLAYER_STATS;
+    header.rowCount = 0;
+    header.rank = 5;
+    header.score = 700;
+    PlayerSummary stats = {12, 700, 412.5f, 87.5f, 31, 950.0f};
+    bytes.clear();
+    EncodeScoreAnswer(bytes, header);
+    EncodePlayerSummary(bytes, stats);
+    CHECK(DecodeScoreAnswer(&bytes[0], bytes.size(), answer) == (int)bytes.size());
+    CHECK(memcmp(&answer.stats, &stats, sizeof(stats)) == 0);
+    CHECK(DecodeScoreAnswer(&bytes[0], bytes.size() - 1, answer) == 0);
+
+    // A failed one does not
+    header.status = SCORE_STATUS_BAD_REQUEST;
+    bytes.clear();
+    EncodeScoreAnswer(bytes, header);
+    CHECK(DecodeScoreAnswer(&bytes[0], bytes.size(), answer) == (int)sizeof(ScoreAnswerHeader));
+}
+
+bool ReadFileBytes(const char* path, vector<unsigned char> &bytes) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+    unsigned char buffer[65536];
+    size_t n;
+    bytes.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+    fclose(in);
+    return true;
+}
+
+bool WriteFileBytes(const char* path, const vector<unsigned char> &bytes) {
+    FILE* out = fopen(path, "wb");
+    if (!out) return false;
+    bool written = fwrite(&bytes[0], 1, bytes.size(), out) == bytes.size();
+    return fclose(out) == 0 && written;
+}
+
+void TestScoreLog() {
+    const char* path = "format_tests_scores.bin";
+    ScoreRecord records[3];
+    MakeScoreRecord(records[0], "ann", 120, 1000);
+    MakeScoreRecord(records[1], "ben", 300, 2000);
+    MakeScoreRecord(records[2], "cat", 90, 3000);
+    CHECK(WriteScoreLog(path, records, 3));
+
+    vector<ScoreRecord> loaded;
+    ScoreLogStats stats;
+    CHECK(ReadScoreLog(path, loaded, &stats));
+    CHECK(loaded.size() == 3 && stats.badRecords == 0 && stats.trailingBytes == 0);
+    CHECK(loaded.size() == 3 && memcmp(&loaded[0], records, sizeof(records)) == 0);
+
+    // A flipped byte fails the record's CRC; the others still load
+    vector<unsigned char> bytes;
+    CHECK(ReadFileBytes(path, bytes));
+    CHECK(bytes.size() == sizeof(ScoreLogHeader) + sizeof(records));
+    vector<unsigned char> bad = bytes;
+    bad[sizeof(ScoreLogHeader) + sizeof(ScoreRecord) + offsetof(ScoreRecord, score)] ^= 0x01;
+    CHECK(WriteFileBytes(path, bad));
+    CHECK(ReadScoreLog(path, loaded, &stats));
+    CHECK(loaded.size() == 2 && stats.badRecords == 1);
+    CHECK(loaded.size() == 2 && strcmp(loaded[0].name, "ann") == 0 && strcmp(loaded[1].name, "cat") == 0);
+
+    // The mapped view ranks and counts only the valid records
+    ScoreLogView view;
+    ScoreLogViewInit(view);
+    Leaderboard recent;
+    LeaderboardInit(recent);
+    LeaderboardAdd(recent, "eve", 200);
+    CHECK(ScoreLogViewOpen(view, path));
+    CHECK(ScoreLogViewCount(view) == 3 && ScoreLogViewValidCount(view) == 2);
+    CHECK(RankedScoreCount(view, recent) == 3);
+    const char* rankedName;
+    int rankedScore;
+    CHECK(RankedScoreAt(view, recent, 2, rankedName, rankedScore) && strcmp(rankedName, "ann") == 0);
+    CHECK(RankedScoreAt(view, recent, 3, rankedName, rankedScore) && strcmp(rankedName, "cat") == 0);
+    CHECK(!RankedScoreAt(view, recent, 4, rankedName, rankedScore));
+    ScoreLogViewClose(view);
+
+    // Half a record at the end, as a crash during an append leaves it, is
+    // reported, then cut off before the next append
+    bad = bytes;
+    bad.insert(bad.end(), bytes.end() - sizeof(ScoreRecord), bytes.end() - sizeof(ScoreRecord) / 2);
+    CHECK(WriteFileBytes(path, bad));
+    CHECK(ReadScoreLog(path, loaded, &stats));
+    CHECK(loaded.size() == 3 && stats.trailingBytes == (int)sizeof(ScoreRecord) / 2);
+    int fd = OpenScoreLogForAppend(path);
+    CHECK(fd >= 0);
+    if (fd >= 0) {
+        ScoreRecord next;
+        MakeScoreRecord(next, "dan", 410, 4000);
+        CHECK(AppendScoreRecords(fd, &next, 1));
+        close(fd);
+        CHECK(ReadScoreLog(path, loaded, &stats));
+        CHECK(loaded.size() == 4 && stats.badRecords == 0 && stats.trailingBytes == 0);
+        CHECK(loaded.size() == 4 && strcmp(loaded[3].name, "dan") == 0 && loaded[3].score == 410);
+    }
+
+    // Not a score log
+    bad = bytes;
+    bad[0] = 'X';
+    CHECK(WriteFileBytes(path, bad));
+    CHECK(!ReadScoreLog(path, loaded, &stats));
+
+    // The old text format, with a name containing spaces
+    const char* textPath = "format_tests_scores.txt";
+    FILE* text = fopen(textPath, "w");
+    CHECK(text != NULL);
+    if (text) {
+        fprintf(text, "ASJAD 1000\nMary Jane 250\nCR 999\n");
+        fclose(text);
+        CHECK(ImportTextScores(textPath, path));
+        CHECK(ReadScoreLog(path, loaded, &stats));
+        CHECK(loaded.size() == 3 && stats.badRecords == 0);
+        CHECK(loaded.size() == 3 && strcmp(loaded[1].name, "Mary Jane") == 0 && loaded[1].score == 250);
+        CHECK(loaded.size() == 3 && strcmp(loaded[2].name, "CR") == 0 && loaded[2].score == 999);
+    }
+    remove(textPath);
+    remove(path);
+}
+
+void TestPlayerStats() {
+    const char* path = "format_tests_players.bin";
+    PlayerStatsTable stats;
+    PlayerStatsInit(stats);
+    GameSummary games[] = {{120, 8, 600.0f}, {300, 14, 720.0f}, {90, 5, 610.0f}, {410, 22, 880.0f}};
+    const char* names[] = {"ann", "ben", "ann", "cat"};
+    for (int i = 0; i < 4; i++) PlayerStatsAdd(stats, names[i], games[i]);
+    CHECK(WritePlayerStats(path, stats));
+
+    PlayerStatsTable loaded;
+    int badRecords = -1;
+    CHECK(ReadPlayerStats(path, loaded, &badRecords));
+    CHECK(badRecords == 0 && loaded.players.size() == 3 && loaded.games == 4);
+    PlayerSummary ann = PlayerStatsSummary(loaded, "ann");
+    PlayerSummary expected = PlayerStatsSummary(stats, "ann");
+    CHECK(memcmp(&ann, &expected, sizeof(ann)) == 0);
+
+    // Tear ben's record, as a crash halfway through rewriting it would
+    vector<unsigned char> bytes;
+    CHECK(ReadFileBytes(path, bytes));
+    size_t record = sizeof(PlayerStatsHeader) + STATS_SCORE_BUCKETS * sizeof(uint32_t) + sizeof(PlayerStatsRecord);
+    CHECK(bytes.size() == record + 2 * sizeof(PlayerStatsRecord));
+    if (bytes.size() > record + offsetof(PlayerStatsRecord, totalScore)) {
+        memset(&bytes[record + offsetof(PlayerStatsRecord, games)], 0xff, 8);
+        CHECK(WriteFileBytes(path, bytes));
+        CHECK(ReadPlayerStats(path, loaded, &badRecords));
+        CHECK(badRecords == 1 && loaded.players.size() == 2);
+        CHECK(PlayerStatsFind(loaded, "ben") < 0);
+        CHECK(PlayerStatsFind(loaded, "ann") >= 0 && PlayerStatsFind(loaded, "cat") >= 0);
+        ann = PlayerStatsSummary(loaded, "ann");
+        CHECK(ann.games == 2 && ann.best == 120 && ann.longestRally == 8);
+    }
+
+    // A file cut inside the histogram is not a stats file
+    bytes.resize(sizeof(PlayerStatsHeader) + 100);
+    CHECK(WriteFileBytes(path, bytes));
+    CHECK(!ReadPlayerStats(path, loaded, &badRecords));
+    remove(path);
+}
+
+// Rewrites the entry table checksum, so only the change made to an entry is wrong
+void ResealAssetBundle(vector<unsigned char> &bytes) {
+    AssetBundleHeader header;
+    memcpy(&header, &bytes[0], sizeof(header));
+    header.checksum = Crc32(&bytes[sizeof(header)], header.count * sizeof(AssetEntry));
+    memcpy(&bytes[0], &header, sizeof(header));
+}
+
+void TestAssetBundle() {
+    vector<AssetFile> files(2);
+    files[0].name = "paddle.wav";
+    files[0].data.assign(1000, 0x5a);
+    files[1].name = "ball.wav";
+    for (int i = 0; i < 333; i++) files[1].data.push_back((unsigned char)i);
+    vector<unsigned char> bytes;
+    EncodeAssetBundle(files, bytes);
+
+    AssetBundle bundle;
+    const unsigned char* data;
+    size_t size;
+    CHECK(AssetBundleOpenMemory(bundle, &bytes[0], bytes.size()));
+    CHECK(bundle.count == 2);
+    CHECK(AssetBundleFind(bundle, "ball.wav", data, size));
+    CHECK(size == files[1].data.size() && memcmp(data, &files[1].data[0], size) == 0);
+    CHECK(!AssetBundleFind(bundle, "missing.wav", data, size));
+
+    // Offsets and sizes that point past the end, even with a valid table checksum
+    const size_t entry = sizeof(AssetBundleHeader) + sizeof(AssetEntry);
+    vector<unsigned char> bad = bytes;
+    uint32_t value = (uint32_t)bytes.size() + 1;
+    memcpy(&bad[entry + offsetof(AssetEntry, offset)], &value, sizeof(value));
+    ResealAssetBundle(bad);
+    CHECK(!AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+
+    bad = bytes;
+    value = (uint32_t)bytes.size();
+    memcpy(&bad[entry + offsetof(AssetEntry, size)], &value, sizeof(value));
+    ResealAssetBundle(bad);
+    CHECK(!AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+
+    // Offset plus size wrapping around 32 bits
+    bad = bytes;
+    value = 0xffffff00u;
+    memcpy(&bad[entry + offsetof(AssetEntry, size)], &value, sizeof(value));
+    ResealAssetBundle(bad);
+    CHECK(!AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+
+    // An entry count whose table runs past the end
+    bad = bytes;
+    value = 1000000;
+    memcpy(&bad[offsetof(AssetBundleHeader, count)], &value, sizeof(value));
+    CHECK(!AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+
+    // A changed entry without a new checksum
+    bad = bytes;
+    bad[entry + offsetof(AssetEntry, offset)] ^= 1;
+    CHECK(!AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+
+    // Cut data: the table still fits but the entries no longer do
+    CHECK(!AssetBundleOpenMemory(bundle, &bytes[0], bytes.size() - 1));
+    CHECK(!AssetBundleOpenMemory(bundle, &bytes[0], sizeof(AssetBundleHeader) - 1));
+
+    // Damaged data opens, but the asset fails its checksum
+    bad = bytes;
+    bad.back() ^= 0x80;
+    CHECK(AssetBundleOpenMemory(bundle, &bad[0], bad.size()));
+    CHECK(!AssetBundleFind(bundle, "ball.wav", data, size));
+    CHECK(AssetBundleFind(bundle, "paddle.wav", data, size));
+}
+
+// Plays a game to the end with inputs that change every so often, as a player's would
+void RecordReplay(Replay &replay, OpponentLevel opponent, GameSimState &state) {
+    const int tickRate = 240;
+    ReplayBegin(replay, 500.0f, tickRate, true, opponent, 42);
+    SimReset(state, 500.0f, opponent != OPPONENT_NONE);
+    PredictorAI ai;
+    PredictorAIReset(ai, opponent, tickRate, 42);
+    const float tickTime = ReplayTickTime(replay.header);
+
+    unsigned int seed = 99;
+    SimInput input = {false, false, 0};
+    for (int tick = 0; !state.gameOver && tick < tickRate * 600; tick++) {
+        if (tick % 37 == 0) {
+            seed = seed * 1664525u + 1013904223u;
+            input.up = (seed >> 24) % 3 == 0;
+            input.down = !input.up && (seed >> 24) % 3 == 1;
+            input.axis = (seed >> 16) % 4 == 0 ? (signed char)((int)((seed >> 8) % 201) - 100) : 0;
+        }
+        ReplayRecord(replay, input);
+        if (opponent == OPPONENT_NONE) SimStep(state, input, tickTime);
+        else SimStepVersus(state, input, PredictorAIInput(ai, state), tickTime);
+    }
+    ReplayFinish(replay, state);
+}
+
+void TestReplay(OpponentLevel opponent) {
+    Replay replay;
+    GameSimState recorded;
+    RecordReplay(replay, opponent, recorded);
+    CHECK(recorded.gameOver);
+
+    vector<unsigned char> bytes;
+    EncodeReplay(replay, bytes);
+    Replay decoded;
+    CHECK(DecodeReplay(&bytes[0], bytes.size(), decoded));
+    CHECK(memcmp(&decoded.header, &replay.header, sizeof(ReplayHeader)) == 0);
+    CHECK(decoded.inputs == replay.inputs);
+    CHECK(ReplayOpponent(decoded.header) == opponent);
+
+    GameSimState played;
+    CHECK(ReplayVerify(decoded, played));
+    CHECK(SimStateChecksum(played) == SimStateChecksum(recorded));
+
+    // Any flipped bit fails the checksum, and a cut file never decodes
+    for (size_t i = 0; i < bytes.size(); i += 7) {
+        vector<unsigned char> bad = bytes;
+        bad[i] ^= 0x10;
+        CHECK(!DecodeReplay(&bad[0], bad.size(), decoded));
+    }
+    CHECK(!DecodeReplay(&bytes[0], bytes.size() - 1, decoded));
+    CHECK(!DecodeReplay(&bytes[0], sizeof(ReplayHeader) - 1, decoded));
+}
+
+int main() {
+    TestScoreRequest();
+    TestScoreAnswer();
+    TestScoreLog();
+    TestPlayerStats();
+    TestAssetBundle();
+    TestReplay(OPPONENT_NONE);
+    TestReplay(OPPONENT_HARD);
+
+    if (failedChecks > 0) {
+        cerr << failedChecks << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All format tests passed" << endl;
+    return 0;
+}
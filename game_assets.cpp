@@ -0,0 +1,185 @@
+#include "game_assets.h"
+#include "asset_bundle.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#ifdef EMBED_ASSETS
+// Generated by asset_packer --cpp
+extern const unsigned char embeddedAssetBundle[];
+extern const size_t embeddedAssetBundleSize;
+#endif
+
+struct StartupEvent {
+    double ms;
+    string step;
+};
+
+struct PendingSound {
+    Wave wave;
+    bool decoded;
+};
+
+// Initialized before main runs, so close enough to the process start
+static const chrono::steady_clock::time_point processStart = chrono::steady_clock::now();
+static mutex startupMutex;
+static vector<StartupEvent> startupEvents;
+
+static SoundAsset* assets = NULL;
+static int assetCount = 0;
+static vector<PendingSound> pending;    // One slot per sound, written by its own task
+static string appDirectory;
+static AssetBundle bundle;
+static bool bundleOpen = false;
+static ThreadPool* loadPool = NULL;
+static atomic<int> tasksLeft(0);        // Loading is done when this reaches zero
+static bool audioStarted = false;       // Written by the audio task before tasksLeft drops
+static bool soundsReady = false;
+
+static void AddStartupEvent(const string &step) {
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - processStart).count();
+    StartupEvent event = {ms, step};
+    lock_guard<mutex> lock(startupMutex);
+    startupEvents.push_back(event);
+}
+
+void StartupMark(const char* step) {
+    AddStartupEvent(step);
+}
+
+static bool ReadWholeFile(const string &path, vector<unsigned char> &data) {
+    ifstream in(path.c_str(), ios::binary);
+    if (!in) return false;
+    data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+static void DecodeSound(int index) {
+    const char* name = assets[index].name;
+    PendingSound &slot = pending[index];
+
+    const unsigned char* data = NULL;
+    size_t size = 0;
+    vector<unsigned char> fileData;
+    if (!bundleOpen || !AssetBundleFind(bundle, name, data, size)) {
+        if (ReadWholeFile(appDirectory + "resources/" + name, fileData) ||
+            ReadWholeFile(string("resources/") + name, fileData)) {
+            data = fileData.empty() ? NULL : &fileData[0];
+            size = fileData.size();
+        }
+    }
+
+    const char* extension = strrchr(name, '.');
+    if (data && extension) {
+        // Parses and converts the file only; safe off the main thread
+        slot.wave = LoadWaveFromMemory(extension, data, (int)size);
+        slot.decoded = IsWaveValid(slot.wave);
+    }
+    AddStartupEvent(string(slot.decoded ? "decoded " : "could not load ") + name);
+}
+
+void AssetsStart(SoundAsset* sounds, int count) {
+    assets = sounds;
+    assetCount = count;
+    soundsReady = false;
+    pending.assign(count, PendingSound());
+    for (int i = 0; i < count; i++) {
+        memset(&pending[i].wave, 0, sizeof(Wave));
+        pending[i].decoded = false;
+    }
+    appDirectory = GetApplicationDirectory();
+
+    AssetBundleInit(bundle);
+    bundleOpen = false;
+#ifdef EMBED_ASSETS
+    bundleOpen = AssetBundleOpenMemory(bundle, embeddedAssetBundle, embeddedAssetBundleSize);
+#endif
+    if (!bundleOpen) bundleOpen = AssetBundleOpen(bundle, (appDirectory + "assets.ppa").c_str());
+    AddStartupEvent(bundleOpen ? "opened asset bundle" : "no asset bundle, using resources/");
+
+    // At least two threads, so opening the audio device, which mostly waits
+    // on the system, never holds up decoding
+    int threads = max(2, min(count + 1, (int)thread::hardware_concurrency()));
+    loadPool = new ThreadPool(threads);
+    tasksLeft = count + 1;
+    loadPool->Submit([] {
+        InitAudioDevice();
+        audioStarted = IsAudioDeviceReady();
+        AddStartupEvent(audioStarted ? "audio device" : "no audio device");
+        tasksLeft--;
+    });
+    for (int i = 0; i < count; i++) {
+        loadPool->Submit([i] {
+            DecodeSound(i);
+            tasksLeft--;
+        });
+    }
+}
+
+static void FinishLoading() {
+    loadPool->Wait();
+    delete loadPool;
+    loadPool = NULL;
+    AssetBundleClose(bundle);
+    bundleOpen = false;
+
+    for (int i = 0; i < assetCount; i++) {
+        if (!pending[i].decoded) continue;
+        if (audioStarted) {
+            *assets[i].sound = LoadSoundFromWave(pending[i].wave);
+            SetSoundVolume(*assets[i].sound, assets[i].volume);
+        }
+        UnloadWave(pending[i].wave);
+    }
+    pending.clear();
+    soundsReady = true;
+    AddStartupEvent("sounds ready");
+}
+
+bool AssetsPoll() {
+    if (soundsReady || !loadPool || tasksLeft.load() > 0) return false;
+    FinishLoading();
+    return true;
+}
+
+bool AssetsReady() {
+    return soundsReady;
+}
+
+void AssetsPrintStartup() {
+    vector<StartupEvent> events;
+    {
+        lock_guard<mutex> lock(startupMutex);
+        events = startupEvents;
+    }
+    // Worker threads mark out of order
+    stable_sort(events.begin(), events.end(), [](const StartupEvent &a, const StartupEvent &b) { return a.ms < b.ms; });
+
+    printf("Startup (ms since launch, ms since previous step):\n");
+    double previous = 0.0;
+    for (size_t i = 0; i < events.size(); i++) {
+        printf("  %8.1f %+8.1f  %s\n", events[i].ms, events[i].ms - previous, events[i].step.c_str());
+        previous = events[i].ms;
+    }
+}
+
+void AssetsClose() {
+    if (loadPool) FinishLoading();
+    for (int i = 0; i < assetCount; i++) {
+        if (IsSoundValid(*assets[i].sound)) UnloadSound(*assets[i].sound);
+    }
+    if (audioStarted) CloseAudioDevice();
+    audioStarted = false;
+    soundsReady = false;
+}
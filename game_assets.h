@@ -0,0 +1,36 @@
+#ifndef GAME_ASSETS_H
+#define GAME_ASSETS_H
+
+#include "raylib.h"
+
+// Startup loading. The audio device opens and the sounds decode on worker
+// threads while the menu is already drawing; the main thread only turns the
+// decoded waves into sounds once everything is in.
+//
+// Sounds come from the first of: the bundle compiled into the executable
+// (built with -DEMBED_ASSETS), assets.ppa next to the executable, or loose
+// files in resources/ next to the executable or the working directory.
+
+struct SoundAsset {
+    const char* name;       // File name, e.g. "bounce.wav"
+    float volume;
+    Sound* sound;           // Filled in by AssetsPoll
+};
+
+// Marks a startup step in the log, timed from the start of the process
+void StartupMark(const char* step);
+
+// Starts loading; sounds must outlive loading
+void AssetsStart(SoundAsset* sounds, int count);
+
+// Call once per frame. True on the frame the sounds become playable.
+bool AssetsPoll();
+bool AssetsReady();
+
+// Prints the startup marks with the time between them
+void AssetsPrintStartup();
+
+// Waits for loading to finish, unloads the sounds and closes the audio device
+void AssetsClose();
+
+#endif
@@ -0,0 +1,310 @@
+#include "game_sim.h"
+#include <cmath>
+#include "collision.h"
+
+using namespace std;
+
+// Same value as raylib's DEG2RAD, kept here so the rules do not depend on raylib
+const float degToRad = 3.14159265358979323846f / 180.0f;
+
+// Opponent stops moving when its center is this close to where it is aiming
+const float OPPONENT_DEAD_ZONE = 3.0f;
+
+const OpponentLevelParams opponentLevels[OPPONENT_LEVEL_COUNT] = {
+    {"Wall", 0.0f, 0.0f},
+    {"Easy", 0.35f, 75.0f},
+    {"Medium", 0.20f, 55.0f},
+    {"Hard", 0.08f, 20.0f}
+};
+
+// Rules read from a SimParams each time they are used
+struct RuntimeRules {
+    const SimParams &params;
+    float PaddleSpeed() const { return params.paddleSpeed; }
+    float MaxBounceAngle() const { return params.maxBounceAngle; }
+    float SpeedUpPerHit() const { return params.speedUpPerHit; }
+};
+
+// Rules fixed at compile time by a rule set such as DefaultRules
+template <class RuleSet>
+struct CompiledRules {
+    float PaddleSpeed() const { return RuleSet::paddleSpeed; }
+    float MaxBounceAngle() const { return RuleSet::maxBounceAngle; }
+    float SpeedUpPerHit() const { return RuleSet::speedUpPerHit; }
+};
+
+BallSpeedPreset BallSpeedPresetFor(float ballSpeed) {
+    int nearest = 0;
+    for (int i = 1; i < BALL_SPEED_PRESET_COUNT; i++) {
+        if (fabs(BALL_SPEED_PRESETS[i] - ballSpeed) < fabs(BALL_SPEED_PRESETS[nearest] - ballSpeed)) nearest = i;
+    }
+    return (BallSpeedPreset)nearest;
+}
+
+void SimReset(GameSimState &state, float ballSpeed, bool opponent) {
+    state.ballX = (float)screenWidth / 2;
+    state.ballY = (float)screenHeight / 2;
+    // Set initial velocity based on current speed setting - directly use selected speed
+    state.ballVelocityX = -ballSpeed;  // 45-degree angle
+    state.ballVelocityY = ballSpeed;
+    state.paddleY = (float)screenHeight / 2 - paddleHeight / 2;
+    state.score = 0;
+    state.gameOver = false;
+    state.tick = 0;
+    state.opponent = opponent;
+    state.opponentY = state.paddleY;
+}
+
+// New height of a paddle after one tick of input, kept on the playfield
+template <class Rules>
+static float MovePaddle(float y, const SimInput &input, float deltaTime, const Rules &rules) {
+    if (input.axis != 0) {
+        float move = rules.PaddleSpeed() * deltaTime * ((float)input.axis / SIM_AXIS_MAX);
+        return fmin((float)(screenHeight - paddleHeight), fmax(0.0f, y + move));
+    }
+    if (input.up) {
+        y = fmax(0.0f, y - rules.PaddleSpeed() * deltaTime);
+    }
+    if (input.down) {
+        y = fmin((float)(screenHeight - paddleHeight), y + rules.PaddleSpeed() * deltaTime);
+    }
+    return y;
+}
+
+// Ball leaves a paddle at an angle set by where it hit, a little faster each time
+template <class Rules>
+static void BounceOffPaddle(GameSimState &state, float paddleTop, float direction, const Rules &rules) {
+    // Calculate relative intersection position with the paddle (-1 to 1)
+    float relativeIntersectY = (state.ballY - (paddleTop + paddleHeight/2.0f)) / (paddleHeight/2.0f);
+    float bounceAngle = relativeIntersectY * rules.MaxBounceAngle();  // Max 60 degree bounce angle by default
+
+    // Get current speed and increase it (by 5% by default)
+    float speed = sqrt(state.ballVelocityX * state.ballVelocityX + state.ballVelocityY * state.ballVelocityY);
+    speed *= rules.SpeedUpPerHit();
+
+    // Apply the new speed with the bounce angle
+    state.ballVelocityX = direction * fabs(speed * cos(bounceAngle * degToRad));
+    state.ballVelocityY = speed * sin(bounceAngle * degToRad);
+}
+
+// opponentInput is NULL outside two-paddle mode. Compiled per rules
+// source and mode, so compiled rule sets carry no parameter loads or mode tests.
+template <bool Versus, class Rules>
+static SimEvents Step(GameSimState &state, const SimInput &input, const SimInput* opponentInput, float deltaTime,
+                      const Rules &rules) {
+    SimEvents events = {0, 0, false, 0.0f, 0, 0};
+    bool opponent = Versus && state.opponent;
+
+    // Move the ball through the step contact by contact, so fast balls cannot skip past the paddle
+    float remaining = deltaTime;
+    for (int bounce = 0; bounce < MAX_BOUNCES_PER_STEP && remaining > 0.0f && !state.gameOver; bounce++) {
+        // Find the earliest contact within the remaining time
+        BallContact contact = CONTACT_NONE;
+        float contactTime = remaining;
+        float t;
+
+        if (state.ballVelocityY < 0) {
+            t = SweepCircleWall(state.ballY, state.ballVelocityY, ballRadius, 0, remaining);
+            if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_TOP_WALL; }
+        }
+        if (state.ballVelocityY > 0) {
+            t = SweepCircleWall(state.ballY, state.ballVelocityY, ballRadius, screenHeight, remaining);
+            if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_BOTTOM_WALL; }
+        }
+        if (state.ballVelocityX > 0) {
+            t = SweepCircleWall(state.ballX, state.ballVelocityX, ballRadius, screenWidth, remaining);
+            if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_RIGHT_WALL; }
+
+            // Checked last so the opponent wins a tie with the right wall
+            if (opponent) {
+                t = SweepCircleRect(state.ballX, state.ballY, state.ballVelocityX, state.ballVelocityY, ballRadius,
+                                    opponentX, state.opponentY, paddleWidth, paddleHeight, remaining);
+                if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_OPPONENT; }
+            }
+        }
+        if (state.ballVelocityX < 0) {  // Only bounce if moving towards paddle
+            t = SweepCircleWall(state.ballX, state.ballVelocityX, ballRadius, 0, remaining);
+            if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_LEFT_WALL; }
+
+            // Checked last so the paddle wins a tie with the left wall
+            t = SweepCircleRect(state.ballX, state.ballY, state.ballVelocityX, state.ballVelocityY, ballRadius,
+                                paddleX, state.paddleY, paddleWidth, paddleHeight, remaining);
+            if (t != NO_HIT && t <= contactTime) { contactTime = t; contact = CONTACT_PADDLE; }
+        }
+
+        // Advance to the contact (or the end of the step)
+        state.ballX += state.ballVelocityX * contactTime;
+        state.ballY += state.ballVelocityY * contactTime;
+        remaining -= contactTime;
+
+        switch (contact) {
+            case CONTACT_NONE:
+                remaining = 0.0f;
+                break;
+
+            // Handle top and bottom wall collisions with proper boundary checking
+            case CONTACT_TOP_WALL:
+                state.ballY = ballRadius;
+                events.hardestImpact = fmax(events.hardestImpact, fabs(state.ballVelocityY));
+                state.ballVelocityY = fabs(state.ballVelocityY);
+                events.wallBounces++;
+                break;
+            case CONTACT_BOTTOM_WALL:
+                state.ballY = screenHeight - ballRadius;
+                events.hardestImpact = fmax(events.hardestImpact, fabs(state.ballVelocityY));
+                state.ballVelocityY = -fabs(state.ballVelocityY);
+                events.wallBounces++;
+                break;
+
+            // Handle right wall collision; with an opponent, the ball got past it
+            case CONTACT_RIGHT_WALL:
+                if (opponent) {
+                    state.score += OPPONENT_MISS_POINTS;
+                    events.opponentMisses++;
+                    state.ballX = (float)screenWidth / 2;
+                    state.ballY = (float)screenHeight / 2;
+                    state.ballVelocityX = -fabs(state.ballVelocityX);
+                    break;
+                }
+                state.ballX = screenWidth - ballRadius;
+                events.hardestImpact = fmax(events.hardestImpact, fabs(state.ballVelocityX));
+                state.ballVelocityX = -fabs(state.ballVelocityX);
+                events.wallBounces++;
+                break;
+
+            // Handle paddle collision with improved physics
+            case CONTACT_PADDLE:
+                events.hardestImpact = fmax(events.hardestImpact, fabs(state.ballVelocityX));
+                BounceOffPaddle(state, state.paddleY, 1.0f, rules);
+                state.score++;
+                events.paddleHits++;
+                break;
+
+            case CONTACT_OPPONENT:
+                events.hardestImpact = fmax(events.hardestImpact, fabs(state.ballVelocityX));
+                BounceOffPaddle(state, state.opponentY, -1.0f, rules);
+                events.opponentHits++;
+                break;
+
+            // Handle game over condition
+            case CONTACT_LEFT_WALL:
+                state.gameOver = true;
+                events.gameOver = true;
+                break;
+        }
+    }
+
+    // Update paddle positions with boundary checking
+    state.paddleY = MovePaddle(state.paddleY, input, deltaTime, rules);
+    if (opponent) state.opponentY = MovePaddle(state.opponentY, *opponentInput, deltaTime, rules);
+
+    state.tick++;
+    return events;
+}
+
+SimEvents SimStep(GameSimState &state, const SimInput &input, float deltaTime, const SimParams &params) {
+    RuntimeRules rules = {params};
+    return Step<false>(state, input, NULL, deltaTime, rules);
+}
+
+SimEvents SimStepVersus(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime,
+                        const SimParams &params) {
+    RuntimeRules rules = {params};
+    return Step<true>(state, input, &opponentInput, deltaTime, rules);
+}
+
+template <class Rules>
+SimEvents SimStepRules(GameSimState &state, const SimInput &input, float deltaTime) {
+    return Step<false>(state, input, NULL, deltaTime, CompiledRules<Rules>());
+}
+
+template <class Rules>
+SimEvents SimStepVersusRules(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime) {
+    return Step<true>(state, input, &opponentInput, deltaTime, CompiledRules<Rules>());
+}
+
+template SimEvents SimStepRules<DefaultRules>(GameSimState &, const SimInput &, float);
+template SimEvents SimStepVersusRules<DefaultRules>(GameSimState &, const SimInput &, const SimInput &, float);
+
+SimInput PaddleAIInput(const PaddleAI &ai, const GameSimState &state) {
+    float target = state.ballY - ai.aimOffset;
+    float paddleCenter = state.paddleY + paddleHeight / 2.0f;
+    SimInput input;
+    input.up = target < paddleCenter - ai.deadZone;
+    input.down = target > paddleCenter + ai.deadZone;
+    input.axis = 0;
+    return input;
+}
+
+void DelayedPaddleAIReset(DelayedPaddleAI &ai, const PaddleAI &aim, int reactionTicks, const GameSimState &state) {
+    ai.aim = aim;
+    ai.reactionTicks = reactionTicks < 0 ? 0 : (reactionTicks >= MAX_REACTION_TICKS ? MAX_REACTION_TICKS - 1 : reactionTicks);
+    ai.next = 0;
+    // Until the delay has passed, the AI keeps seeing the serve position
+    for (int i = 0; i < MAX_REACTION_TICKS; i++) ai.seenBallY[i] = state.ballY;
+}
+
+SimInput DelayedPaddleAIInput(DelayedPaddleAI &ai, const GameSimState &state) {
+    ai.seenBallY[ai.next] = state.ballY;
+    int seen = ai.next - ai.reactionTicks;
+    if (seen < 0) seen += MAX_REACTION_TICKS;
+    ai.next = (ai.next + 1) % MAX_REACTION_TICKS;
+
+    GameSimState delayed = state;
+    delayed.ballY = ai.seenBallY[seen];
+    return PaddleAIInput(ai.aim, delayed);
+}
+
+float PredictBallY(const GameSimState &state, float x) {
+    float distance = x - state.ballX;
+    if (distance * state.ballVelocityX <= 0.0f) return state.ballY;
+
+    // Unfold the reflections: the center moves freely along a line, then is
+    // folded back into the band it can occupy, a triangle wave of period 2 * band
+    float t = distance / state.ballVelocityX;
+    float band = (float)(screenHeight - 2 * ballRadius);
+    float y = fmod(state.ballY - ballRadius + state.ballVelocityY * t, 2.0f * band);
+    if (y < 0.0f) y += 2.0f * band;
+    if (y > band) y = 2.0f * band - y;
+    return ballRadius + y;
+}
+
+void PredictorAIReset(PredictorAI &ai, OpponentLevel level, int tickRate, unsigned int seed) {
+    const OpponentLevelParams &params = opponentLevels[level];
+    ai.reactionTicks = (int)(params.reactionSeconds * tickRate + 0.5f);
+    ai.aimError = params.aimError;
+    ai.seed = seed;
+    ai.approaching = false;
+    ai.waitTicks = -1;
+    ai.targetY = (float)screenHeight / 2;
+}
+
+SimInput PredictorAIInput(PredictorAI &ai, const GameSimState &state) {
+    bool approaching = state.ballVelocityX > 0.0f;
+    if (approaching != ai.approaching) {
+        ai.approaching = approaching;
+        ai.waitTicks = ai.reactionTicks;
+    }
+
+    if (ai.waitTicks == 0) {
+        if (approaching) {
+            float error = SimRandomFloat(ai.seed, -ai.aimError, ai.aimError);
+            ai.targetY = PredictBallY(state, opponentX - ballRadius) + error;
+        } else {
+            ai.targetY = (float)screenHeight / 2;
+        }
+    }
+    if (ai.waitTicks >= 0) ai.waitTicks--;
+
+    float paddleCenter = state.opponentY + paddleHeight / 2.0f;
+    SimInput input;
+    input.up = ai.targetY < paddleCenter - OPPONENT_DEAD_ZONE;
+    input.down = ai.targetY > paddleCenter + OPPONENT_DEAD_ZONE;
+    input.axis = 0;
+    return input;
+}
+
+float SimRandomFloat(unsigned int &seed, float minValue, float maxValue) {
+    seed = seed * 1664525u + 1013904223u;
+    return minValue + (maxValue - minValue) * ((seed >> 8) / 16777216.0f);
+}
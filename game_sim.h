@@ -0,0 +1,170 @@
+#ifndef GAME_SIM_H
+#define GAME_SIM_H
+
+// Game rules as a pure simulation: state and inputs in, events out.
+// No window, audio or file access happens here, so the same rules run in
+// the game, the headless runner and the analysis tools.
+
+// Playfield dimensions
+const int screenWidth = 1700;
+const int screenHeight = 980;
+
+// Ball and paddle properties
+const int ballRadius = 10;
+const int paddleWidth = 10;
+const int paddleHeight = 100;
+const float paddleX = 30.0f;
+constexpr float BALL_SPEED_SLOW = 300.0f;     // Very slow and easy to play
+constexpr float BALL_SPEED_MEDIUM = 600.0f;   // Balanced speed
+constexpr float BALL_SPEED_FAST = 1000.0f;     // Very challenging speed
+constexpr float paddleSpeed = 450.0f;
+const int MAX_BOUNCES_PER_STEP = 8;  // Contacts resolved within one simulation tick
+
+// Two-paddle mode: a computer paddle mirrors the player's at the right wall
+const float opponentX = screenWidth - paddleX - paddleWidth;
+const int OPPONENT_MISS_POINTS = 5;     // Added to the score when the ball gets past the opponent
+
+// What the ball touched first during a step
+enum BallContact {
+    CONTACT_NONE,
+    CONTACT_TOP_WALL,
+    CONTACT_BOTTOM_WALL,
+    CONTACT_RIGHT_WALL,
+    CONTACT_LEFT_WALL,
+    CONTACT_PADDLE,
+    CONTACT_OPPONENT
+};
+
+// Tunable rules; DEFAULT_SIM_PARAMS matches the constants above
+struct SimParams {
+    float paddleSpeed;
+    float maxBounceAngle;   // Degrees, reached when the ball hits the paddle's end
+    float speedUpPerHit;    // Ball speed multiplier applied on each paddle hit
+};
+
+// The standard rules as compile-time configuration, for SimStepRules below
+struct DefaultRules {
+    static constexpr float paddleSpeed = ::paddleSpeed;
+    static constexpr float maxBounceAngle = 60.0f;
+    static constexpr float speedUpPerHit = 1.05f;
+};
+const SimParams DEFAULT_SIM_PARAMS = {DefaultRules::paddleSpeed, DefaultRules::maxBounceAngle, DefaultRules::speedUpPerHit};
+
+// Ball speed presets, as the options screen and replays name them. The
+// serve speed is only read when a game is reset, so it stays a run-time
+// setting rather than a template parameter.
+enum BallSpeedPreset {
+    BALL_SPEED_PRESET_SLOW,
+    BALL_SPEED_PRESET_MEDIUM,
+    BALL_SPEED_PRESET_FAST,
+    BALL_SPEED_PRESET_COUNT
+};
+const float BALL_SPEED_PRESETS[BALL_SPEED_PRESET_COUNT] = {BALL_SPEED_SLOW, BALL_SPEED_MEDIUM, BALL_SPEED_FAST};
+
+// Preset closest to a serve speed, for replays that store the speed itself
+BallSpeedPreset BallSpeedPresetFor(float ballSpeed);
+
+
+// Everything needed to continue a game from one tick to the next
+struct GameSimState {
+    float ballX, ballY;
+    float ballVelocityX, ballVelocityY;
+    float paddleY;
+    int score;
+    bool gameOver;
+    long long tick;
+    bool opponent;      // Two-paddle mode; otherwise the right side is a wall
+    float opponentY;
+};
+
+// Paddle controls for one tick. An analog axis (gamepad stick, mouse) is
+// quantized to whole 1/127ths of full speed so replays reproduce it exactly.
+const int SIM_AXIS_MAX = 127;
+struct SimInput {
+    bool up;
+    bool down;
+    signed char axis;   // -SIM_AXIS_MAX (full speed up) to SIM_AXIS_MAX; when nonzero, up and down are ignored
+};
+
+// What happened during one tick, for the caller to turn into sounds, UI, etc.
+struct SimEvents {
+    int wallBounces;
+    int paddleHits;
+    bool gameOver;
+    float hardestImpact;    // Largest ball speed into a wall or a paddle, pixels/s; 0 without contacts
+    int opponentHits;
+    int opponentMisses;     // Ball got past the opponent and was served again
+};
+
+// Computer paddle that follows the ball, aiming to hit it aimOffset pixels from the paddle center
+struct PaddleAI {
+    float aimOffset;
+    float deadZone;     // Stop moving when this close to the target
+};
+
+// PaddleAI that only sees where the ball was reactionTicks ago
+const int MAX_REACTION_TICKS = 256;
+struct DelayedPaddleAI {
+    PaddleAI aim;
+    int reactionTicks;                      // 0 to MAX_REACTION_TICKS - 1; DelayedPaddleAIReset clamps to this
+    float seenBallY[MAX_REACTION_TICKS];    // Ring buffer of past ball heights
+    int next;                               // Ring buffer slot written next
+};
+
+// Opponent strengths, easiest first; OPPONENT_NONE plays against the wall
+enum OpponentLevel {
+    OPPONENT_NONE,
+    OPPONENT_EASY,
+    OPPONENT_MEDIUM,
+    OPPONENT_HARD,
+    OPPONENT_LEVEL_COUNT
+};
+
+struct OpponentLevelParams {
+    const char* name;
+    float reactionSeconds;  // Delay before reacting to the ball changing direction
+    float aimError;         // Largest miss of the predicted intercept, pixels
+};
+extern const OpponentLevelParams opponentLevels[OPPONENT_LEVEL_COUNT];
+
+// Opponent paddle that predicts where the ball will cross its face. It
+// decides once per shot, reactionTicks after the ball turns toward it (or
+// away, when it heads back to the middle), so each tick costs a compare
+// unless a decision is due, and a decision is one PredictBallY call.
+struct PredictorAI {
+    int reactionTicks;
+    float aimError;
+    unsigned int seed;      // Draws the aim error, so replays repeat it
+    bool approaching;       // Ball direction the current plan is for
+    int waitTicks;          // Ticks left before the next decision, -1 once decided
+    float targetY;          // Paddle center the AI is moving to
+};
+
+// Height at which the ball's center will reach x, following its current
+// velocity with reflections off the top and bottom walls. Constant time.
+// Returns the current height if the ball is not moving toward x.
+float PredictBallY(const GameSimState &state, float x);
+
+void SimReset(GameSimState &state, float ballSpeed, bool opponent = false);
+SimEvents SimStep(GameSimState &state, const SimInput &input, float deltaTime, const SimParams &params = DEFAULT_SIM_PARAMS);
+// Two-paddle step; opponentInput moves the right paddle
+SimEvents SimStepVersus(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime,
+                        const SimParams &params = DEFAULT_SIM_PARAMS);
+SimInput PaddleAIInput(const PaddleAI &ai, const GameSimState &state);
+void DelayedPaddleAIReset(DelayedPaddleAI &ai, const PaddleAI &aim, int reactionTicks, const GameSimState &state);
+SimInput DelayedPaddleAIInput(DelayedPaddleAI &ai, const GameSimState &state);
+void PredictorAIReset(PredictorAI &ai, OpponentLevel level, int tickRate, unsigned int seed);
+SimInput PredictorAIInput(PredictorAI &ai, const GameSimState &state);
+
+// SimStep and SimStepVersus compiled for a fixed rule set, with its values
+// folded into constants instead of read from a SimParams every tick, and
+// with the two-paddle test resolved at compile time. Instantiated for
+// DefaultRules, with which they play out bit for bit as SimStep does.
+template <class Rules> SimEvents SimStepRules(GameSimState &state, const SimInput &input, float deltaTime);
+template <class Rules> SimEvents SimStepVersusRules(GameSimState &state, const SimInput &input,
+                                                    const SimInput &opponentInput, float deltaTime);
+
+// Small deterministic random generator for tools that vary games by seed
+float SimRandomFloat(unsigned int &seed, float minValue, float maxValue);
+
+#endif
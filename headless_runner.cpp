@@ -0,0 +1,407 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <strings.h>
+#include "game_sim.h"
+#include "batch_sim.h"
+#include "replay.h"
+
+using namespace std;
+
+// Runs games through the simulation rules with no window, audio or files,
+// as fast as the CPU allows. Examples:
+//   ./ping_pong_headless --games 1000 --rate 240 --speed fast --paddle ai
+//   ./ping_pong_headless --games 1000 --opponent hard
+//   ./ping_pong_headless --games 1000 --step generic
+//   ./ping_pong_headless --games 100000 --engine batch --path avx2
+//   ./ping_pong_headless --verify
+//   ./ping_pong_headless --replay replays/1700000000-ann.ppr
+
+// Which paddle controller plays the games
+enum PaddleMode {
+    PADDLE_AI,       // Follows the ball with a random aim offset per game
+    PADDLE_SCRIPT    // Sweeps up and down on a fixed timer, ignoring the ball
+};
+
+// How the games are stepped
+enum Engine {
+    ENGINE_SCALAR,   // One game at a time through SimStep
+    ENGINE_BATCH     // Many games at once through BatchStep (AI paddle only)
+};
+
+// Which step the scalar engine uses
+enum StepMode {
+    STEP_SPECIALIZED,   // SimStepRules, with the default rules compiled in
+    STEP_GENERIC        // SimStep, reading the rules from a SimParams every tick
+};
+
+struct RunnerOptions {
+    int games;
+    int tickRate;
+    BallSpeedPreset ballSpeed;
+    PaddleMode paddleMode;
+    unsigned int seed;
+    double maxGameSeconds;  // Games still running after this long are stopped
+    Engine engine;
+    BatchPath batchPath;
+    int batchSize;          // Lanes stepped together by the batch engine
+    bool verify;
+    const char* replayPath;     // Replay to check instead of running games
+    OpponentLevel opponent;     // Computer paddle on the right wall (scalar engine only)
+    StepMode step;
+};
+
+// Totals over all games in a run
+struct RunResults {
+    long long ticks;
+    long long totalScore;
+    int bestScore;
+    int timedOut;
+    long long opponentHits;
+    long long opponentMisses;
+};
+
+const float AI_DEAD_ZONE = 2.0f;
+
+void PrintUsage() {
+    cout << "Usage: ping_pong_headless [--games N] [--rate HZ] [--speed slow|medium|fast]" << endl;
+    cout << "                          [--paddle ai|script] [--seed S] [--max-seconds T]" << endl;
+    cout << "                          [--engine scalar|batch] [--path scalar|sse|avx2] [--batch-size N]" << endl;
+    cout << "                          [--opponent none|easy|medium|hard] [--step specialized|generic]" << endl;
+    cout << "                          [--verify] [--replay FILE]" << endl;
+}
+
+bool ParseOptions(int argc, char** argv, RunnerOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+            continue;
+        }
+
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) return false;
+
+        if (strcmp(arg, "--games") == 0) options.games = atoi(value);
+        else if (strcmp(arg, "--rate") == 0) options.tickRate = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) options.seed = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--max-seconds") == 0) options.maxGameSeconds = atof(value);
+        else if (strcmp(arg, "--batch-size") == 0) options.batchSize = atoi(value);
+        else if (strcmp(arg, "--replay") == 0) options.replayPath = value;
+        else if (strcmp(arg, "--speed") == 0) {
+            if (strcmp(value, "slow") == 0) options.ballSpeed = BALL_SPEED_PRESET_SLOW;
+            else if (strcmp(value, "medium") == 0) options.ballSpeed = BALL_SPEED_PRESET_MEDIUM;
+            else if (strcmp(value, "fast") == 0) options.ballSpeed = BALL_SPEED_PRESET_FAST;
+            else return false;
+        }
+        else if (strcmp(arg, "--paddle") == 0) {
+            if (strcmp(value, "ai") == 0) options.paddleMode = PADDLE_AI;
+            else if (strcmp(value, "script") == 0) options.paddleMode = PADDLE_SCRIPT;
+            else return false;
+        }
+        else if (strcmp(arg, "--opponent") == 0) {
+            int level = 0;
+            while (level < OPPONENT_LEVEL_COUNT && strcasecmp(value, opponentLevels[level].name) != 0) level++;
+            if (strcmp(value, "none") == 0) level = OPPONENT_NONE;
+            else if (level == OPPONENT_LEVEL_COUNT) return false;
+            options.opponent = (OpponentLevel)level;
+        }
+        else if (strcmp(arg, "--step") == 0) {
+            if (strcmp(value, "specialized") == 0) options.step = STEP_SPECIALIZED;
+            else if (strcmp(value, "generic") == 0) options.step = STEP_GENERIC;
+            else return false;
+        }
+        else if (strcmp(arg, "--engine") == 0) {
+            if (strcmp(value, "scalar") == 0) options.engine = ENGINE_SCALAR;
+            else if (strcmp(value, "batch") == 0) options.engine = ENGINE_BATCH;
+            else return false;
+        }
+        else if (strcmp(arg, "--path") == 0) {
+            if (strcmp(value, "scalar") == 0) options.batchPath = BATCH_PATH_SCALAR;
+            else if (strcmp(value, "sse") == 0) options.batchPath = BATCH_PATH_SSE;
+            else if (strcmp(value, "avx2") == 0) options.batchPath = BATCH_PATH_AVX2;
+            else return false;
+        }
+        else return false;
+        i++;
+    }
+    if (options.engine == ENGINE_BATCH && (options.paddleMode != PADDLE_AI || options.opponent != OPPONENT_NONE)) return false;
+    return options.games > 0 && options.tickRate > 0 && options.maxGameSeconds > 0 && options.batchSize > 0;
+}
+
+// Scripted paddle: one second up, one second down
+SimInput ScriptedInput(const GameSimState &state, int tickRate) {
+    bool goingUp = (state.tick / tickRate) % 2 == 0;
+    SimInput input = {goingUp, !goingUp, 0};
+    return input;
+}
+
+// Each game hits with a different part of the paddle, so rallies differ
+vector<float> MakeAimOffsets(int games, unsigned int seed) {
+    vector<float> offsets(games);
+    for (int g = 0; g < games; g++) {
+        offsets[g] = SimRandomFloat(seed, -paddleHeight / 2.0f, paddleHeight / 2.0f);
+    }
+    return offsets;
+}
+
+void AddGameResult(RunResults &results, long long ticks, int score, bool gameOver) {
+    results.ticks += ticks;
+    results.totalScore += score;
+    if (score > results.bestScore) results.bestScore = score;
+    if (!gameOver) results.timedOut++;
+}
+
+// Steps through the runtime rules
+struct GenericStepper {
+    static SimEvents Step(GameSimState &state, const SimInput &input, float deltaTime) {
+        return SimStep(state, input, deltaTime);
+    }
+    static SimEvents StepVersus(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime) {
+        return SimStepVersus(state, input, opponentInput, deltaTime);
+    }
+};
+
+// Steps through a rule set compiled in
+template <class Rules>
+struct CompiledStepper {
+    static SimEvents Step(GameSimState &state, const SimInput &input, float deltaTime) {
+        return SimStepRules<Rules>(state, input, deltaTime);
+    }
+    static SimEvents StepVersus(GameSimState &state, const SimInput &input, const SimInput &opponentInput, float deltaTime) {
+        return SimStepVersusRules<Rules>(state, input, opponentInput, deltaTime);
+    }
+};
+
+template <class Stepper>
+RunResults RunScalar(const RunnerOptions &options, const vector<float> &aimOffsets) {
+    const float tickTime = 1.0f / options.tickRate;
+    const long long maxTicks = (long long)(options.maxGameSeconds * options.tickRate);
+    RunResults results = {0, 0, 0, 0, 0, 0};
+
+    for (int g = 0; g < options.games; g++) {
+        GameSimState state;
+        SimReset(state, BALL_SPEED_PRESETS[options.ballSpeed], options.opponent != OPPONENT_NONE);
+        PaddleAI ai = {aimOffsets[g], AI_DEAD_ZONE};
+        PredictorAI opponent;
+        PredictorAIReset(opponent, options.opponent, options.tickRate, options.seed + g);
+
+        while (!state.gameOver && state.tick < maxTicks) {
+            SimInput input = options.paddleMode == PADDLE_AI ? PaddleAIInput(ai, state) : ScriptedInput(state, options.tickRate);
+            if (options.opponent == OPPONENT_NONE) {
+                Stepper::Step(state, input, tickTime);
+            } else {
+                SimEvents events = Stepper::StepVersus(state, input, PredictorAIInput(opponent, state), tickTime);
+                results.opponentHits += events.opponentHits;
+                results.opponentMisses += events.opponentMisses;
+            }
+        }
+        AddGameResult(results, state.tick, state.score, state.gameOver);
+    }
+    return results;
+}
+
+// Picks the step once for the whole run
+RunResults RunScalar(const RunnerOptions &options, const vector<float> &aimOffsets) {
+    if (options.step == STEP_GENERIC) return RunScalar<GenericStepper>(options, aimOffsets);
+    return RunScalar<CompiledStepper<DefaultRules> >(options, aimOffsets);
+}
+
+RunResults RunBatch(const RunnerOptions &options, const vector<float> &aimOffsets) {
+    const float tickTime = 1.0f / options.tickRate;
+    const int maxTicks = (int)(options.maxGameSeconds * options.tickRate);
+    const int refillInterval = 64;  // Ticks between collecting finished lanes
+    RunResults results = {0, 0, 0, 0, 0, 0};
+
+    BatchSim batch;
+    BatchInit(batch, options.batchSize < options.games ? options.batchSize : options.games, AI_DEAD_ZONE);
+
+    // Game running in each lane, or -1 once the lane is idle
+    vector<int> laneGame(batch.capacity, -1);
+    int nextGame = 0;
+    int running = 0;
+    for (int lane = 0; lane < batch.capacity && nextGame < options.games; lane++) {
+        BatchResetLane(batch, lane, BALL_SPEED_PRESETS[options.ballSpeed], aimOffsets[nextGame]);
+        laneGame[lane] = nextGame++;
+        running++;
+    }
+
+    while (running > 0) {
+        for (int t = 0; t < refillInterval; t++) {
+            BatchStep(batch, tickTime, maxTicks, options.batchPath);
+        }
+
+        // Record finished games and load the next ones into their lanes
+        for (int lane = 0; lane < batch.lanes; lane++) {
+            if (laneGame[lane] < 0) continue;
+            if (!batch.gameOver[lane] && batch.tick[lane] < maxTicks) continue;
+
+            AddGameResult(results, batch.tick[lane], batch.score[lane], batch.gameOver[lane] != 0);
+            if (nextGame < options.games) {
+                BatchResetLane(batch, lane, BALL_SPEED_PRESETS[options.ballSpeed], aimOffsets[nextGame]);
+                laneGame[lane] = nextGame++;
+            } else {
+                batch.gameOver[lane] = 1;
+                laneGame[lane] = -1;
+                running--;
+            }
+        }
+
+        // Once no games are left to start, pack the long-running ones together
+        // so the tail of the run does not step mostly idle lanes
+        if (nextGame >= options.games && running > 0 && running * 2 <= batch.lanes) {
+            int packed = 0;
+            for (int lane = 0; lane < batch.lanes; lane++) {
+                if (laneGame[lane] < 0) continue;
+                if (lane != packed) {
+                    BatchMoveLane(batch, lane, packed);
+                    laneGame[packed] = laneGame[lane];
+                    laneGame[lane] = -1;
+                    batch.gameOver[lane] = 1;
+                }
+                packed++;
+            }
+            batch.lanes = (packed + BATCH_LANE_ALIGN - 1) / BATCH_LANE_ALIGN * BATCH_LANE_ALIGN;
+        }
+    }
+
+    BatchFree(batch);
+    return results;
+}
+
+// Steps the same games through SimStep and through every batch path, tick by
+// tick, and reports the first lane whose state differs in any bit
+bool VerifyBatchPaths(const RunnerOptions &options, const vector<float> &aimOffsets) {
+    const float tickTime = 1.0f / options.tickRate;
+    const int maxTicks = (int)(options.maxGameSeconds * options.tickRate);
+    const int games = options.games;
+    bool allMatch = true;
+
+    BatchPath paths[] = {BATCH_PATH_SCALAR, BATCH_PATH_SSE, BATCH_PATH_AVX2};
+    for (int p = 0; p < 3; p++) {
+        if (!BatchPathAvailable(paths[p])) {
+            cout << "verify " << BatchPathName(paths[p]) << ": not built" << endl;
+            continue;
+        }
+
+        vector<GameSimState> states(games);
+        BatchSim batch;
+        BatchInit(batch, games, AI_DEAD_ZONE);
+        for (int g = 0; g < games; g++) {
+            SimReset(states[g], BALL_SPEED_PRESETS[options.ballSpeed]);
+            BatchResetLane(batch, g, BALL_SPEED_PRESETS[options.ballSpeed], aimOffsets[g]);
+        }
+
+        bool match = true;
+        int running = games;
+        long long laneTicks = 0;
+        for (int t = 0; t < maxTicks && running > 0 && match; t++) {
+            BatchStep(batch, tickTime, maxTicks, paths[p]);
+
+            running = 0;
+            for (int g = 0; g < games && match; g++) {
+                GameSimState &state = states[g];
+                if (!state.gameOver && state.tick < maxTicks) {
+                    PaddleAI ai = {aimOffsets[g], AI_DEAD_ZONE};
+                    SimStep(state, PaddleAIInput(ai, state), tickTime);
+                    laneTicks++;
+                }
+                if (!state.gameOver && state.tick < maxTicks) running++;
+
+                GameSimState laneState;
+                BatchLoadLane(batch, g, laneState);
+                match = memcmp(&laneState.ballX, &state.ballX, sizeof(float)) == 0
+                     && memcmp(&laneState.ballY, &state.ballY, sizeof(float)) == 0
+                     && memcmp(&laneState.ballVelocityX, &state.ballVelocityX, sizeof(float)) == 0
+                     && memcmp(&laneState.ballVelocityY, &state.ballVelocityY, sizeof(float)) == 0
+                     && memcmp(&laneState.paddleY, &state.paddleY, sizeof(float)) == 0
+                     && laneState.score == state.score
+                     && laneState.gameOver == state.gameOver
+                     && laneState.tick == state.tick;
+                if (!match) {
+                    cout << "verify " << BatchPathName(paths[p]) << ": game " << g << " differs at tick " << t + 1 << endl;
+                }
+            }
+        }
+        if (match) {
+            cout << "verify " << BatchPathName(paths[p]) << ": " << games << " games, " << laneTicks << " match-ticks identical" << endl;
+        }
+        allMatch = allMatch && match;
+        BatchFree(batch);
+    }
+    return allMatch;
+}
+
+// Replays a recorded game through SimStep and checks it ends in the recorded state
+bool CheckReplay(const char* path) {
+    Replay replay;
+    if (!ReadReplay(path, replay)) {
+        cout << "Could not read replay " << path << endl;
+        return false;
+    }
+
+    GameSimState finalState;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool match = ReplayVerify(replay, finalState);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double playSeconds = (double)replay.header.ticks / replay.header.tickRate;
+    cout << "replay:       " << path << endl;
+    cout << "settings:     ball speed " << replay.header.ballSpeed << ", " << replay.header.tickRate << " Hz, "
+         << ((replay.header.flags & REPLAY_DARK_THEME) ? "dark" : "light") << " theme, opponent "
+         << opponentLevels[ReplayOpponent(replay.header)].name << endl;
+    cout << "recorded:     " << replay.header.ticks << " ticks (" << playSeconds << " s), score " << replay.header.finalScore << endl;
+    cout << "size:         " << sizeof(ReplayHeader) + replay.inputs.size() << " bytes ("
+         << (playSeconds > 0 ? replay.inputs.size() / playSeconds : 0.0) << " input bytes/s)" << endl;
+    cout << "replayed:     " << finalState.tick << " ticks, score " << finalState.score << " in " << seconds * 1000.0 << " ms" << endl;
+    cout << "checksum:     " << (match ? "match" : "MISMATCH") << endl;
+    return match;
+}
+
+int main(int argc, char** argv) {
+    RunnerOptions options = {1000, 240, BALL_SPEED_PRESET_MEDIUM, PADDLE_AI, 1, 600.0, ENGINE_SCALAR, BestBatchPath(), 4096, false, NULL,
+                             OPPONENT_NONE, STEP_SPECIALIZED};
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+    if (!BatchPathAvailable(options.batchPath)) {
+        cout << "Batch path " << BatchPathName(options.batchPath) << " is not available in this build" << endl;
+        return 1;
+    }
+
+    if (options.replayPath) {
+        return CheckReplay(options.replayPath) ? 0 : 1;
+    }
+
+    vector<float> aimOffsets = MakeAimOffsets(options.games, options.seed);
+
+    if (options.verify) {
+        return VerifyBatchPaths(options, aimOffsets) ? 0 : 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    RunResults results = options.engine == ENGINE_BATCH ? RunBatch(options, aimOffsets) : RunScalar(options, aimOffsets);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "engine:       " << (options.engine == ENGINE_BATCH ? "batch/" : "scalar/");
+    if (options.engine == ENGINE_BATCH) cout << BatchPathName(options.batchPath);
+    else cout << (options.step == STEP_GENERIC ? "generic" : "specialized");
+    cout << endl;
+    cout << "games:        " << options.games << " (" << results.timedOut << " stopped at " << options.maxGameSeconds << " s)" << endl;
+    cout << "ticks:        " << results.ticks << " at " << options.tickRate << " Hz" << endl;
+    cout << "mean score:   " << (double)results.totalScore / options.games << endl;
+    cout << "best score:   " << results.bestScore << endl;
+    if (options.opponent != OPPONENT_NONE) {
+        cout << "opponent:     " << opponentLevels[options.opponent].name << ", returned " << results.opponentHits
+             << ", missed " << results.opponentMisses << " ("
+             << 100.0 * results.opponentMisses / max(1LL, results.opponentHits + results.opponentMisses) << "%)" << endl;
+    }
+    cout << "wall time:    " << seconds << " s" << endl;
+    cout << "games/sec:    " << options.games / seconds << endl;
+    cout << "ticks/sec:    " << results.ticks / seconds << endl;
+    return 0;
+}
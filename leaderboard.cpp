@@ -0,0 +1,306 @@
+#include "leaderboard.h"
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+const int INITIAL_PLAYER_SLOTS = 64;
+
+static int Size(const Leaderboard &board, int entry) {
+    return entry < 0 ? 0 : board.nodes[entry].size;
+}
+
+static void UpdateSize(Leaderboard &board, int entry) {
+    LeaderboardNode &node = board.nodes[entry];
+    node.size = 1 + Size(board, node.left) + Size(board, node.right);
+}
+
+// True if entry a is listed before entry b
+static bool Precedes(const Leaderboard &board, int a, int b) {
+    int scoreA = board.nodes[a].score;
+    int scoreB = board.nodes[b].score;
+    return scoreA > scoreB || (scoreA == scoreB && a < b);
+}
+
+static unsigned int NextPriority(Leaderboard &board) {
+    // xorshift32
+    unsigned int x = board.randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    board.randomState = x;
+    return x;
+}
+
+// Splits a subtree into the entries listed before key and the rest
+static void Split(Leaderboard &board, int tree, int key, int &before, int &after) {
+    if (tree < 0) {
+        before = after = -1;
+        return;
+    }
+    if (Precedes(board, tree, key)) {
+        Split(board, board.nodes[tree].right, key, board.nodes[tree].right, after);
+        before = tree;
+    } else {
+        Split(board, board.nodes[tree].left, key, before, board.nodes[tree].left);
+        after = tree;
+    }
+    UpdateSize(board, tree);
+}
+
+// Joins two subtrees where every entry of a is listed before every entry of b
+static int Merge(Leaderboard &board, int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    if (board.nodes[a].priority > board.nodes[b].priority) {
+        board.nodes[a].right = Merge(board, board.nodes[a].right, b);
+        UpdateSize(board, a);
+        return a;
+    }
+    board.nodes[b].left = Merge(board, a, board.nodes[b].left);
+    UpdateSize(board, b);
+    return b;
+}
+
+static void InsertNode(Leaderboard &board, int entry) {
+    int before, after;
+    Split(board, board.root, entry, before, after);
+    board.root = Merge(board, Merge(board, before, entry), after);
+    if (board.topEntry < 0 || Precedes(board, entry, board.topEntry)) board.topEntry = entry;
+}
+
+static int RemoveNode(Leaderboard &board, int tree, int entry) {
+    if (tree == entry) {
+        return Merge(board, board.nodes[tree].left, board.nodes[tree].right);
+    }
+    if (Precedes(board, entry, tree)) {
+        board.nodes[tree].left = RemoveNode(board, board.nodes[tree].left, entry);
+    } else {
+        board.nodes[tree].right = RemoveNode(board, board.nodes[tree].right, entry);
+    }
+    UpdateSize(board, tree);
+    return tree;
+}
+
+static int FirstEntry(const Leaderboard &board) {
+    int entry = board.root;
+    while (entry >= 0 && board.nodes[entry].left >= 0) entry = board.nodes[entry].left;
+    return entry;
+}
+
+static unsigned int HashName(const char* name) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (; *name; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Slot holding the player's entries, or the empty slot where they would go
+static int FindPlayerSlot(const Leaderboard &board, const char* name) {
+    int mask = (int)board.playerSlots.size() - 1;
+    int slot = (int)(HashName(name) & mask);
+    while (board.playerSlots[slot] >= 0 && strcmp(LeaderboardName(board, board.playerSlots[slot]), name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void GrowPlayerSlots(Leaderboard &board) {
+    vector<int> oldSlots, oldLatest;
+    oldSlots.swap(board.playerSlots);
+    oldLatest.swap(board.playerLatest);
+    board.playerSlots.assign(oldSlots.size() * 2, -1);
+    board.playerLatest.assign(oldSlots.size() * 2, -1);
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+        if (oldSlots[i] < 0) continue;
+        int slot = FindPlayerSlot(board, LeaderboardName(board, oldSlots[i]));
+        board.playerSlots[slot] = oldSlots[i];
+        board.playerLatest[slot] = oldLatest[i];
+    }
+}
+
+void LeaderboardInit(Leaderboard &board) {
+    board.randomState = 2463534242u;
+    LeaderboardClear(board);
+}
+
+void LeaderboardClear(Leaderboard &board) {
+    board.nodes.clear();
+    board.names.clear();
+    board.playerSlots.assign(INITIAL_PLAYER_SLOTS, -1);
+    board.playerLatest.assign(INITIAL_PLAYER_SLOTS, -1);
+    board.playerCount = 0;
+    board.root = -1;
+    board.topEntry = -1;
+}
+
+int LeaderboardAppend(Leaderboard &board, const char* name, int score) {
+    int entry = (int)board.nodes.size();
+
+    LeaderboardNode node;
+    node.score = score;
+    node.priority = NextPriority(board);
+    node.size = 1;
+    node.left = node.right = -1;
+    node.nameOffset = (int)board.names.size();
+    node.playerNext = -1;
+
+    // Names are stored cut to MAX_NAME_LENGTH - 1 characters, like the name input
+    size_t length = strlen(name);
+    if (length > (size_t)MAX_NAME_LENGTH - 1) length = MAX_NAME_LENGTH - 1;
+    board.names.insert(board.names.end(), name, name + length);
+    board.names.push_back('\0');
+    board.nodes.push_back(node);
+
+    // Link into the player's entries and keep their best one indexed
+    if ((board.playerCount + 1) * 2 > (int)board.playerSlots.size()) GrowPlayerSlots(board);
+    int slot = FindPlayerSlot(board, LeaderboardName(board, entry));
+    if (board.playerSlots[slot] < 0) {
+        board.playerSlots[slot] = entry;
+        board.playerCount++;
+    } else {
+        board.nodes[entry].playerNext = board.playerLatest[slot];
+        if (Precedes(board, entry, board.playerSlots[slot])) board.playerSlots[slot] = entry;
+    }
+    board.playerLatest[slot] = entry;
+    return entry;
+}
+
+int LeaderboardAdd(Leaderboard &board, const char* name, int score) {
+    int entry = LeaderboardAppend(board, name, score);
+    InsertNode(board, entry);
+    return entry;
+}
+
+static int ComputeSizes(Leaderboard &board, int tree) {
+    if (tree < 0) return 0;
+    LeaderboardNode &node = board.nodes[tree];
+    node.size = 1 + ComputeSizes(board, node.left) + ComputeSizes(board, node.right);
+    return node.size;
+}
+
+void LeaderboardRebuild(Leaderboard &board) {
+    int count = (int)board.nodes.size();
+
+    // Sort by listing order: highest score first, then submission order
+    vector<pair<int, int> > order(count);
+    for (int i = 0; i < count; i++) order[i] = make_pair(-board.nodes[i].score, i);
+    sort(order.begin(), order.end());
+
+    // Build the treap over the sorted entries in one pass, keeping the
+    // right spine on a stack
+    vector<int> spine;
+    for (int i = 0; i < count; i++) {
+        int entry = order[i].second;
+        LeaderboardNode &node = board.nodes[entry];
+        node.left = node.right = -1;
+        int last = -1;
+        while (!spine.empty() && board.nodes[spine.back()].priority < node.priority) {
+            last = spine.back();
+            spine.pop_back();
+        }
+        node.left = last;
+        if (!spine.empty()) board.nodes[spine.back()].right = entry;
+        spine.push_back(entry);
+    }
+    board.root = spine.empty() ? -1 : spine[0];
+    ComputeSizes(board, board.root);
+    board.topEntry = count > 0 ? order[0].second : -1;
+}
+
+void LeaderboardSetScore(Leaderboard &board, int entry, int score) {
+    board.root = RemoveNode(board, board.root, entry);
+    LeaderboardNode &node = board.nodes[entry];
+    int oldScore = node.score;
+    node.score = score;
+    node.left = node.right = -1;
+    node.size = 1;
+    if (board.topEntry == entry) board.topEntry = FirstEntry(board);
+    InsertNode(board, entry);
+
+    // Only lowering the player's best entry can hand the title to another
+    // of their entries, and only then is their chain walked
+    int slot = FindPlayerSlot(board, LeaderboardName(board, entry));
+    int best = board.playerSlots[slot];
+    if (best != entry) {
+        if (Precedes(board, entry, best)) board.playerSlots[slot] = entry;
+    } else if (score < oldScore) {
+        for (int e = board.playerLatest[slot]; e >= 0; e = board.nodes[e].playerNext) {
+            if (Precedes(board, e, best)) best = e;
+        }
+        board.playerSlots[slot] = best;
+    }
+}
+
+int LeaderboardSize(const Leaderboard &board) {
+    return (int)board.nodes.size();
+}
+
+int LeaderboardPlayerCount(const Leaderboard &board) {
+    return board.playerCount;
+}
+
+const char* LeaderboardName(const Leaderboard &board, int entry) {
+    return &board.names[board.nodes[entry].nameOffset];
+}
+
+int LeaderboardScore(const Leaderboard &board, int entry) {
+    return board.nodes[entry].score;
+}
+
+int LeaderboardTopScore(const Leaderboard &board) {
+    return board.topEntry < 0 ? 0 : board.nodes[board.topEntry].score;
+}
+
+int LeaderboardRankOf(const Leaderboard &board, int entry) {
+    int rank = 1;
+    int tree = board.root;
+    while (tree != entry) {
+        if (Precedes(board, entry, tree)) {
+            tree = board.nodes[tree].left;
+        } else {
+            rank += Size(board, board.nodes[tree].left) + 1;
+            tree = board.nodes[tree].right;
+        }
+    }
+    return rank + Size(board, board.nodes[entry].left);
+}
+
+int LeaderboardRankForScore(const Leaderboard &board, int score) {
+    // Count entries scoring at least this much; a new game is listed after them
+    int count = 0;
+    int tree = board.root;
+    while (tree >= 0) {
+        if (board.nodes[tree].score >= score) {
+            count += Size(board, board.nodes[tree].left) + 1;
+            tree = board.nodes[tree].right;
+        } else {
+            tree = board.nodes[tree].left;
+        }
+    }
+    return count + 1;
+}
+
+int LeaderboardEntryAtRank(const Leaderboard &board, int rank) {
+    if (rank < 1 || rank > LeaderboardSize(board)) return -1;
+    int tree = board.root;
+    while (true) {
+        int leftSize = Size(board, board.nodes[tree].left);
+        if (rank <= leftSize) {
+            tree = board.nodes[tree].left;
+        } else if (rank == leftSize + 1) {
+            return tree;
+        } else {
+            rank -= leftSize + 1;
+            tree = board.nodes[tree].right;
+        }
+    }
+}
+
+int LeaderboardFindPlayer(const Leaderboard &board, const char* name) {
+    return board.playerSlots[FindPlayerSlot(board, name)];
+}
@@ -0,0 +1,68 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <vector>
+
+// In-memory leaderboard: every submitted game is an entry, ordered by score
+// (highest first, ties in submission order). Entries live in a treap with
+// subtree sizes, so insert, update and rank queries are O(log n); a hash
+// index maps each player name to their best entry.
+
+const int MAX_NAME_LENGTH = 50;
+
+struct LeaderboardNode {
+    int score;
+    unsigned int priority;  // Treap heap priority
+    int size;               // Entries in this subtree
+    int left, right;        // Child entries, -1 when empty
+    int nameOffset;         // Start of the name in Leaderboard::names
+    int playerNext;         // Previous entry by the same player, -1 for their first
+};
+
+struct Leaderboard {
+    std::vector<LeaderboardNode> nodes;     // Indexed by entry id, in submission order
+    std::vector<char> names;                // Null-terminated names back to back
+    std::vector<int> playerSlots;           // Open-addressing name index: best entry, or -1
+    std::vector<int> playerLatest;          // Latest entry per slot, heads the playerNext chain
+    int playerCount;
+    int root;
+    int topEntry;                           // Cached first entry, -1 when empty
+    unsigned int randomState;
+};
+
+void LeaderboardInit(Leaderboard &board);
+void LeaderboardClear(Leaderboard &board);
+
+// Adds one game and returns its entry id. O(log n)
+int LeaderboardAdd(Leaderboard &board, const char* name, int score);
+
+// Bulk loading: append any number of games, then order them all at once
+// with LeaderboardRebuild in O(n log n). Queries are invalid in between.
+int LeaderboardAppend(Leaderboard &board, const char* name, int score);
+void LeaderboardRebuild(Leaderboard &board);
+
+// Changes the score of an existing entry. O(log n), plus a walk over the
+// player's entries when their best entry is lowered.
+void LeaderboardSetScore(Leaderboard &board, int entry, int score);
+
+int LeaderboardSize(const Leaderboard &board);
+int LeaderboardPlayerCount(const Leaderboard &board);
+const char* LeaderboardName(const Leaderboard &board, int entry);
+int LeaderboardScore(const Leaderboard &board, int entry);
+
+// Highest score, or 0 when empty. O(1)
+int LeaderboardTopScore(const Leaderboard &board);
+
+// 1-based position of an entry. O(log n)
+int LeaderboardRankOf(const Leaderboard &board, int entry);
+
+// 1-based position a new game with this score would take. O(log n)
+int LeaderboardRankForScore(const Leaderboard &board, int score);
+
+// Entry at a 1-based position, or -1 if out of range. O(log n)
+int LeaderboardEntryAtRank(const Leaderboard &board, int rank);
+
+// Best entry of a player, or -1 if they have none. O(1) on average
+int LeaderboardFindPlayer(const Leaderboard &board, const char* name);
+
+#endif
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "leaderboard.h"
+#include "score_log.h"
+#include "score_view.h"
+#include "score_store.h"
+#include "score_protocol.h"
+#include "player_stats.h"
+
+using namespace std;
+
+// Owns the score log for every game on the machine and answers them over
+// a Unix domain socket (see score_protocol.h), so cabinets sharing a
+// machine share one ranking and one writer. Examples:
+//   ./leaderboard_daemon
+//   ./leaderboard_daemon --socket /tmp/kiosk.sock --log /var/lib/ping_pong/scores.bin --stats /var/lib/ping_pong/players.bin
+//
+// One thread serves every connection from a poll loop. All requests that
+// arrived since the last wakeup are answered together, and the score
+// store's worker writes all the games submitted meanwhile with one write
+// and one sync, so a burst of submissions costs one disk flush.
+
+const int MAX_CONNECTIONS = 1024;
+const size_t READ_CHUNK = 64 * 1024;
+const size_t MAX_PENDING_OUTPUT = 1 << 20;  // Stop reading a client that does not read its answers
+
+struct Connection {
+    int fd;
+    vector<unsigned char> in;
+    vector<unsigned char> out;
+    size_t sent;                // Bytes of out already written
+};
+
+struct DaemonStats {
+    long long connections;
+    long long requests;
+    long long submits;
+    long long badRequests;
+};
+
+Leaderboard board;
+DaemonStats stats = {0, 0, 0, 0};
+volatile sig_atomic_t stopRequested = 0;
+
+void RequestStop(int) {
+    stopRequested = 1;
+}
+
+void Answer(const ScoreRequest &request, const char* name, vector<unsigned char> &out) {
+    ScoreAnswerHeader header = {request.id, request.op, SCORE_STATUS_OK, 0, 0, 0, 0, 0};
+    int first = 0;
+    int rows = 0;
+    bool withStats = false;
+    switch (request.op) {
+        case SCORE_OP_SUBMIT:
+            if (name[0] == '\0') {
+                header.status = SCORE_STATUS_BAD_REQUEST;
+                break;
+            }
+            ScoreStoreSubmit(board, name, request.value, request.rally, request.ballSpeed);
+            // Entries are numbered in submission order, so the new game is the last
+            header.rank = LeaderboardRankOf(board, LeaderboardSize(board) - 1);
+            header.score = request.value;
+            stats.submits++;
+            break;
+        case SCORE_OP_TOP:
+            first = 1;
+            rows = request.count;
+            break;
+        case SCORE_OP_RANGE:
+            first = request.value;
+            rows = request.count;
+            if (first < 1) header.status = SCORE_STATUS_BAD_REQUEST;
+            break;
+        case SCORE_OP_PLAYER_RANK:
+        case SCORE_OP_PLAYER_STATS: {
+            withStats = request.op == SCORE_OP_PLAYER_STATS;
+            int entry = LeaderboardFindPlayer(board, name);
+            if (entry >= 0) {
+                header.rank = LeaderboardRankOf(board, entry);
+                header.score = LeaderboardScore(board, entry);
+            }
+            break;
+        }
+        default:
+            header.status = SCORE_STATUS_BAD_REQUEST;
+            break;
+    }
+    if (header.status != SCORE_STATUS_OK) stats.badRequests++;
+
+    header.total = LeaderboardSize(board);
+    header.topScore = LeaderboardTopScore(board);
+    if (header.status == SCORE_STATUS_OK && first > 0) {
+        // Clients reject answers longer than MAX_SCORE_ROWS, so longer asks get the first rows
+        if (rows > MAX_SCORE_ROWS) rows = MAX_SCORE_ROWS;
+        if (rows > header.total - first + 1) rows = header.total - first + 1;
+        if (rows < 0) rows = 0;
+        header.rank = first;
+        header.rowCount = (uint16_t)rows;
+    }
+    EncodeScoreAnswer(out, header);
+    for (int i = 0; i < header.rowCount; i++) {
+        int entry = LeaderboardEntryAtRank(board, first + i);
+        EncodeScoreRow(out, LeaderboardName(board, entry), LeaderboardScore(board, entry));
+    }
+    if (withStats) EncodePlayerSummary(out, PlayerStatsSummary(ScoreStoreStats(), name));
+    stats.requests++;
+}
+
+// Reads everything available and answers every complete request. False
+// when the client hung up or sent something that is not a request.
+bool ServeInput(Connection &connection) {
+    unsigned char chunk[READ_CHUNK];
+    while (true) {
+        ssize_t got = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (got > 0) {
+            connection.in.insert(connection.in.end(), chunk, chunk + got);
+            if ((size_t)got < sizeof(chunk)) break;
+        } else if (got == 0) {
+            return false;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            break;
+        }
+    }
+
+    size_t offset = 0;
+    ScoreRequest request;
+    char name[MAX_NAME_LENGTH];
+    while (true) {
+        int used = DecodeScoreRequest(connection.in.data() + offset, connection.in.size() - offset, request, name);
+        if (used < 0) return false;
+        if (used == 0) break;
+        Answer(request, name, connection.out);
+        offset += used;
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+    return true;
+}
+
+// Writes as much of the pending answers as the socket takes. False if the client is gone.
+bool FlushOutput(Connection &connection) {
+    while (connection.sent < connection.out.size()) {
+        ssize_t wrote = send(connection.fd, &connection.out[connection.sent], connection.out.size() - connection.sent, MSG_NOSIGNAL);
+        if (wrote > 0) {
+            connection.sent += wrote;
+        } else if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    connection.out.clear();
+    connection.sent = 0;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* socketPath = SCORE_SOCKET_DEFAULT;
+    const char* logPath = "scores.bin";
+    const char* legacyPath = "scores.txt";
+    const char* statsPath = "players.bin";
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--socket") == 0 && value) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0 && value) {
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "--legacy") == 0 && value) {
+            legacyPath = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0 && value) {
+            statsPath = argv[++i];
+        } else {
+            cerr << "usage: " << argv[0] << " [--socket PATH] [--log scores.bin] [--legacy scores.txt] [--stats players.bin]" << endl;
+            return 1;
+        }
+    }
+
+    int listener = ScoreListen(socketPath);
+    if (listener < 0) {
+        cerr << "Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    // The whole log goes into one Leaderboard, so every query is O(log n).
+    // The log is never compacted: the board ranks every game, and the ranks
+    // and totals already sent to clients have to hold after a restart.
+    chrono::steady_clock::time_point loadStart = chrono::steady_clock::now();
+    LeaderboardInit(board);
+    ScoreStoreStart(logPath, legacyPath, statsPath, false);
+    ScoreLogView history;
+    ScoreLogViewInit(history);
+    while (!ScoreStorePoll(history)) usleep(1000);
+    for (int r = 0; r < ScoreLogViewCount(history); r++) {
+        const ScoreRecord &record = ScoreLogViewRecord(history, r);
+        if (ScoreRecordValid(record)) LeaderboardAppend(board, record.name, record.score);
+    }
+    LeaderboardRebuild(board);
+    ScoreLogViewClose(history);
+    double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+    printf("Loaded %d scores from %s and %d players from %s in %.1f ms; listening on %s\n", LeaderboardSize(board), logPath,
+           (int)ScoreStoreStats().players.size(), statsPath, loadMs, socketPath);
+    fflush(stdout);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = RequestStop;     // No SA_RESTART, so poll returns
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    vector<Connection> connections;
+    vector<pollfd> polls;
+    while (!stopRequested) {
+        polls.resize(connections.size() + 1);
+        polls[0].fd = listener;
+        polls[0].events = connections.size() < (size_t)MAX_CONNECTIONS ? POLLIN : 0;
+        for (size_t i = 0; i < connections.size(); i++) {
+            const Connection &connection = connections[i];
+            polls[i + 1].fd = connection.fd;
+            polls[i + 1].events = (connection.out.size() - connection.sent < MAX_PENDING_OUTPUT ? POLLIN : 0)
+                                | (connection.sent < connection.out.size() ? POLLOUT : 0);
+            polls[i + 1].revents = 0;
+        }
+        if (poll(&polls[0], polls.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "poll failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        // Serve the clients first, so the new ones line up with polls
+        size_t kept = 0;
+        for (size_t i = 0; i < connections.size(); i++) {
+            Connection &connection = connections[i];
+            short events = polls[i + 1].revents;
+            bool open = true;
+            if (events & (POLLIN | POLLHUP | POLLERR)) open = ServeInput(connection);
+            if (open && connection.sent < connection.out.size()) open = FlushOutput(connection);
+            if (!open) {
+                close(connection.fd);
+                continue;
+            }
+            if (kept != i) swap(connections[kept], connection);
+            kept++;
+        }
+        connections.resize(kept);
+
+        if (polls[0].revents & POLLIN) {
+            while (connections.size() < (size_t)MAX_CONNECTIONS) {
+                int fd = accept(listener, NULL, NULL);
+                if (fd < 0) break;
+                SetNonBlocking(fd);
+                Connection connection;
+                connection.fd = fd;
+                connection.sent = 0;
+                connections.push_back(connection);
+                stats.connections++;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < connections.size(); i++) close(connections[i].fd);
+    close(listener);
+    unlink(socketPath);
+    ScoreStoreStop();   // Writes out the games still queued
+    printf("Served %lld requests (%lld games submitted, %lld bad) over %lld connections\n",
+           stats.requests, stats.submits, stats.badRequests, stats.connections);
+    return 0;
+}
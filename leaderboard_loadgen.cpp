@@ -0,0 +1,278 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "score_protocol.h"
+
+using namespace std;
+
+// Measures leaderboard_daemon under many concurrent clients: requests per
+// second and latency percentiles, overall and per request type. Each
+// client keeps --depth requests in flight on its own connection; threads
+// share the clients out and drive them from poll loops. It submits games,
+// so give the daemon a scratch log:
+//   ./leaderboard_daemon --socket /tmp/load.sock --log /tmp/load.bin &
+//   ./leaderboard_loadgen --socket /tmp/load.sock --clients 256 --depth 4 --seconds 10
+
+const int LOAD_PLAYERS = 1000;      // Distinct names submitted and looked up
+const int LOAD_RANGE_ROWS = 20;     // One leaderboard screen
+const int LOAD_TOP_ROWS = 10;
+
+struct LoadOptions {
+    const char* socketPath;
+    int clients;
+    int threads;
+    int depth;              // Requests in flight per client
+    double seconds;
+    int submitPercent;      // The rest: half ranges, a sixth each player ranks, player stats and top lists
+};
+
+struct InFlight {
+    uint32_t id;
+    ScoreOp op;
+    chrono::steady_clock::time_point sent;
+};
+
+struct LoadClient {
+    int fd;
+    vector<unsigned char> out;
+    size_t sent;
+    vector<unsigned char> in;
+    deque<InFlight> inFlight;
+    uint32_t nextId;
+    unsigned int seed;
+    int total;              // Board size from the latest answer
+};
+
+// Latency samples in microseconds, by ScoreOp
+struct LoadResult {
+    vector<float> latencyUs[SCORE_OP_PLAYER_STATS + 1];
+    long long errors;
+};
+
+unsigned int NextRandom(unsigned int &seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+void SendRandomRequest(LoadClient &client, const LoadOptions &options) {
+    unsigned int roll = NextRandom(client.seed) % 100;
+    char name[MAX_NAME_LENGTH];
+    snprintf(name, sizeof(name), "load_%u", NextRandom(client.seed) % LOAD_PLAYERS);
+
+    InFlight request;
+    request.id = client.nextId++;
+    request.sent = chrono::steady_clock::now();
+    int rest = (int)roll - options.submitPercent;
+    int others = 100 - options.submitPercent;
+    if (rest < 0) {
+        request.op = SCORE_OP_SUBMIT;
+        EncodeScoreRequest(client.out, request.id, request.op, name, (int)(NextRandom(client.seed) % 100000), 0,
+                           (int)(NextRandom(client.seed) % 200), (float)(NextRandom(client.seed) % 3000));
+    } else if (rest < others / 2) {
+        request.op = SCORE_OP_RANGE;
+        int first = 1 + (int)(NextRandom(client.seed) % (unsigned)(client.total > 0 ? client.total : 1));
+        EncodeScoreRequest(client.out, request.id, request.op, "", first, LOAD_RANGE_ROWS);
+    } else if (rest < others * 2 / 3) {
+        request.op = SCORE_OP_PLAYER_RANK;
+        EncodeScoreRequest(client.out, request.id, request.op, name, 0, 0);
+    } else if (rest < others * 5 / 6) {
+        request.op = SCORE_OP_PLAYER_STATS;
+        EncodeScoreRequest(client.out, request.id, request.op, name, 0, 0);
+    } else {
+        request.op = SCORE_OP_TOP;
+        EncodeScoreRequest(client.out, request.id, request.op, "", 0, LOAD_TOP_ROWS);
+    }
+    client.inFlight.push_back(request);
+}
+
+// False if the connection failed
+bool Flush(LoadClient &client) {
+    while (client.sent < client.out.size()) {
+        ssize_t wrote = send(client.fd, &client.out[client.sent], client.out.size() - client.sent, MSG_NOSIGNAL);
+        if (wrote > 0) {
+            client.sent += wrote;
+        } else if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return wrote < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    client.out.clear();
+    client.sent = 0;
+    return true;
+}
+
+// Takes in the answers, timing each and replacing it with a new request
+// unless the run is over. False if the connection failed.
+bool Receive(LoadClient &client, const LoadOptions &options, bool sendMore, LoadResult &result) {
+    unsigned char chunk[64 * 1024];
+    while (true) {
+        ssize_t got = recv(client.fd, chunk, sizeof(chunk), 0);
+        if (got > 0) {
+            client.in.insert(client.in.end(), chunk, chunk + got);
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    size_t offset = 0;
+    ScoreAnswer answer;
+    while (true) {
+        int used = DecodeScoreAnswer(client.in.data() + offset, client.in.size() - offset, answer);
+        if (used == 0) break;
+        if (used < 0 || client.inFlight.empty() || answer.header.id != client.inFlight.front().id) return false;
+        const InFlight &request = client.inFlight.front();
+        if (answer.header.status != SCORE_STATUS_OK) result.errors++;
+        result.latencyUs[request.op].push_back((float)chrono::duration<double, micro>(now - request.sent).count());
+        client.total = answer.header.total;
+        client.inFlight.pop_front();
+        offset += used;
+        if (sendMore) SendRandomRequest(client, options);
+    }
+    client.in.erase(client.in.begin(), client.in.begin() + offset);
+    return true;
+}
+
+void RunClients(const LoadOptions &options, int firstClient, int clientCount,
+                chrono::steady_clock::time_point deadline, LoadResult &result) {
+    vector<LoadClient> clients;
+    for (int i = 0; i < clientCount; i++) {
+        LoadClient client;
+        client.fd = ScoreConnect(options.socketPath);
+        if (client.fd < 0 || !SetNonBlocking(client.fd)) {
+            result.errors++;
+            if (client.fd >= 0) close(client.fd);
+            continue;
+        }
+        client.sent = 0;
+        client.nextId = 1;
+        client.seed = 12345u + (unsigned)(firstClient + i) * 7919u;
+        client.total = 0;
+        for (int d = 0; d < options.depth; d++) SendRandomRequest(client, options);
+        clients.push_back(client);
+    }
+
+    vector<pollfd> polls(clients.size());
+    bool running = true;
+    while (running || any_of(clients.begin(), clients.end(), [](const LoadClient &c) { return !c.inFlight.empty(); })) {
+        if (running && chrono::steady_clock::now() >= deadline) running = false;
+        for (size_t i = 0; i < clients.size(); i++) {
+            polls[i].fd = clients[i].fd;
+            polls[i].events = POLLIN | (clients[i].sent < clients[i].out.size() ? POLLOUT : 0);
+            polls[i].revents = 0;
+        }
+        if (poll(polls.data(), polls.size(), 100) < 0 && errno != EINTR) break;
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            LoadClient &client = clients[i];
+            bool ok = true;
+            if (polls[i].revents & (POLLIN | POLLHUP | POLLERR)) ok = Receive(client, options, running, result);
+            if (ok) ok = Flush(client);
+            if (!ok) {
+                result.errors++;
+                close(client.fd);
+                client.fd = -1;
+                client.inFlight.clear();
+            }
+        }
+        clients.erase(remove_if(clients.begin(), clients.end(), [](const LoadClient &c) { return c.fd < 0; }), clients.end());
+        polls.resize(clients.size());
+    }
+    for (size_t i = 0; i < clients.size(); i++) close(clients[i].fd);
+}
+
+void PrintLatency(const char* label, vector<float> &samples, double seconds) {
+    if (samples.empty()) return;
+    sort(samples.begin(), samples.end());
+    printf("  %-12s %10.0f req/s   p50 %7.3f ms   p99 %7.3f ms   max %7.3f ms\n", label, samples.size() / seconds,
+           samples[samples.size() / 2] / 1000.0, samples[samples.size() * 99 / 100] / 1000.0, samples.back() / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    LoadOptions options = {SCORE_SOCKET_DEFAULT, 64, 0, 4, 5.0, 10};
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--socket") == 0 && value) {
+            options.socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && value) {
+            options.clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && value) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && value) {
+            options.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && value) {
+            options.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--submit-percent") == 0 && value) {
+            options.submitPercent = atoi(argv[++i]);
+        } else {
+            cerr << "usage: " << argv[0] << " [--socket PATH] [--clients 64] [--threads N] [--depth 4]"
+                 << " [--seconds 5] [--submit-percent 10]" << endl;
+            return 1;
+        }
+    }
+    if (options.clients < 1 || options.depth < 1 || options.seconds <= 0.0 || options.submitPercent < 0 || options.submitPercent > 100) {
+        cerr << "--clients and --depth must be at least 1, --seconds positive, --submit-percent 0 to 100" << endl;
+        return 1;
+    }
+    if (options.threads < 1) options.threads = (int)thread::hardware_concurrency();
+    if (options.threads < 1) options.threads = 1;
+    if (options.threads > options.clients) options.threads = options.clients;
+
+    int probe = ScoreConnect(options.socketPath);
+    if (probe < 0) {
+        cerr << "No leaderboard daemon on " << options.socketPath << endl;
+        return 1;
+    }
+    close(probe);
+
+    vector<LoadResult> results(options.threads);
+    vector<thread> threads;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point deadline = start + chrono::microseconds((long long)(options.seconds * 1e6));
+    int first = 0;
+    for (int t = 0; t < options.threads; t++) {
+        int count = options.clients / options.threads + (t < options.clients % options.threads ? 1 : 0);
+        results[t].errors = 0;
+        threads.push_back(thread(RunClients, cref(options), first, count, deadline, ref(results[t])));
+        first += count;
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    LoadResult total;
+    total.errors = 0;
+    vector<float> all;
+    for (size_t t = 0; t < results.size(); t++) {
+        total.errors += results[t].errors;
+        for (int op = SCORE_OP_SUBMIT; op <= SCORE_OP_PLAYER_STATS; op++) {
+            vector<float> &samples = results[t].latencyUs[op];
+            total.latencyUs[op].insert(total.latencyUs[op].end(), samples.begin(), samples.end());
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+    }
+
+    printf("%d clients on %d threads, %d in flight each, %.1f s, %lld errors\n",
+           options.clients, options.threads, options.depth, seconds, total.errors);
+    PrintLatency("all", all, seconds);
+    PrintLatency("submit", total.latencyUs[SCORE_OP_SUBMIT], seconds);
+    PrintLatency("top", total.latencyUs[SCORE_OP_TOP], seconds);
+    PrintLatency("range", total.latencyUs[SCORE_OP_RANGE], seconds);
+    PrintLatency("player rank", total.latencyUs[SCORE_OP_PLAYER_RANK], seconds);
+    PrintLatency("player stats", total.latencyUs[SCORE_OP_PLAYER_STATS], seconds);
+    return total.errors > 0 ? 1 : 0;
+}
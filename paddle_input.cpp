@@ -0,0 +1,132 @@
+#include "paddle_input.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+const char* paddleDeviceNames[3] = {"keyboard", "gamepad", "mouse"};
+
+void PaddleInputInit(PaddleInput &input, bool subFrame) {
+    PaddleInputSample empty = {0.0, false, false, 0.0f, (float)screenHeight / 2, DEVICE_KEYBOARD};
+    input.previous = input.current = empty;
+    input.subFrame = subFrame;
+    input.latencyLog = NULL;
+    input.changePending = false;
+    input.changeTime = input.changePollTime = 0.0;
+    input.latencies.clear();
+}
+
+bool PaddleInputLogLatency(PaddleInput &input, const char* path) {
+    input.latencyLog = fopen(path, "w");
+    if (!input.latencyLog) return false;
+    fprintf(input.latencyLog, "device,change_ms,poll_ms,submit_ms,present_ms,latency_ms\n");
+    return true;
+}
+
+static float StickValue(float raw) {
+    if (fabsf(raw) < GAMEPAD_DEAD_ZONE) return 0.0f;
+    float scaled = (fabsf(raw) - GAMEPAD_DEAD_ZONE) / (1.0f - GAMEPAD_DEAD_ZONE);
+    return raw < 0 ? -fminf(scaled, 1.0f) : fminf(scaled, 1.0f);
+}
+
+void PaddleInputPoll(PaddleInput &input, double now) {
+    PaddleInputSample sample = input.current;
+    sample.time = now;
+
+    bool keyUp = IsKeyDown(KEY_UP);
+    bool keyDown = IsKeyDown(KEY_DOWN);
+    bool padUp = false, padDown = false;
+    sample.stick = 0.0f;
+    if (IsGamepadAvailable(0)) {
+        padUp = IsGamepadButtonDown(0, GAMEPAD_BUTTON_LEFT_FACE_UP);
+        padDown = IsGamepadButtonDown(0, GAMEPAD_BUTTON_LEFT_FACE_DOWN);
+        sample.stick = StickValue(GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_Y));
+    }
+    float mouseY = GetMousePosition().y;
+
+    // Whichever device was touched last takes over
+    if (keyUp || keyDown) sample.device = DEVICE_KEYBOARD;
+    else if (padUp || padDown || sample.stick != 0.0f) sample.device = DEVICE_GAMEPAD;
+    else if (mouseY != input.current.mouseY) sample.device = DEVICE_MOUSE;
+    sample.up = keyUp || padUp;
+    sample.down = keyDown || padDown;
+    sample.mouseY = mouseY;
+
+    bool changed = sample.up != input.current.up || sample.down != input.current.down
+                || sample.stick != input.current.stick
+                || (sample.device == DEVICE_MOUSE && sample.mouseY != input.current.mouseY);
+    if (changed && input.latencyLog && !input.changePending) {
+        input.changePending = true;
+        input.changePollTime = now;
+        input.changeTime = (input.current.time + now) / 2;
+    }
+
+    input.previous = input.current;
+    input.current = sample;
+}
+
+void PaddleInputReset(PaddleInput &input, double now) {
+    PaddleInputPoll(input, now);
+    input.current.device = DEVICE_KEYBOARD;
+    input.previous = input.current;
+    input.changePending = false;
+}
+
+// Axis value that moves the paddle by delta pixels this tick, or as far as it can
+static signed char AxisFor(float delta, float tickSeconds) {
+    float fullSpeed = DEFAULT_SIM_PARAMS.paddleSpeed * tickSeconds;
+    float axis = roundf(delta / fullSpeed * SIM_AXIS_MAX);
+    return (signed char)fmaxf(-SIM_AXIS_MAX, fminf(SIM_AXIS_MAX, axis));
+}
+
+SimInput PaddleInputAt(const PaddleInput &input, double tickTime, float tickSeconds, const GameSimState &state) {
+    const PaddleInputSample &before = input.previous;
+    const PaddleInputSample &after = input.current;
+
+    // Where the tick falls between the last two polls
+    float blend = 1.0f;
+    if (input.subFrame && after.time > before.time) {
+        blend = (float)((tickTime - before.time) / (after.time - before.time));
+        blend = fmaxf(0.0f, fminf(1.0f, blend));
+    }
+
+    SimInput sim = {false, false, 0};
+    if (after.device == DEVICE_MOUSE) {
+        float targetY = before.mouseY + (after.mouseY - before.mouseY) * blend;
+        float paddleCenter = state.paddleY + paddleHeight / 2.0f;
+        sim.axis = AxisFor(targetY - paddleCenter, tickSeconds);
+    } else {
+        const PaddleInputSample &keys = blend >= 0.5f ? after : before;
+        sim.up = keys.up;
+        sim.down = keys.down;
+        float stick = before.stick + (after.stick - before.stick) * blend;
+        if (after.device == DEVICE_GAMEPAD && stick != 0.0f) {
+            sim.axis = (signed char)roundf(stick * SIM_AXIS_MAX);
+        }
+    }
+    return sim;
+}
+
+void PaddleInputPresented(PaddleInput &input, double submitTime, double presentTime) {
+    if (!input.changePending) return;
+    input.changePending = false;
+    double latencyMs = (presentTime - input.changeTime) * 1000.0;
+    input.latencies.push_back(latencyMs);
+    fprintf(input.latencyLog, "%s,%.3f,%.3f,%.3f,%.3f,%.3f\n", paddleDeviceNames[input.current.device],
+            input.changeTime * 1000.0, input.changePollTime * 1000.0, submitTime * 1000.0, presentTime * 1000.0, latencyMs);
+}
+
+void PaddleInputClose(PaddleInput &input) {
+    if (!input.latencyLog) return;
+    fclose(input.latencyLog);
+    input.latencyLog = NULL;
+    if (input.latencies.empty()) return;
+
+    vector<double> sorted = input.latencies;
+    sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (size_t i = 0; i < sorted.size(); i++) total += sorted[i];
+    printf("Input latency over %d changes (%s): mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           (int)sorted.size(), input.subFrame ? "sub-frame" : "per frame", total / sorted.size(),
+           sorted[sorted.size() / 2], sorted[sorted.size() * 99 / 100], sorted.back());
+}
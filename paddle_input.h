@@ -0,0 +1,81 @@
+#ifndef PADDLE_INPUT_H
+#define PADDLE_INPUT_H
+
+#include <cstdio>
+#include <vector>
+#include "raylib.h"
+#include "game_sim.h"
+
+// Paddle input for the fixed-step simulation. Raylib delivers input once
+// per frame, when EndDrawing polls events, but the ticks run in a frame
+// stand for the time since the previous poll. Each poll is timestamped,
+// and every tick gets the input as it most likely was at the moment that
+// tick represents rather than the latest poll:
+//   - a key pressed or released between two polls is taken to have
+//     changed halfway between them, the expected time of the change;
+//   - gamepad axes and the mouse are interpolated between the two polls.
+// That way a key held for 50 ms moves the paddle 50 ms worth at any frame
+// rate, instead of a whole number of frames' worth.
+//
+// Keyboard, gamepad and mouse all end up as a SimInput. The device used
+// last drives the paddle: the arrow keys, the left stick or D-pad, or the
+// mouse, whose height the paddle follows at up to full paddle speed.
+
+enum PaddleDevice {
+    DEVICE_KEYBOARD,
+    DEVICE_GAMEPAD,
+    DEVICE_MOUSE
+};
+
+extern const char* paddleDeviceNames[3];
+
+const float GAMEPAD_DEAD_ZONE = 0.15f;  // Stick travel ignored around the center
+
+// Input as read at one poll
+struct PaddleInputSample {
+    double time;
+    bool up;            // Keyboard or D-pad
+    bool down;
+    float stick;        // Left stick Y, dead zone removed, -1 to 1
+    float mouseY;
+    PaddleDevice device;
+};
+
+struct PaddleInput {
+    PaddleInputSample previous;
+    PaddleInputSample current;
+    bool subFrame;                  // False applies each poll to the whole frame, as before
+
+    // Latency measurement: from an input change to the end of the frame
+    // that shows its effect
+    FILE* latencyLog;               // CSV, NULL when not measuring
+    bool changePending;
+    double changeTime;              // Estimated time of the change
+    double changePollTime;
+    std::vector<double> latencies;  // Milliseconds
+};
+
+void PaddleInputInit(PaddleInput &input, bool subFrame);
+
+// Starts logging latencies to a CSV file
+bool PaddleInputLogLatency(PaddleInput &input, const char* path);
+
+// Takes the devices as they are now as the starting point, with the
+// keyboard in control, so a mouse left over from the menus does not move
+// the paddle
+void PaddleInputReset(PaddleInput &input, double now);
+
+// Reads the devices; call once per frame, before running ticks
+void PaddleInputPoll(PaddleInput &input, double now);
+
+// Input for the tick that ends at tickTime, in GetTime seconds
+SimInput PaddleInputAt(const PaddleInput &input, double tickTime, float tickSeconds, const GameSimState &state);
+
+// Call with the times just before and after EndDrawing. The later one
+// includes raylib's frame rate wait, so latencies are upper bounds.
+void PaddleInputPresented(PaddleInput &input, double submitTime, double presentTime);
+
+// Prints the latency summary and closes the log
+void PaddleInputClose(PaddleInput &input);
+
+#endif
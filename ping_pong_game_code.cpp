@@ -1,42 +1,224 @@
 #include "raylib.h"
+#include "rlgl.h"
 #include <iostream>
-#include <fstream>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <cmath>
+#include <cctype>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include "game_sim.h"
+#include "leaderboard.h"
+#include "score_view.h"
+#include "score_store.h"
+#include "ui_layout.h"
+#include "profiler.h"
+#include "replay.h"
+#include "paddle_input.h"
+#include "display.h"
+#include "game_assets.h"
+#include "audio_queue.h"
+#include "stress_field.h"
+#include "score_client.h"
+#include "player_stats.h"
 
 using namespace std;
 
-// Window dimensions
-const int screenWidth = 1700;
-const int screenHeight = 980;
+// Currently selected ball speed preset
+BallSpeedPreset ballSpeedPreset = BALL_SPEED_PRESET_MEDIUM;
 
-// Ball and paddle properties
-const int ballRadius = 10;
-const int paddleWidth = 10;
-const int paddleHeight = 100;
-const float BALL_SPEED_SLOW = 300.0f;     // Very slow and easy to play
-const float BALL_SPEED_MEDIUM = 600.0f;   // Balanced speed
-const float BALL_SPEED_FAST = 1000.0f;     // Very challenging speed
-float currentBallSpeed = BALL_SPEED_MEDIUM;
-const float paddleSpeed = 450.0f;
+// Computer paddle on the right wall, or OPPONENT_NONE to play against the wall
+OpponentLevel opponentLevel = OPPONENT_NONE;
+PredictorAI opponentAI;
+
+// Fixed-timestep simulation settings
+const int SIM_RATE_LOW = 240;       // Ticks per second
+const int SIM_RATE_MEDIUM = 500;
+const int SIM_RATE_HIGH = 1000;
+int simTickRate = SIM_RATE_LOW;
+const float MAX_FRAME_TIME = 0.1f;  // Longer frames (window drag, stalls) are clamped to this
+
+// Simulation clock state, reset whenever a new game starts
+struct SimClock {
+    double accumulator;     // Unsimulated time carried over to the next frame
+    int ticksLastFrame;     // Ticks run during the most recent frame
+    long long totalTicks;   // Ticks run since the game started
+    double droppedTime;     // Total seconds discarded by frame time clamping
+};
+SimClock simClock = {0.0, 0, 0, 0.0};
+bool showSimStats = false;
+// The per-screen CPU and audio summaries are printed at exit only once F3
+// was used or with --trace or --input-latency
+bool exitReports = false;
 
 // Theme colors
 Color backgroundColor = BLACK;
 Color foregroundColor = WHITE;
 bool isDarkTheme = true;
 
+// Themes as compile-time configuration, for the playfield drawn every game frame
+struct DarkTheme {
+    static Color Background() { return BLACK; }
+    static Color Foreground() { return WHITE; }
+};
+struct LightTheme {
+    static Color Background() { return WHITE; }
+    static Color Foreground() { return BLACK; }
+};
+
+// Per-frame game paths compiled for the rules, the opponent mode and the
+// theme. Chosen by ChooseGameLoop whenever one of those settings changes,
+// so frames and ticks do not test them again.
+struct GameLoop {
+    float (*runSimulation)(float frameTime, GameSimState &state, GameSimState &prevState);
+    void (*drawPlayfield)(const GameSimState &state, const GameSimState &prevState, float alpha);
+};
+GameLoop gameLoop;
+
 // Button properties
 const int buttonWidth = 300;
 const int buttonHeight = 60;
 const int buttonSpacing = 80;
 const int buttonTextSize = 30;
 
-// Leaderboard constants
-const int MAX_NAME_LENGTH = 50;
-const int MAX_LEADERBOARD_ENTRIES = 100;
+// Global leaderboard: the score log mapped at startup plus this session's
+// games, indexed by score and player name. These are the authoritative
+// copy; scores.bin is written behind them by the score store.
+ScoreLogView scoreHistory;
+Leaderboard leaderboard;
+int leaderboardVersion = 1;         // Bumped whenever the scores change
+
+// With leaderboard_daemon running, every game on the machine keeps its
+// scores there instead (see score_client.h); scoreHistory and leaderboard
+// stay empty, and the game goes back to scores.bin if the daemon goes away
+bool scoreService = false;
+
+// Leaderboard screen: a virtual list that only draws the rows in view, so
+// its cost does not depend on how many scores there are. Formatted rows
+// and their widths are cached by rank until the scores change.
+const int leaderboardTop = 100;
+const int leaderboardRowHeight = 30;
+const int leaderboardVisibleRows = 20;
+const int ROW_CACHE_SIZE = 64;              // Power of two above the rows in view
+const double SCROLL_ROWS_PER_SECOND = 20.0;
+const double SCROLL_SMOOTHING = 12.0;       // How fast the view catches up, per second
+const int NAME_SEARCH_BUDGET = 250000;      // Log records searched per frame
+
+struct LeaderboardRow {
+    int rank;
+    int version;
+    char text[96];
+    int width;
+};
+
+struct LeaderboardScreen {
+    double scroll;              // Pixels from the top of the list; double stays exact past millions of rows
+    double targetScroll;
+    int highlightRank;          // Row picked by a jump, 0 for none
+    bool typingRank;
+    char rankInput[11];
+    bool searching;
+    int searchVersion;
+    RankedPlayerSearch search;
+    const char* status;
+    bool waitingForIndex;       // Showing placeholders until the background index is built
+    LeaderboardRow rows[ROW_CACHE_SIZE];
+};
+LeaderboardScreen leaderboardScreen;
+
+// What the game in progress adds to the player's stats besides the score.
+// A rally is the paddle hits between two points.
+struct GameRecords {
+    int rally;
+    int longestRally;
+    float maxBallSpeed;
+};
+GameRecords gameRecords = {0, 0, 0.0f};
+
+// This session's finished games, oldest first
+vector<SubmittedGame> sessionGames;
+
+// Stats panel beside the leaderboard, formatted once per player and data
+// change. The summary comes from the score store's stats in constant
+// time, or from the leaderboard service in one request.
+const int STATS_PANEL_LINES = 8;
+const int STATS_PANEL_SESSION_GAMES = 5;
+struct StatsPanel {
+    char name[MAX_NAME_LENGTH];
+    int version;
+    bool waiting;               // For the leaderboard service to answer
+    char lines[STATS_PANEL_LINES + STATS_PANEL_SESSION_GAMES][64];
+    int lineCount;
+};
+StatsPanel statsPanel;
+
+// Frame work timing: update and draw, not the wait inside EndDrawing
+double frameWorkMs = 0.0;
+double typicalFrameWorkMs = 0.0;    // Moving average
+double gameOverFrameWorkMs = 0.0;   // Frame in which the last game ended
+
+// Profiler overlay (F4): frame time graph, percentiles and section costs
+bool showProfiler = false;
+const float PROFILE_GRAPH_MS = 25.0f;   // Graph height in milliseconds
+const char* traceFile = NULL;           // --trace <file>: Chrome trace written at exit
+
+// Replays: every game is recorded and saved to replays/ when it ends. R on
+// the game over screen watches it again; --replay <file> opens a saved one.
+const int MAX_REPLAY_SPEED = 64;
+Replay recordedReplay;
+
+struct ReplayPlayback {
+    bool active;
+    Replay replay;
+    ReplayPlayer player;
+    int speed;                  // Simulated seconds per real second, 1 to MAX_REPLAY_SPEED
+    bool inputEnded;            // Ran out of input before the game ended
+    bool verified;              // Ended in exactly the recorded state
+    BallSpeedPreset savedBallSpeed;     // Settings before playback, restored after
+    int savedTickRate;
+    bool savedDarkTheme;
+    OpponentLevel savedOpponent;
+};
+ReplayPlayback playback;
+
+// Paddle input, sampled once per frame and spread over that frame's ticks
+PaddleInput paddleInput;
+
+// Window, frame rate and scaling of the playfield to the window
+Display display;
 
-// Global leaderboard arrays
-char leaderboardNames[MAX_LEADERBOARD_ENTRIES][MAX_NAME_LENGTH];
-int leaderboardScores[MAX_LEADERBOARD_ENTRIES];
+// Stress mode (--stress, or F6 on the menu): thousands of small balls and
+// their hit particles, drawn as one batch of textured quads rather than a
+// DrawCircleV each. Auto mode doubles the balls until frames miss
+// STRESS_AUTO_FPS, then bisects to the most that still hold it.
+const int STRESS_MAX_BALLS = 200000;
+const int STRESS_MAX_PARTICLES = 65536;
+const int STRESS_START_BALLS = 1000;
+const float STRESS_BALL_SPEED = 200.0f;
+const float STRESS_MAX_STEP = 1.0f / 30;    // Longer frames slow the balls down instead of letting them skip cells
+const int STRESS_AUTO_FPS = 120;
+const int STRESS_WARMUP_FRAMES = 15;        // Not measured after each change of ball count
+const int STRESS_SAMPLE_FRAMES = 90;        // Measured per ball count
+
+struct StressMode {
+    bool loaded;
+    StressField field;
+    Texture2D ballTexture;
+    double updateMs;        // Moving averages
+    double drawMs;
+    bool autoTune;
+    int holds;              // Most balls seen holding STRESS_AUTO_FPS
+    int misses;             // Fewest balls seen missing it, 0 before the first miss
+    int warmupFrames;
+    int sampleCount;
+    float samplesMs[STRESS_SAMPLE_FRAMES];
+    int savedTargetFps;     // Auto mode runs uncapped
+    int sustained;          // Auto mode's result, -1 until it finishes
+};
+StressMode stress;
 
 // Game states
 enum GameState {
@@ -44,111 +226,260 @@ enum GameState {
     GAME,
     LEADERBOARD,
     OPTIONS,
+    STRESS,
     QUIT
 };
 
+// Screens as far as UI timing is concerned; GAME is split by what it shows
+enum UiScreen {
+    SCREEN_MENU,
+    SCREEN_NAME_INPUT,
+    SCREEN_PLAYING,
+    SCREEN_PAUSED,
+    SCREEN_GAME_OVER,
+    SCREEN_LEADERBOARD,
+    SCREEN_OPTIONS,
+    SCREEN_STRESS,
+    SCREEN_COUNT
+};
+const char* uiScreenNames[SCREEN_COUNT] = {"Menu", "Name input", "Playing", "Paused", "Game over", "Leaderboard", "Options", "Stress"};
+double screenWorkMs[SCREEN_COUNT] = {0.0};     // Moving average of frame work per screen
+double screenCpuSeconds[SCREEN_COUNT] = {0.0};  // Process CPU time spent on each screen, waits included
+double screenWallSeconds[SCREEN_COUNT] = {0.0};
+
+// Screens with nothing moving sleep until input once this many frames in a
+// row had nothing to animate, so the frame after a change is always drawn
+const int IDLE_AFTER_FRAMES = 2;
+bool idleScreens = true;                        // --no-idle redraws every screen at the full rate
+
+// Options screen buttons, in layout order
+enum OptionButton {
+    OPTION_LIGHT,
+    OPTION_DARK,
+    OPTION_SLOW,
+    OPTION_MEDIUM,
+    OPTION_FAST,
+    OPTION_OPPONENT_FIRST,      // One button per OpponentLevel
+    OPTION_OPPONENT_LAST = OPTION_OPPONENT_FIRST + OPPONENT_LEVEL_COUNT - 1,
+    OPTION_RATE_LOW,
+    OPTION_RATE_MEDIUM,
+    OPTION_RATE_HIGH,
+    OPTION_FPS_FIRST,           // One button per FRAME_RATE_CHOICES entry
+    OPTION_FPS_LAST = OPTION_FPS_FIRST + FRAME_RATE_CHOICE_COUNT - 1,
+    OPTION_VSYNC,
+    OPTION_FULLSCREEN,
+    OPTION_MENU,
+    OPTION_BUTTON_COUNT
+};
+
+// Positions and text metrics for every screen, built once and again only
+// when the resolution or theme changes
+struct UiLayout {
+    bool built;
+    int width, height;
+    bool darkTheme;
+
+    UiLabel menuTitle;
+    UiButton menuButtons[4];
+
+    UiLabel optionHeadings[5];
+    UiButton optionButtons[OPTION_BUTTON_COUNT];
+
+    UiLabel pausedTitle;
+    UiLabel pausedHint;
+
+    UiLabel namePrompt;
+    int nameBoxY;
+
+    UiLabel gameOverTitle;
+    UiLabel gameOverHint;
+    UiLabel gameOverReplayHint;
+    UiLabel newHighScore;
+    UiLabel replayVerified;
+    UiLabel replayMismatch;
+    UiNumberText gameOverScore;
+    UiNumberText hudScore;
+
+    UiLabel leaderboardTitle;
+    UiLabel leaderboardEmpty;
+    UiLabel leaderboardHelp;
+    UiButton leaderboardMenuButton;
+    UiButton leaderboardClearButton;
+};
+UiLayout ui;
+
 // Sound effects (global)
 Sound bounceSound;
 Sound buttonSound;
 Sound gameoverSound;
 Sound highscoreSound;
+
+// Indexes into soundAssets
+enum GameSound {
+    SOUND_BOUNCE,
+    SOUND_BUTTON,
+    SOUND_GAMEOVER,
+    SOUND_HIGHSCORE
+};
+
+// Bounces sound louder and higher the faster the ball hits
+const float QUIET_IMPACT_SPEED = 200.0f;    // Quietest bounce at or below this speed
+const float LOUD_IMPACT_SPEED = 1500.0f;    // Full volume at or above this speed
+
+// Loaded in the background at startup; silent until then
+SoundAsset soundAssets[] = {
+    {"bounce.wav", 0.5f, &bounceSound},
+    {"button.wav", 0.5f, &buttonSound},
+    {"gameover.wav", 0.5f, &gameoverSound},
+    {"highscore.wav", 0.8f, &highscoreSound},  // Higher volume for high score sound
+};
 float transitionAlpha = 1.0f;
 
 // Function prototypes
-void UpdateGame(float deltaTime, Vector2 &ballPosition, Vector2 &ballVelocity, Rectangle &paddle, int &score, bool &gameOver);
-void ResetGame(Vector2 &ballPosition, Vector2 &ballVelocity, Rectangle &paddle, int &score, bool &gameOver);
-void SaveScore(const char* name, int score);
-int LoadLeaderboard();
-void SortLeaderboard(int size);
+template <class Rules, bool Versus> void UpdateGame(float deltaTime, double tickTime, GameSimState &state);
+template <class Rules, bool Versus> float RunSimulation(float frameTime, GameSimState &state, GameSimState &prevState);
+template <class Theme> void DrawPlayfield(const GameSimState &state, const GameSimState &prevState, float alpha);
+void ChooseGameLoop();
+void ResetSimClock();
+void DrawSimStats();
+void ResetGame(GameSimState &state);
 void HandleNameInput(char* playerName, bool &nameEntered);
 void DrawMenu(GameState& currentState);
-void DrawLeaderboard(int &leaderboardSize, int &scrollOffset, GameState &currentState);
+void DrawLeaderboard(int &leaderboardSize, const char* playerName, GameState &currentState);
+void DrawPlayerStats(const char* playerName);
 void DrawOptions(GameState &currentState);
 void DrawPaused();
 void HandlePause(bool &paused, GameState &currentState);
-int FindNameIndex(const char* name, int size);
 void ClearLeaderboard();
+int ScoreCount();
+int SubmitScore(const char* playerName, int score);
+int FallBackToLocalScores();
 void DrawTransition();
 bool IsHighScore(int score, int leaderboardSize);
+void BuildUiLayout();
+void PlayGameSound(int sound, float volume = 1.0f, float pitch = 1.0f);
+void SetTheme(bool dark);
+void StartReplay(const Replay &replay, GameSimState &state, GameSimState &prevState);
+void StopReplay();
+void SaveReplay(const char* playerName);
+void DrawReplayStatus();
+void DrawProfiler();
+FrameMode ChooseFrameMode(UiScreen screen, int &staticFrames);
+void PrintScreenCpuReport();
+void StressEnter(int balls, bool autoTune);
+void StressLeave();
+void UpdateStress(float frameTime);
+void DrawStress();
 
 // Other helper functions
-int FindNameIndex(const char* name, int size) {
-    for (int i = 0; i < size; i++) {
-        if (strcmp(name, leaderboardNames[i]) == 0) {
-            return i;
-        }
+void BuildUiLayout() {
+    int centerX = screenWidth / 2;
+    int centerY = screenHeight / 2;
+
+    // Main menu
+    ui.menuTitle = MakeCenteredLabel("Ping Pong Game", centerX, 100, 40);
+    const char* buttonTexts[] = {"Play", "Leaderboard", "Options", "Quit"};
+    for (int i = 0; i < 4; i++) {
+        Rectangle bounds = {
+            static_cast<float>(centerX - buttonWidth / 2),
+            static_cast<float>(centerY + (i - 1) * (buttonHeight + buttonSpacing)),
+            static_cast<float>(buttonWidth),
+            static_cast<float>(buttonHeight)
+        };
+        ui.menuButtons[i] = MakeButton(bounds, buttonTexts[i], buttonTextSize, 15);
     }
-    return -1;
-}
 
-void SortLeaderboard(int size) {
-    for (int i = 0; i < size - 1; i++) {
-        for (int j = 0; j < size - i - 1; j++) {
-            if (leaderboardScores[j] < leaderboardScores[j + 1]) {
-                // Swap scores
-                int tempScore = leaderboardScores[j];
-                leaderboardScores[j] = leaderboardScores[j + 1];
-                leaderboardScores[j + 1] = tempScore;
+    // Options: five rows of choices under their headings, then Main Menu
+    int optionsY = screenHeight / 3 - 60;
+    const int optionButtonWidth = 150;
+    const int optionButtonHeight = 40;
+    ui.optionHeadings[0] = MakeCenteredLabel("Theme", centerX, optionsY - 80, 40);
+    ui.optionHeadings[1] = MakeCenteredLabel("Ball Speed", centerX, optionsY + 60, 40);
+    ui.optionHeadings[2] = MakeCenteredLabel("Opponent", centerX, optionsY + 180, 40);
+    ui.optionHeadings[3] = MakeCenteredLabel("Simulation Rate", centerX, optionsY + 300, 40);
+    ui.optionHeadings[4] = MakeCenteredLabel("Frame Rate", centerX, optionsY + 420, 40);
 
-                // Swap names
-                char tempName[MAX_NAME_LENGTH];
-                strcpy(tempName, leaderboardNames[j]);
-                strcpy(leaderboardNames[j], leaderboardNames[j + 1]);
-                strcpy(leaderboardNames[j + 1], tempName);
-            }
-        }
+    const char* optionTexts[OPTION_BUTTON_COUNT] = {
+        "Light", "Dark", "Slow", "Medium", "Fast",
+        opponentLevels[0].name, opponentLevels[1].name, opponentLevels[2].name, opponentLevels[3].name,
+        "240 Hz", "500 Hz", "1000 Hz",
+        "60 FPS", "120 FPS", "144 FPS", "240 FPS", "500 FPS", "Uncapped", "VSync", "Fullscreen",
+        "Main Menu"
+    };
+    float optionX[OPTION_BUTTON_COUNT] = {
+        centerX - optionButtonWidth - 20.0f, centerX + 20.0f,
+        centerX - optionButtonWidth * 1.5f - 20, centerX - optionButtonWidth / 2.0f, centerX + optionButtonWidth / 2.0f + 20,
+        0, 0, 0, 0,
+        centerX - optionButtonWidth * 1.5f - 20, centerX - optionButtonWidth / 2.0f, centerX + optionButtonWidth / 2.0f + 20,
+        0, 0, 0, 0, 0, 0,
+        centerX - optionButtonWidth - 20.0f, centerX + 20.0f,
+        centerX - optionButtonWidth / 2.0f
+    };
+    int optionY[OPTION_BUTTON_COUNT] = {
+        optionsY - 20, optionsY - 20,
+        optionsY + 120, optionsY + 120, optionsY + 120,
+        optionsY + 240, optionsY + 240, optionsY + 240, optionsY + 240,
+        optionsY + 360, optionsY + 360, optionsY + 360,
+        optionsY + 480, optionsY + 480, optionsY + 480, optionsY + 480, optionsY + 480, optionsY + 480,
+        optionsY + 530, optionsY + 530,
+        optionsY + 600
+    };
+    for (int i = 0; i < OPPONENT_LEVEL_COUNT; i++) {
+        optionX[OPTION_OPPONENT_FIRST + i] = centerX - (OPPONENT_LEVEL_COUNT * (optionButtonWidth + 20) - 20) / 2.0f
+                                           + i * (optionButtonWidth + 20);
     }
-}
-
-void SaveScore(const char* name, int score) {
-    ofstream file("scores.txt", ios::app);
-    if (file.is_open()) {
-        file << name << " " << score << endl;
-        file.close();
+    for (int i = 0; i < FRAME_RATE_CHOICE_COUNT; i++) {
+        optionX[OPTION_FPS_FIRST + i] = centerX - (FRAME_RATE_CHOICE_COUNT * (optionButtonWidth + 20) - 20) / 2.0f
+                                      + i * (optionButtonWidth + 20);
+    }
+    for (int i = 0; i < OPTION_BUTTON_COUNT; i++) {
+        Rectangle bounds = {optionX[i], (float)optionY[i], (float)optionButtonWidth, (float)optionButtonHeight};
+        ui.optionButtons[i] = MakeButton(bounds, optionTexts[i], 20, 10);
     }
-}
 
-int LoadLeaderboard() {
-    ifstream file("scores.txt");
-    int count = 0;
+    // Pause and name entry
+    ui.pausedTitle = MakeCenteredLabel("Game Paused", centerX, centerY - 50, 60);
+    ui.pausedHint = MakeCenteredLabel("Press 'P' to Resume", centerX, centerY + 20, 25);
+    ui.nameBoxY = centerY - 10;
+    ui.namePrompt = MakeCenteredLabel("Enter your name:", centerX, ui.nameBoxY - 50, 30);
 
-    if (file.is_open()) {
-        while (count < MAX_LEADERBOARD_ENTRIES && file >> leaderboardNames[count] >> leaderboardScores[count]) {
-            count++;
-        }
-        file.close();
-    }
+    // Game over and HUD
+    ui.gameOverTitle = MakeCenteredLabel("Game Over!", centerX, centerY - 120, 60);
+    ui.gameOverHint = MakeCenteredLabel("Press ENTER to return to menu", centerX, centerY + 100, 25);
+    ui.gameOverReplayHint = MakeCenteredLabel("Press R to watch the replay", centerX, centerY + 140, 25);
+    ui.newHighScore = MakeCenteredLabel("New High Score!", centerX, centerY - 180, 50);
+    ui.replayVerified = MakeCenteredLabel("Replay matches the recorded game", centerX, centerY - 180, 30);
+    ui.replayMismatch = MakeCenteredLabel("Replay does NOT match the recorded game", centerX, centerY - 180, 30);
+    InitNumberText(ui.gameOverScore, "Score: %d", 40);
+    InitNumberText(ui.hudScore, "Score: %d", 20);
 
-    SortLeaderboard(count);
-    return count;
+    // Leaderboard
+    ui.leaderboardTitle = MakeLabel("Leaderboard", centerX - 100, 50, 30);
+    ui.leaderboardEmpty = MakeCenteredLabel("No scores yet!", centerX, centerY - 15, 30);
+    ui.leaderboardHelp = MakeCenteredLabel("W/S, wheel, PgUp/PgDn, Home/End to scroll   G: go to rank   N: find my name",
+                                           centerX, leaderboardTop + leaderboardVisibleRows * leaderboardRowHeight + 20, 20);
+    Rectangle menuBounds = {static_cast<float>(centerX - 175), static_cast<float>(screenHeight - 100), 150, 40};
+    Rectangle clearBounds = {static_cast<float>(centerX + 25), static_cast<float>(screenHeight - 100), 150, 40};
+    ui.leaderboardMenuButton = MakeButton(menuBounds, "Main Menu", 20, 10);
+    ui.leaderboardClearButton = MakeButton(clearBounds, "Clear", 20, 10);
+
+    ui.width = screenWidth;
+    ui.height = screenHeight;
+    ui.darkTheme = isDarkTheme;
+    ui.built = true;
 }
 
 void DrawMenu(GameState &currentState) {
-    int centerX = screenWidth / 2;
-    int centerY = screenHeight / 2;
+    DrawLabel(ui.menuTitle, foregroundColor);
 
-    // Center the title
-    const char* title = "Ping Pong Game";
-    int titleWidth = MeasureText(title, 40);
-    DrawText(title, centerX - titleWidth/2, 100, 40, foregroundColor);
-
-    Rectangle buttons[] = {
-        {static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(centerY - buttonHeight - buttonSpacing), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight)},
-        {static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(centerY), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight)},
-        {static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(centerY + buttonHeight + buttonSpacing), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight)},
-        {static_cast<float>(centerX - buttonWidth / 2), static_cast<float>(centerY + 2 * (buttonHeight + buttonSpacing)), static_cast<float>(buttonWidth), static_cast<float>(buttonHeight)}
-    };
-
-    const char* buttonTexts[] = {"Play", "Leaderboard", "Options", "Quit"};
     Vector2 mousePoint = GetMousePosition();
-
     for (int i = 0; i < 4; i++) {
-        bool hovered = CheckCollisionPointRec(mousePoint, buttons[i]);
-        int textWidth = MeasureText(buttonTexts[i], buttonTextSize);
-        DrawText(buttonTexts[i], buttons[i].x + (buttonWidth - textWidth)/2, buttons[i].y + 15, buttonTextSize, hovered ? RED : foregroundColor);
+        const UiButton &button = ui.menuButtons[i];
+        bool hovered = ButtonHovered(button, mousePoint);
+        DrawText(button.text, button.textX, button.textY, button.fontSize, hovered ? RED : foregroundColor);
 
         if (hovered && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            PlaySound(buttonSound);
+            PlayGameSound(SOUND_BUTTON);
             switch (i) {
                 case 0: currentState = GAME; break;
                 case 1: currentState = LEADERBOARD; break;
@@ -159,199 +490,322 @@ void DrawMenu(GameState &currentState) {
     }
 }
 
-void DrawLeaderboard(int &leaderboardSize, int &scrollOffset, GameState &currentState) {
-    DrawText("Leaderboard", screenWidth / 2 - 100, 50, 30, foregroundColor);
+// Formats a row once per rank and data change. NULL past the end.
+const LeaderboardRow* CachedLeaderboardRow(int rank) {
+    LeaderboardRow &row = leaderboardScreen.rows[rank & (ROW_CACHE_SIZE - 1)];
+    if (row.rank != rank || row.version != leaderboardVersion) {
+        PROFILE_SCOPE(PROFILE_SCORES);
+        const char* name;
+        int score;
+        bool found = scoreService ? ScoreClientRowAt(rank, name, score)
+                                  : RankedScoreAt(scoreHistory, leaderboard, rank, name, score);
+        if (!found) return NULL;
+        snprintf(row.text, sizeof(row.text), "%d. %s - %d", rank, name, score);
+        row.width = MeasureText(row.text, 20);
+        row.rank = rank;
+        row.version = leaderboardVersion;
+    }
+    return &row;
+}
+
+void ResetLeaderboardScreen() {
+    LeaderboardScreen &screen = leaderboardScreen;
+    screen.scroll = screen.targetScroll = 0.0;
+    screen.highlightRank = 0;
+    screen.typingRank = false;
+    screen.searching = false;
+    screen.status = "";
+}
+
+void JumpToRank(int rank, int leaderboardSize) {
+    LeaderboardScreen &screen = leaderboardScreen;
+    if (leaderboardSize == 0) return;
+    rank = rank < 1 ? 1 : (rank > leaderboardSize ? leaderboardSize : rank);
+    screen.highlightRank = rank;
+    // Center the row in the view
+    screen.targetScroll = (rank - 1) * (double)leaderboardRowHeight
+                        - (leaderboardVisibleRows * leaderboardRowHeight - leaderboardRowHeight) / 2.0;
+}
 
-    const int entriesPerPage = 20;
-    if (IsKeyDown(KEY_W) && scrollOffset > 0) scrollOffset--;
-    if (IsKeyDown(KEY_S) && scrollOffset < leaderboardSize - entriesPerPage) scrollOffset++;
+void HandleLeaderboardInput(int leaderboardSize, const char* playerName) {
+    LeaderboardScreen &screen = leaderboardScreen;
+    const double viewHeight = leaderboardVisibleRows * leaderboardRowHeight;
+    const double maxScroll = leaderboardSize * (double)leaderboardRowHeight > viewHeight
+                           ? leaderboardSize * (double)leaderboardRowHeight - viewHeight : 0.0;
+    double dt = DisplayFrameTime(display);
+
+    if (screen.typingRank) {
+        // Go to rank: digits, then ENTER; G again cancels
+        int key = GetCharPressed();
+        while (key > 0) {
+            int len = strlen(screen.rankInput);
+            if (key >= '0' && key <= '9' && len < (int)sizeof(screen.rankInput) - 1) {
+                screen.rankInput[len] = (char)key;
+                screen.rankInput[len + 1] = '\0';
+            }
+            key = GetCharPressed();
+        }
+        int len = strlen(screen.rankInput);
+        if (IsKeyPressed(KEY_BACKSPACE) && len > 0) screen.rankInput[len - 1] = '\0';
+        if (IsKeyPressed(KEY_ENTER) && len > 0) {
+            JumpToRank(atoi(screen.rankInput), leaderboardSize);
+            screen.typingRank = false;
+        }
+        if (IsKeyPressed(KEY_G)) screen.typingRank = false;
+    } else {
+        if (IsKeyDown(KEY_W)) screen.targetScroll -= SCROLL_ROWS_PER_SECOND * leaderboardRowHeight * dt;
+        if (IsKeyDown(KEY_S)) screen.targetScroll += SCROLL_ROWS_PER_SECOND * leaderboardRowHeight * dt;
+        if (IsKeyPressed(KEY_PAGE_UP)) screen.targetScroll -= viewHeight;
+        if (IsKeyPressed(KEY_PAGE_DOWN)) screen.targetScroll += viewHeight;
+        if (IsKeyPressed(KEY_HOME)) screen.targetScroll = 0.0;
+        if (IsKeyPressed(KEY_END)) screen.targetScroll = maxScroll;
+        screen.targetScroll -= GetMouseWheelMove() * 3.0 * leaderboardRowHeight;
+
+        if (IsKeyPressed(KEY_G)) {
+            screen.typingRank = true;
+            screen.rankInput[0] = '\0';
+            while (GetCharPressed() > 0) {}     // Drop the 'g' itself
+        }
+        if (IsKeyPressed(KEY_N) && playerName[0] != '\0') {
+            if (scoreService) ScoreClientFindPlayer(playerName);
+            else RankedPlayerSearchStart(screen.search, leaderboard, playerName);
+            screen.searching = true;
+            screen.searchVersion = leaderboardVersion;
+            screen.status = "Searching...";
+        }
+    }
+
+    // Find my name a slice of the log per frame; start over if the scores changed.
+    // The leaderboard service answers in one request.
+    if (screen.searching) {
+        bool found;
+        int rank;
+        if (scoreService) {
+            found = ScoreClientPlayerRank(rank);
+        } else {
+            if (screen.searchVersion != leaderboardVersion) {
+                RankedPlayerSearchStart(screen.search, leaderboard, screen.search.name);
+                screen.searchVersion = leaderboardVersion;
+            }
+            PROFILE_SCOPE(PROFILE_SCORES);
+            found = RankedPlayerSearchStep(screen.search, scoreHistory, leaderboard, NAME_SEARCH_BUDGET);
+            rank = screen.search.rank;
+        }
+        if (found) {
+            screen.searching = false;
+            if (rank > 0) {
+                JumpToRank(rank, leaderboardSize);
+                screen.status = "";
+            } else {
+                screen.status = "No scores for that name";
+            }
+        }
+    }
+
+    if (screen.targetScroll > maxScroll) screen.targetScroll = maxScroll;
+    if (screen.targetScroll < 0.0) screen.targetScroll = 0.0;
+
+    // Ease toward the target so jumps and pages glide instead of snapping
+    double step = dt * SCROLL_SMOOTHING;
+    screen.scroll += (screen.targetScroll - screen.scroll) * (step < 1.0 ? step : 1.0);
+    if (fabs(screen.targetScroll - screen.scroll) < 0.5) screen.scroll = screen.targetScroll;
+}
+
+void DrawLeaderboard(int &leaderboardSize, const char* playerName, GameState &currentState) {
+    LeaderboardScreen &screen = leaderboardScreen;
+    screen.waitingForIndex = false;
+    DrawLabel(ui.leaderboardTitle, foregroundColor);
+
+    HandleLeaderboardInput(leaderboardSize, playerName);
+    const int viewHeight = leaderboardVisibleRows * leaderboardRowHeight;
+    const int rowX = screenWidth / 2 - 200;
 
     // Only show entries if there are any
     if (leaderboardSize > 0) {
-        int yOffset = 100;
-        for (int i = scrollOffset; i < leaderboardSize && i < scrollOffset + entriesPerPage; i++) {
-            DrawText(TextFormat("%d. %s - %d", i + 1, leaderboardNames[i], leaderboardScores[i]),
-                     screenWidth / 2 - 200, yOffset, 20, foregroundColor);
-            yOffset += 30;
+        int first = (int)(screen.scroll / leaderboardRowHeight);
+        double firstY = leaderboardTop - (screen.scroll - first * (double)leaderboardRowHeight);
+        int last = first + leaderboardVisibleRows + 1;
+        if (last > leaderboardSize) last = leaderboardSize;
+
+        // Deep ranks are indexed on a background thread, or fetched from the
+        // leaderboard service; show placeholders until then
+        bool ready;
+        {
+            PROFILE_SCOPE(PROFILE_SCORES);
+            if (scoreService) {
+                ready = ScoreClientRowsReady(first + 1, last);
+            } else {
+                int historyRanks = last < ScoreLogViewValidCount(scoreHistory) ? last : ScoreLogViewValidCount(scoreHistory);
+                ready = ScoreLogViewReady(scoreHistory, historyRanks);
+                if (!ready) ScoreLogViewRequestRank(scoreHistory, historyRanks);
+            }
+        }
+        screen.waitingForIndex = !ready;
+
+        BeginScissorMode(0, leaderboardTop, screenWidth, viewHeight);
+        for (int i = first; i < last; i++) {
+            int y = (int)(firstY + (i - first) * leaderboardRowHeight);
+            if (!ready) {
+                DrawText(TextFormat("%d. ...", i + 1), rowX, y, 20, LIGHTGRAY);
+                continue;
+            }
+            const LeaderboardRow* row = CachedLeaderboardRow(i + 1);
+            if (!row) break;
+            DrawText(row->text, rowX, y, 20, foregroundColor);
+            if (row->rank == screen.highlightRank) {
+                DrawRectangleLines(rowX - 10, y - 5, row->width + 20, leaderboardRowHeight, GOLD);
+            }
         }
+        EndScissorMode();
     } else {
         // Show "No scores yet" message if leaderboard is empty
-        const char* emptyMessage = "No scores yet!";
-        int messageWidth = MeasureText(emptyMessage, 30);
-        DrawText(emptyMessage, screenWidth/2 - messageWidth/2, screenHeight/2 - 15, 30, foregroundColor);
+        DrawLabel(ui.leaderboardEmpty, foregroundColor);
     }
-    
-    // Return to Menu button
-    Rectangle menuButton = {
-        static_cast<float>(screenWidth/2 - 175),
-        static_cast<float>(screenHeight - 100),
-        150,
-        40
-    };
-    
-    // Clear Leaderboard button
-    Rectangle clearButton = {
-        static_cast<float>(screenWidth/2 + 25),
-        static_cast<float>(screenHeight - 100),
-        150,
-        40
-    };
+
+    if (screen.typingRank) {
+        const char* prompt = TextFormat("Go to rank: %s_", screen.rankInput);
+        DrawText(prompt, screenWidth/2 - MeasureText(prompt, 20)/2, ui.leaderboardHelp.y, 20, LIGHTGRAY);
+    } else {
+        DrawLabel(ui.leaderboardHelp, LIGHTGRAY);
+    }
+    if (screen.status[0] != '\0') {
+        DrawText(screen.status, screenWidth/2 - MeasureText(screen.status, 20)/2, leaderboardTop + viewHeight + 50, 20, LIGHTGRAY);
+    }
+    DrawPlayerStats(playerName);
     
     // Draw buttons
-    DrawRectangleRec(menuButton, backgroundColor);
-    DrawRectangleLines(menuButton.x, menuButton.y, menuButton.width, menuButton.height, foregroundColor);
-    DrawText("Main Menu", menuButton.x + (150 - MeasureText("Main Menu", 20))/2, 
-             menuButton.y + 10, 20, foregroundColor);
-             
-    DrawRectangleRec(clearButton, backgroundColor);
-    DrawRectangleLines(clearButton.x, clearButton.y, clearButton.width, clearButton.height, RED);
-    DrawText("Clear", clearButton.x + (150 - MeasureText("Clear", 20))/2, 
-             clearButton.y + 10, 20, RED);
-             
+    Color fill = backgroundColor;
+    DrawButtons(&ui.leaderboardMenuButton, &fill, 1, foregroundColor, foregroundColor);
+    DrawButtons(&ui.leaderboardClearButton, &fill, 1, RED, RED);
+
     // Handle button clicks
     if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
         Vector2 mousePoint = GetMousePosition();
-        if (CheckCollisionPointRec(mousePoint, menuButton)) {
-            PlaySound(buttonSound);
+        if (ButtonHovered(ui.leaderboardMenuButton, mousePoint)) {
+            PlayGameSound(SOUND_BUTTON);
             currentState = MENU;
         }
-        else if (CheckCollisionPointRec(mousePoint, clearButton)) {
-            ClearLeaderboard();
-            leaderboardSize = 0;  // Reset size to 0 since leaderboard is now empty
-            scrollOffset = 0;     // Reset scroll position
+        else if (ButtonHovered(ui.leaderboardClearButton, mousePoint)) {
+            if (scoreService) {
+                screen.status = "Scores are kept by the leaderboard service";
+            } else {
+                ClearLeaderboard();
+                leaderboardSize = 0;  // Reset size to 0 since leaderboard is now empty
+                ResetLeaderboardScreen();
+            }
         }
     }
 }
 
+void FormatPlayerStats(const PlayerSummary &stats) {
+    StatsPanel &panel = statsPanel;
+    int line = 0;
+    strcpy(panel.lines[line++], panel.name);
+    if (stats.games == 0) {
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "No games yet");
+    } else {
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Games: %u", stats.games);
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Best: %d", stats.best);
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Better than %.1f%% of games", stats.percentile);
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Mean: %.1f", stats.mean);
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Longest rally: %d", stats.longestRally);
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "Fastest ball: %.0f px/s", stats.maxBallSpeed);
+    }
+
+    // Newest first
+    int shown = 0;
+    for (int i = (int)sessionGames.size() - 1; i >= 0 && shown < STATS_PANEL_SESSION_GAMES; i--) {
+        const SubmittedGame &game = sessionGames[i];
+        if (strcmp(game.name, panel.name) != 0) continue;
+        if (shown == 0) snprintf(panel.lines[line++], sizeof(panel.lines[0]), "This session:");
+        snprintf(panel.lines[line++], sizeof(panel.lines[0]), "  %d  (rally %d)", game.game.score, game.game.longestRally);
+        shown++;
+    }
+    panel.lineCount = line;
+}
+
+// Stats of the player who played last, to the right of the list
+void DrawPlayerStats(const char* playerName) {
+    StatsPanel &panel = statsPanel;
+    if (playerName[0] == '\0') return;
+
+    if (panel.version != leaderboardVersion || strcmp(panel.name, playerName) != 0) {
+        PROFILE_SCOPE(PROFILE_SCORES);
+        strncpy(panel.name, playerName, MAX_NAME_LENGTH - 1);
+        panel.name[MAX_NAME_LENGTH - 1] = '\0';
+        panel.version = leaderboardVersion;
+        panel.lineCount = 0;
+        panel.waiting = scoreService;
+        if (scoreService) ScoreClientFindStats(panel.name);
+        else FormatPlayerStats(PlayerStatsSummary(ScoreStoreStats(), panel.name));
+    }
+    PlayerSummary stats;
+    if (panel.waiting && ScoreClientPlayerStats(stats)) {
+        panel.waiting = false;
+        FormatPlayerStats(stats);
+    }
+
+    const int x = screenWidth / 2 + 300;
+    for (int i = 0; i < panel.lineCount; i++) {
+        DrawText(panel.lines[i], x, leaderboardTop + i * leaderboardRowHeight, 20, i == 0 ? foregroundColor : LIGHTGRAY);
+    }
+}
+
 void DrawOptions(GameState &currentState) {
-    int centerX = screenWidth / 2;
-    int centerY = screenHeight / 3;
-    
-    const int optionButtonWidth = 150;
-    const int optionButtonHeight = 40;
-    const int optionSpacing = 30;
-    
-    // Draw Theme heading
-    DrawText("Theme", centerX - MeasureText("Theme", 40)/2, centerY - 80, 40, foregroundColor);
-    
-    // Theme buttons
-    Rectangle lightButton = {
-        static_cast<float>(centerX - optionButtonWidth - 20),
-        static_cast<float>(centerY - 20),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
-    };
-    Rectangle darkButton = {
-        static_cast<float>(centerX + 20),
-        static_cast<float>(centerY - 20),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
-    };
-    
-    // Draw theme buttons with selection indicator
-    DrawRectangleRec(lightButton, !isDarkTheme ? LIGHTGRAY : backgroundColor);
-    DrawRectangleLines(lightButton.x, lightButton.y, lightButton.width, lightButton.height, foregroundColor);
-    DrawText("Light", lightButton.x + (optionButtonWidth - MeasureText("Light", 20))/2, 
-             lightButton.y + 10, 20, foregroundColor);
-    
-    DrawRectangleRec(darkButton, isDarkTheme ? LIGHTGRAY : backgroundColor);
-    DrawRectangleLines(darkButton.x, darkButton.y, darkButton.width, darkButton.height, foregroundColor);
-    DrawText("Dark", darkButton.x + (optionButtonWidth - MeasureText("Dark", 20))/2, 
-             darkButton.y + 10, 20, foregroundColor);
-    
-    // Draw Speed heading
-    DrawText("Ball Speed", centerX - MeasureText("Ball Speed", 40)/2, centerY + 80, 40, foregroundColor);
-    
-    // Speed buttons
-    Rectangle slowButton = {
-        static_cast<float>(centerX - optionButtonWidth*1.5f - 20),
-        static_cast<float>(centerY + 140),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
-    };
-    Rectangle mediumButton = {
-        static_cast<float>(centerX - optionButtonWidth/2),
-        static_cast<float>(centerY + 140),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
-    };
-    Rectangle fastButton = {
-        static_cast<float>(centerX + optionButtonWidth/2 + 20),
-        static_cast<float>(centerY + 140),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
-    };
-    
-    // Draw speed buttons with selection indicator
-    DrawRectangleRec(slowButton, currentBallSpeed == BALL_SPEED_SLOW ? LIGHTGRAY : backgroundColor);
-    DrawRectangleLines(slowButton.x, slowButton.y, slowButton.width, slowButton.height, foregroundColor);
-    DrawText("Slow", slowButton.x + (optionButtonWidth - MeasureText("Slow", 20))/2, 
-             slowButton.y + 10, 20, foregroundColor);
-    
-    DrawRectangleRec(mediumButton, currentBallSpeed == BALL_SPEED_MEDIUM ? LIGHTGRAY : backgroundColor);
-    DrawRectangleLines(mediumButton.x, mediumButton.y, mediumButton.width, mediumButton.height, foregroundColor);
-    DrawText("Medium", mediumButton.x + (optionButtonWidth - MeasureText("Medium", 20))/2, 
-             mediumButton.y + 10, 20, foregroundColor);
-    
-    DrawRectangleRec(fastButton, currentBallSpeed == BALL_SPEED_FAST ? LIGHTGRAY : backgroundColor);
-    DrawRectangleLines(fastButton.x, fastButton.y, fastButton.width, fastButton.height, foregroundColor);
-    DrawText("Fast", fastButton.x + (optionButtonWidth - MeasureText("Fast", 20))/2, 
-             fastButton.y + 10, 20, foregroundColor);
-    
-    // Return to Menu button
-    Rectangle menuButton = {
-        static_cast<float>(centerX - optionButtonWidth/2),
-        static_cast<float>(centerY + 250),
-        static_cast<float>(optionButtonWidth),
-        static_cast<float>(optionButtonHeight)
+    for (int i = 0; i < 5; i++) DrawLabel(ui.optionHeadings[i], foregroundColor);
+
+    // Selected choices are filled
+    bool selected[OPTION_BUTTON_COUNT] = {
+        !isDarkTheme, isDarkTheme,
+        ballSpeedPreset == BALL_SPEED_PRESET_SLOW, ballSpeedPreset == BALL_SPEED_PRESET_MEDIUM,
+        ballSpeedPreset == BALL_SPEED_PRESET_FAST,
+        false, false, false, false,
+        simTickRate == SIM_RATE_LOW, simTickRate == SIM_RATE_MEDIUM, simTickRate == SIM_RATE_HIGH,
+        false, false, false, false, false, false,
+        display.settings.vsync, display.settings.fullscreen,
+        false
     };
-    DrawRectangleRec(menuButton, backgroundColor);
-    DrawRectangleLines(menuButton.x, menuButton.y, menuButton.width, menuButton.height, foregroundColor);
-    DrawText("Main Menu", menuButton.x + (optionButtonWidth - MeasureText("Main Menu", 20))/2, 
-             menuButton.y + 10, 20, foregroundColor);
-    
+    for (int i = 0; i < OPPONENT_LEVEL_COUNT; i++) {
+        selected[OPTION_OPPONENT_FIRST + i] = opponentLevel == i;
+    }
+    for (int i = 0; i < FRAME_RATE_CHOICE_COUNT; i++) {
+        selected[OPTION_FPS_FIRST + i] = display.settings.targetFps == FRAME_RATE_CHOICES[i];
+    }
+    Color fills[OPTION_BUTTON_COUNT];
+    for (int i = 0; i < OPTION_BUTTON_COUNT; i++) fills[i] = selected[i] ? LIGHTGRAY : backgroundColor;
+    DrawButtons(ui.optionButtons, fills, OPTION_BUTTON_COUNT, foregroundColor, foregroundColor);
+
     // Handle button clicks
+    if (!IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) return;
     Vector2 mousePoint = GetMousePosition();
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        if (CheckCollisionPointRec(mousePoint, lightButton)) {
-            PlaySound(buttonSound);
-            isDarkTheme = false;
-            backgroundColor = WHITE;
-            foregroundColor = BLACK;
-        }
-        else if (CheckCollisionPointRec(mousePoint, darkButton)) {
-            PlaySound(buttonSound);
-            isDarkTheme = true;
-            backgroundColor = BLACK;
-            foregroundColor = WHITE;
-        }
-        else if (CheckCollisionPointRec(mousePoint, slowButton)) {
-            PlaySound(buttonSound);
-            currentBallSpeed = BALL_SPEED_SLOW;
-        }
-        else if (CheckCollisionPointRec(mousePoint, mediumButton)) {
-            PlaySound(buttonSound);
-            currentBallSpeed = BALL_SPEED_MEDIUM;
-        }
-        else if (CheckCollisionPointRec(mousePoint, fastButton)) {
-            PlaySound(buttonSound);
-            currentBallSpeed = BALL_SPEED_FAST;
-        }
-        else if (CheckCollisionPointRec(mousePoint, menuButton)) {
-            PlaySound(buttonSound);
-            currentState = MENU;
+    for (int i = 0; i < OPTION_BUTTON_COUNT; i++) {
+        if (!ButtonHovered(ui.optionButtons[i], mousePoint)) continue;
+        PlayGameSound(SOUND_BUTTON);
+        switch (i) {
+            case OPTION_LIGHT: SetTheme(false); break;
+            case OPTION_DARK: SetTheme(true); break;
+            case OPTION_SLOW: ballSpeedPreset = BALL_SPEED_PRESET_SLOW; break;
+            case OPTION_MEDIUM: ballSpeedPreset = BALL_SPEED_PRESET_MEDIUM; break;
+            case OPTION_FAST: ballSpeedPreset = BALL_SPEED_PRESET_FAST; break;
+            case OPTION_RATE_LOW: simTickRate = SIM_RATE_LOW; break;
+            case OPTION_RATE_MEDIUM: simTickRate = SIM_RATE_MEDIUM; break;
+            case OPTION_RATE_HIGH: simTickRate = SIM_RATE_HIGH; break;
+            case OPTION_VSYNC: DisplaySetVsync(display, !display.settings.vsync); break;
+            case OPTION_FULLSCREEN: DisplayToggleFullscreen(display); break;
+            case OPTION_MENU: currentState = MENU; break;
+            default:
+                if (i <= OPTION_OPPONENT_LAST) opponentLevel = (OpponentLevel)(i - OPTION_OPPONENT_FIRST);
+                else DisplaySetTargetFps(display, FRAME_RATE_CHOICES[i - OPTION_FPS_FIRST]);
+                break;
         }
+        ChooseGameLoop();
+        break;
     }
 }
 
 void DrawPaused() {
-    const char* pausedText = "Game Paused";
-    const char* resumeText = "Press 'P' to Resume";
-    int pausedWidth = MeasureText(pausedText, 60);    // Stays at 60
-    int resumeWidth = MeasureText(resumeText, 25);    // Increased from 20 to 25
-    
-    DrawText(pausedText, screenWidth/2 - pausedWidth/2, screenHeight/2 - 50, 60, foregroundColor);
-    DrawText(resumeText, screenWidth/2 - resumeWidth/2, screenHeight/2 + 20, 25, LIGHTGRAY);
+    DrawLabel(ui.pausedTitle, foregroundColor);
+    DrawLabel(ui.pausedHint, LIGHTGRAY);
 }
 
 void HandlePause(bool &paused, GameState &currentState) {
@@ -360,87 +814,149 @@ void HandlePause(bool &paused, GameState &currentState) {
     }
 }
 
-void UpdateGame(float deltaTime, Vector2 &ballPosition, Vector2 &ballVelocity, Rectangle &paddle, int &score, bool &gameOver) {
-    // Update ball position
-    ballPosition.x += ballVelocity.x * deltaTime;
-    ballPosition.y += ballVelocity.y * deltaTime;
-
-    // Handle top and bottom wall collisions with proper boundary checking
-    if (ballPosition.y - ballRadius <= 0) {
-        ballPosition.y = ballRadius;
-        ballVelocity.y = fabs(ballVelocity.y);
-        PlaySound(bounceSound);
-    }
-    if (ballPosition.y + ballRadius >= screenHeight) {
-        ballPosition.y = screenHeight - ballRadius;
-        ballVelocity.y = -fabs(ballVelocity.y);
-        PlaySound(bounceSound);
-    }
-
-    // Handle paddle collision with improved physics
-    if (CheckCollisionCircleRec(ballPosition, ballRadius, paddle)) {
-        if (ballVelocity.x < 0) {  // Only bounce if moving towards paddle
-            PlaySound(bounceSound);
-            
-            // Calculate relative intersection position with the paddle (-1 to 1)
-            float relativeIntersectY = (ballPosition.y - (paddle.y + paddle.height/2)) / (paddle.height/2);
-            float bounceAngle = relativeIntersectY * 60;  // Max 60 degree bounce angle
-            
-            // Get current speed and increase it by 5%
-            float speed = sqrt(ballVelocity.x * ballVelocity.x + ballVelocity.y * ballVelocity.y);
-            speed *= 1.05f;  // Increase speed by 5% with each hit
-            
-            // Apply the new speed with the bounce angle
-            ballVelocity.x = fabs(speed * cos(bounceAngle * DEG2RAD));
-            ballVelocity.y = speed * sin(bounceAngle * DEG2RAD);
-            
-            score++;
+// tickTime is the GetTime moment the tick ends at, for input timing
+template <class Rules, bool Versus>
+void UpdateGame(float deltaTime, double tickTime, GameSimState &state) {
+    SimInput input;
+    if (playback.active) {
+        if (!ReplayPlayerNext(playback.player, input)) {
+            playback.inputEnded = true;
+            return;
         }
+    } else {
+        input = PaddleInputAt(paddleInput, tickTime, deltaTime, state);
+        ReplayRecord(recordedReplay, input);
     }
 
-    // Handle game over condition
-    if (ballPosition.x - ballRadius <= 0) {
-        gameOver = true;
-        PlaySound(gameoverSound);  // Play game over sound
-        
+    SimEvents events = Versus ? SimStepVersusRules<Rules>(state, input, PredictorAIInput(opponentAI, state), deltaTime)
+                     : SimStepRules<Rules>(state, input, deltaTime);
+    AudioBeginTick();
+
+    gameRecords.rally += events.paddleHits + events.opponentHits;
+    if (gameRecords.rally > gameRecords.longestRally) gameRecords.longestRally = gameRecords.rally;
+    if (events.opponentMisses > 0) gameRecords.rally = 0;
+    float speedSquared = state.ballVelocityX * state.ballVelocityX + state.ballVelocityY * state.ballVelocityY;
+    if (speedSquared > gameRecords.maxBallSpeed * gameRecords.maxBallSpeed) gameRecords.maxBallSpeed = sqrtf(speedSquared);
+
+    // Handle game over condition; queued before the bounce so the tick's event cap never drops it
+    if (events.gameOver) {
+        PlayGameSound(SOUND_GAMEOVER);  // Play game over sound
+
         // Check and play high score sound if achieved
-        int leaderboardSize = LoadLeaderboard();
-        if (IsHighScore(score, leaderboardSize)) {
-            PlaySound(highscoreSound);
+        if (IsHighScore(state.score, ScoreCount())) {
+            PlayGameSound(SOUND_HIGHSCORE);
         }
     }
 
-    // Handle right wall collision
-    if (ballPosition.x + ballRadius >= screenWidth) {
-        ballPosition.x = screenWidth - ballRadius;
-        ballVelocity.x *= -1;
-        PlaySound(bounceSound);
+    // One sound for every contact in the tick, as loud as the hardest
+    if (events.opponentMisses > 0) PlayGameSound(SOUND_BUTTON);
+    if (events.wallBounces > 0 || events.paddleHits > 0 || events.opponentHits > 0) {
+        float strength = (events.hardestImpact - QUIET_IMPACT_SPEED) / (LOUD_IMPACT_SPEED - QUIET_IMPACT_SPEED);
+        strength = fminf(1.0f, fmaxf(0.0f, strength));
+        PlayGameSound(SOUND_BOUNCE, 0.5f + 0.5f * strength, 0.9f + 0.25f * strength);
+    }
+}
+
+template <class Rules, bool Versus>
+float RunSimulation(float frameTime, GameSimState &state, GameSimState &prevState) {
+    PROFILE_SCOPE(PROFILE_UPDATE);
+    const double tickTime = 1.0 / simTickRate;
+
+    // Clamp long frames so one stall cannot produce a burst of catch-up ticks
+    if (frameTime > MAX_FRAME_TIME) {
+        simClock.droppedTime += frameTime - MAX_FRAME_TIME;
+        frameTime = MAX_FRAME_TIME;
     }
+    if (playback.active) frameTime *= playback.speed;   // Fast forward
+    simClock.accumulator += frameTime;
 
-    // Update paddle position with boundary checking
-    if (IsKeyDown(KEY_UP)) {
-        paddle.y = fmax(0, paddle.y - paddleSpeed * deltaTime);
+    // Step the game in fixed increments, keeping the previous state for interpolation
+    // The ticks run now cover the time up to the latest input poll
+    int ticks = 0;
+    double pollTime = paddleInput.current.time;
+    while (simClock.accumulator >= tickTime && !state.gameOver && !playback.inputEnded) {
+        prevState = state;
+        UpdateGame<Rules, Versus>((float)tickTime, pollTime - (simClock.accumulator - tickTime), state);
+        simClock.accumulator -= tickTime;
+        ticks++;
     }
-    if (IsKeyDown(KEY_DOWN)) {
-        paddle.y = fmin(screenHeight - paddle.height, paddle.y + paddleSpeed * deltaTime);
+    if (state.gameOver) {
+        simClock.accumulator = 0.0;
+    }
+    simClock.ticksLastFrame = ticks;
+    simClock.totalTicks += ticks;
+
+    // Fraction of a tick left over, used to blend between the last two states
+    return (float)(simClock.accumulator / tickTime);
+}
+
+// Draws the state interpolated between the last two ticks
+template <class Theme>
+void DrawPlayfield(const GameSimState &state, const GameSimState &prevState, float alpha) {
+    Vector2 drawBallPosition = {
+        prevState.ballX + (state.ballX - prevState.ballX) * alpha,
+        prevState.ballY + (state.ballY - prevState.ballY) * alpha
+    };
+    Rectangle drawPaddle = {
+        paddleX,
+        prevState.paddleY + (state.paddleY - prevState.paddleY) * alpha,
+        (float)paddleWidth,
+        (float)paddleHeight
+    };
+
+    DrawCircleV(drawBallPosition, ballRadius, Theme::Foreground());
+    DrawRectangleRec(drawPaddle, Theme::Foreground());
+    if (state.opponent) {
+        Rectangle drawOpponent = {
+            opponentX,
+            prevState.opponentY + (state.opponentY - prevState.opponentY) * alpha,
+            (float)paddleWidth,
+            (float)paddleHeight
+        };
+        DrawRectangleRec(drawOpponent, Theme::Foreground());
     }
+    DrawText(NumberText(ui.hudScore, state.score), 20, 20, 20, Theme::Foreground());
+}
+
+void ChooseGameLoop() {
+    if (opponentLevel == OPPONENT_NONE) gameLoop.runSimulation = RunSimulation<DefaultRules, false>;
+    else gameLoop.runSimulation = RunSimulation<DefaultRules, true>;
+    if (isDarkTheme) gameLoop.drawPlayfield = DrawPlayfield<DarkTheme>;
+    else gameLoop.drawPlayfield = DrawPlayfield<LightTheme>;
+}
+
+void ResetSimClock() {
+    simClock.accumulator = 0.0;
+    simClock.ticksLastFrame = 0;
+    simClock.totalTicks = 0;
+    simClock.droppedTime = 0.0;
+}
+
+void DrawSimStats() {
+    DrawText(TextFormat("Sim: %d Hz  Ticks/frame: %d  Total ticks: %lld  Dropped: %.1f ms",
+                        simTickRate, simClock.ticksLastFrame, simClock.totalTicks, simClock.droppedTime * 1000.0),
+             20, 50, 20, LIGHTGRAY);
 }
 
 void HandleNameInput(char* playerName, bool &nameEntered) {
-    const char* prompt = "Enter your name:";
-    int promptWidth = MeasureText(prompt, 30);
-    int nameWidth = MeasureText(playerName, 30);
+    // Measure the name only when it changes
+    static char measuredName[MAX_NAME_LENGTH] = {'\0'};
+    static int nameWidth = 0;
+    if (strcmp(measuredName, playerName) != 0) {
+        strcpy(measuredName, playerName);
+        nameWidth = MeasureText(playerName, 30);
+    }
     
     // Calculate dynamic box width based on name length, with minimum width
     int boxWidth = fmax(10, nameWidth + 40);  // minimum width of 10px, or name width + padding
     const int boxHeight = 40;
     
     // Calculate vertical positions
-    int boxY = screenHeight/2 - 10;
+    int boxY = ui.nameBoxY;
     int textY = boxY + (boxHeight - 30)/2;  // Center text vertically within box (30 is text height)
     
     // Draw prompt and input box centered
-    DrawText(prompt, screenWidth/2 - promptWidth/2, boxY - 50, 30, foregroundColor);
+    DrawLabel(ui.namePrompt, foregroundColor);
     DrawRectangleLines(
         screenWidth/2 - boxWidth/2,  // Center the box horizontally
         boxY,
@@ -461,23 +977,339 @@ void HandleNameInput(char* playerName, bool &nameEntered) {
     }
     else if (key == KEY_ENTER && strlen(playerName) > 0) {
         nameEntered = true;
-        PlaySound(buttonSound);  // Play click sound when name is entered
+        PlayGameSound(SOUND_BUTTON);  // Play click sound when name is entered
     }
 }
 
-void ResetGame(Vector2 &ballPosition, Vector2 &ballVelocity, Rectangle &paddle, int &score, bool &gameOver) {
-    ballPosition = {(float)screenWidth / 2, (float)screenHeight / 2};
-    // Set initial velocity based on current speed setting - directly use selected speed
-    ballVelocity = {-currentBallSpeed, currentBallSpeed};  // 45-degree angle
-    paddle.y = (float)screenHeight / 2 - paddle.height / 2;
-    score = 0;
-    gameOver = false;
+void ResetGame(GameSimState &state) {
+    // A replay's opponent has to aim exactly as it did when recorded
+    uint32_t seed = playback.active ? playback.replay.header.seed : (uint32_t)time(NULL) ^ (uint32_t)(GetTime() * 1e6);
+    SimReset(state, BALL_SPEED_PRESETS[ballSpeedPreset], opponentLevel != OPPONENT_NONE);
+    PredictorAIReset(opponentAI, opponentLevel, simTickRate, seed);
+    ResetSimClock();
+    gameRecords.rally = gameRecords.longestRally = 0;
+    gameRecords.maxBallSpeed = 0.0f;
+    ReplayBegin(recordedReplay, BALL_SPEED_PRESETS[ballSpeedPreset], simTickRate, isDarkTheme, opponentLevel, seed);
+}
+
+void SetTheme(bool dark) {
+    isDarkTheme = dark;
+    backgroundColor = dark ? BLACK : WHITE;
+    foregroundColor = dark ? WHITE : BLACK;
+}
+
+// Plays a replay on screen with the settings it was recorded with
+void StartReplay(const Replay &replay, GameSimState &state, GameSimState &prevState) {
+    if (!playback.active) {
+        playback.savedBallSpeed = ballSpeedPreset;
+        playback.savedTickRate = simTickRate;
+        playback.savedDarkTheme = isDarkTheme;
+        playback.savedOpponent = opponentLevel;
+    }
+    playback.replay = replay;
+    playback.active = true;
+    playback.speed = 1;
+    playback.inputEnded = false;
+    playback.verified = false;
+    ballSpeedPreset = BallSpeedPresetFor(replay.header.ballSpeed);
+    simTickRate = (int)replay.header.tickRate;
+    opponentLevel = ReplayOpponent(replay.header);
+    SetTheme((replay.header.flags & REPLAY_DARK_THEME) != 0);
+    ChooseGameLoop();
+    ReplayPlayerStart(playback.player, playback.replay);
+    ResetGame(state);
+    prevState = state;
+}
+
+void StopReplay() {
+    if (!playback.active) return;
+    playback.active = false;
+    ballSpeedPreset = playback.savedBallSpeed;
+    simTickRate = playback.savedTickRate;
+    opponentLevel = playback.savedOpponent;
+    SetTheme(playback.savedDarkTheme);
+    ChooseGameLoop();
+}
+
+// Queues the finished recording for the background writer
+void SaveReplay(const char* playerName) {
+    char path[128];
+    int length = snprintf(path, sizeof(path), "replays/%ld-", (long)time(NULL));
+    for (const char* c = playerName; *c && length < (int)sizeof(path) - 5; c++) {
+        path[length++] = isalnum((unsigned char)*c) ? *c : '_';
+    }
+    strcpy(path + length, ".ppr");
+
+    vector<unsigned char> bytes;
+    EncodeReplay(recordedReplay, bytes);
+    ScoreStoreWriteFile(path, bytes);
+}
+
+void DrawReplayStatus() {
+    DrawText(TextFormat("REPLAY %dx   LEFT/RIGHT: speed   M: menu", playback.speed), 20, screenHeight - 60, 20, LIGHTGRAY);
+    if (playback.inputEnded) {
+        DrawText("Replay ended before the game did", 20, screenHeight - 90, 20, RED);
+    }
+}
+
+int ScoreCount() {
+    return scoreService ? ScoreClientTotal() : RankedScoreCount(scoreHistory, leaderboard);
+}
+
+// Records a finished game, with its rally and ball speed records, wherever
+// the scores are kept; returns the new leaderboard size
+int SubmitScore(const char* playerName, int score) {
+    PROFILE_SCOPE(PROFILE_SCORES);
+    leaderboardVersion++;
+    SubmittedGame submitted;
+    memset(&submitted, 0, sizeof(submitted));
+    strncpy(submitted.name, playerName, MAX_NAME_LENGTH - 1);
+    submitted.game.score = score;
+    submitted.game.longestRally = gameRecords.longestRally;
+    submitted.game.maxBallSpeed = gameRecords.maxBallSpeed;
+    sessionGames.push_back(submitted);
+
+    if (scoreService) {
+        ScoreClientSubmit(playerName, submitted.game);
+        return ScoreClientTotal() + 1;      // Until the daemon answers
+    }
+    ScoreStoreSubmit(leaderboard, playerName, score, submitted.game.longestRally, submitted.game.maxBallSpeed);
+    return RankedScoreCount(scoreHistory, leaderboard);
+}
+
+// The daemon went away: keep scores in scores.bin from now on, starting
+// with the games it never confirmed. Returns the new leaderboard size.
+int FallBackToLocalScores() {
+    vector<SubmittedGame> unconfirmed;
+    ScoreClientUnconfirmed(unconfirmed);
+    ScoreClientStop();
+    scoreService = false;
+    cerr << "Leaderboard service went away; saving scores to scores.bin" << endl;
+
+    ScoreStoreStop();
+    ScoreStoreStart("scores.bin", "scores.txt", "players.bin");
+    for (size_t i = 0; i < unconfirmed.size(); i++) {
+        const GameSummary &game = unconfirmed[i].game;
+        ScoreStoreSubmit(leaderboard, unconfirmed[i].name, game.score, game.longestRally, game.maxBallSpeed);
+    }
+    leaderboardVersion++;
+    return RankedScoreCount(scoreHistory, leaderboard);
 }
 
 void ClearLeaderboard() {
-    // Clear the file
-    ofstream file("scores.txt", ios::trunc);
-    file.close();
+    PROFILE_SCOPE(PROFILE_SCORES);
+    // Clear the in-memory copy now and the file in the background
+    ScoreStoreClear(scoreHistory, leaderboard);
+    sessionGames.clear();
+    leaderboardVersion++;
+}
+
+// Queues the sound for the audio thread; never waits on the audio device
+void PlayGameSound(int sound, float volume, float pitch) {
+    PROFILE_SCOPE(PROFILE_SOUND);
+    AudioPost(sound, volume, pitch);
+}
+
+void DrawProfiler() {
+    const int graphX = screenWidth - PROFILE_HISTORY * 2 - 20;
+    const int graphY = 20;
+    const int graphHeight = 100;
+    const float pixelsPerMs = graphHeight / PROFILE_GRAPH_MS;
+
+    DrawRectangle(graphX - 10, graphY - 10, PROFILE_HISTORY * 2 + 20, graphHeight + 160, ColorAlpha(BLACK, 0.75f));
+
+    // One bar per frame, newest on the right; red when the frame missed the target rate
+    float targetMs = 1000.0f / (display.settings.targetFps > 0 ? display.settings.targetFps : 120);
+    for (int i = 0; i < PROFILE_HISTORY; i++) {
+        float ms = (float)ProfilerFrameMs(i);
+        if (ms <= 0.0f) break;
+        int height = (int)(ms * pixelsPerMs);
+        if (height > graphHeight) height = graphHeight;
+        int x = graphX + (PROFILE_HISTORY - 1 - i) * 2;
+        DrawRectangle(x, graphY + graphHeight - height, 2, height, ms > targetMs + 0.5f ? RED : GREEN);
+    }
+    int targetY = graphY + graphHeight - (int)(targetMs * pixelsPerMs);
+    DrawLine(graphX, targetY, graphX + PROFILE_HISTORY * 2, targetY, GOLD);
+
+    ProfilerStats stats;
+    ProfilerGetStats(stats);
+    int textY = graphY + graphHeight + 10;
+    DrawText(TextFormat("p50 %.2f  p99 %.2f  max %.2f ms", stats.p50Ms, stats.p99Ms, stats.maxMs), graphX, textY, 20, WHITE);
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        DrawText(TextFormat("%-8s %.3f ms", profileSectionNames[i], stats.sectionMs[i]),
+                 graphX + (i % 2) * 240, textY + 30 + (i / 2) * 25, 20, LIGHTGRAY);
+    }
+}
+
+// Gameplay runs at the full rate; other screens slow down or sleep when nothing on them moves
+FrameMode ChooseFrameMode(UiScreen screen, int &staticFrames) {
+    if (screen == SCREEN_PLAYING || screen == SCREEN_STRESS) {
+        staticFrames = 0;
+        return FRAME_GAMEPLAY;
+    }
+
+    const LeaderboardScreen &board = leaderboardScreen;
+    bool moving = transitionAlpha > 0.0f || showProfiler || showSimStats || !idleScreens;
+    if (screen == SCREEN_LEADERBOARD) {
+        moving = moving || board.scroll != board.targetScroll || board.searching
+              || IsKeyDown(KEY_W) || IsKeyDown(KEY_S);
+    }
+    bool scoresLoading = scoreService ? ScoreClientBusy() : !ScoreStoreLoaded();
+    bool waiting = scoresLoading || !AssetsReady() || (screen == SCREEN_LEADERBOARD && board.waitingForIndex);
+
+    // Input that woke an idle frame may change what the next frame shows
+    if (moving || display.wokeFromIdle) staticFrames = 0;
+    else staticFrames++;
+    if (staticFrames < IDLE_AFTER_FRAMES) return FRAME_ACTIVE;
+    return waiting ? FRAME_BACKGROUND : FRAME_IDLE;
+}
+
+void PrintScreenCpuReport() {
+    cout << "CPU use by screen (process CPU time / wall time):" << endl;
+    for (int i = 0; i < SCREEN_COUNT; i++) {
+        if (screenWallSeconds[i] <= 0.0) continue;
+        printf("  %-12s %6.1f%% over %.1f s\n", uiScreenNames[i],
+               100.0 * screenCpuSeconds[i] / screenWallSeconds[i], screenWallSeconds[i]);
+    }
+}
+
+void StressEnter(int balls, bool autoTune) {
+    if (!stress.loaded) {
+        StressInit(stress.field, STRESS_MAX_BALLS, STRESS_MAX_PARTICLES, (unsigned int)time(NULL));
+        Image image = GenImageColor(32, 32, BLANK);
+        ImageDrawCircle(&image, 16, 16, 15, WHITE);
+        stress.ballTexture = LoadTextureFromImage(image);
+        UnloadImage(image);
+        SetTextureFilter(stress.ballTexture, TEXTURE_FILTER_BILINEAR);
+        stress.sustained = -1;
+        stress.loaded = true;
+    }
+    stress.field.count = 0;
+    stress.field.particleCount = 0;
+    StressSetCount(stress.field, balls, STRESS_BALL_SPEED);
+    stress.updateMs = 0.0;
+    stress.drawMs = 0.0;
+    stress.autoTune = false;
+    if (autoTune) {
+        stress.autoTune = true;
+        stress.holds = 0;
+        stress.misses = 0;
+        stress.warmupFrames = STRESS_WARMUP_FRAMES;
+        stress.sampleCount = 0;
+        stress.sustained = -1;
+        stress.savedTargetFps = display.settings.targetFps;
+        DisplaySetTargetFps(display, 0);
+    }
+}
+
+void StressLeave() {
+    if (stress.autoTune) DisplaySetTargetFps(display, stress.savedTargetFps);
+    stress.autoTune = false;
+}
+
+// One measurement per ball count: the 90th percentile frame, so a few slow
+// frames caused elsewhere do not decide it
+void StressAutoTune(float frameMs) {
+    if (stress.warmupFrames > 0) {
+        stress.warmupFrames--;
+        return;
+    }
+    stress.samplesMs[stress.sampleCount++] = frameMs;
+    if (stress.sampleCount < STRESS_SAMPLE_FRAMES) return;
+
+    sort(stress.samplesMs, stress.samplesMs + STRESS_SAMPLE_FRAMES);
+    float p90 = stress.samplesMs[STRESS_SAMPLE_FRAMES * 9 / 10];
+    int count = stress.field.count;
+    bool holds = p90 <= 1000.0f / STRESS_AUTO_FPS;
+    if (holds) stress.holds = count;
+    else stress.misses = count;
+    printf("Stress: %d balls, p90 frame %.2f ms: %s %d FPS\n", count, p90, holds ? "holds" : "misses", STRESS_AUTO_FPS);
+
+    bool done = stress.misses == 0 ? count >= STRESS_MAX_BALLS
+                                   : stress.misses - stress.holds <= max(16, stress.holds / 32);
+    if (done) {
+        stress.sustained = stress.holds;
+        printf("Stress: %d balls sustain %d FPS\n", stress.sustained, STRESS_AUTO_FPS);
+        StressLeave();
+        return;
+    }
+    int next = stress.misses == 0 ? min(count * 2, STRESS_MAX_BALLS) : (stress.holds + stress.misses) / 2;
+    StressSetCount(stress.field, next, STRESS_BALL_SPEED);
+    stress.warmupFrames = STRESS_WARMUP_FRAMES;
+    stress.sampleCount = 0;
+}
+
+void UpdateStress(float frameTime) {
+    double start = GetTime();
+    SimInput input;
+    input.up = IsKeyDown(KEY_UP);
+    input.down = IsKeyDown(KEY_DOWN);
+    input.axis = 0;
+    StressStep(stress.field, input, fmin(frameTime, STRESS_MAX_STEP));
+    stress.updateMs += ((GetTime() - start) * 1000.0 - stress.updateMs) * 0.05;
+
+    if (IsKeyPressed(KEY_A)) {
+        if (stress.autoTune) StressLeave();
+        else StressEnter(stress.field.count > 0 ? stress.field.count : STRESS_START_BALLS, true);
+    }
+    if (stress.autoTune) {
+        StressAutoTune(frameTime * 1000.0f);
+    } else {
+        if (IsKeyPressed(KEY_EQUAL)) StressSetCount(stress.field, max(1, stress.field.count * 2), STRESS_BALL_SPEED);
+        if (IsKeyPressed(KEY_MINUS)) StressSetCount(stress.field, stress.field.count / 2, STRESS_BALL_SPEED);
+    }
+}
+
+// Every ball is a quad in one rlgl batch with the circle texture, and every
+// particle an untextured quad in a second; raylib flushes a batch by itself
+// when it fills up. Draw time is the CPU side only: the GPU work lands in EndDrawing.
+void DrawStress() {
+    double start = GetTime();
+    const StressField &field = stress.field;
+    const float r = STRESS_BALL_RADIUS;
+
+    rlSetTexture(stress.ballTexture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(foregroundColor.r, foregroundColor.g, foregroundColor.b, foregroundColor.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < field.count; i++) {
+        float x = field.ballX[i];
+        float y = field.ballY[i];
+        rlTexCoord2f(0.0f, 0.0f); rlVertex2f(x - r, y - r);
+        rlTexCoord2f(0.0f, 1.0f); rlVertex2f(x - r, y + r);
+        rlTexCoord2f(1.0f, 1.0f); rlVertex2f(x + r, y + r);
+        rlTexCoord2f(1.0f, 0.0f); rlVertex2f(x + r, y - r);
+    }
+    rlEnd();
+
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (int p = 0; p < field.particleCount; p++) {
+        float x = field.particleX[p];
+        float y = field.particleY[p];
+        rlColor4ub(GOLD.r, GOLD.g, GOLD.b, (unsigned char)(255.0f * field.particleLife[p] / STRESS_PARTICLE_LIFE));
+        rlTexCoord2f(0.0f, 0.0f); rlVertex2f(x - 1.0f, y - 1.0f);
+        rlTexCoord2f(0.0f, 1.0f); rlVertex2f(x - 1.0f, y + 1.0f);
+        rlTexCoord2f(1.0f, 1.0f); rlVertex2f(x + 1.0f, y + 1.0f);
+        rlTexCoord2f(1.0f, 0.0f); rlVertex2f(x + 1.0f, y - 1.0f);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    DrawRectangle((int)paddleX, (int)field.paddleY, paddleWidth, paddleHeight, foregroundColor);
+    stress.drawMs += ((GetTime() - start) * 1000.0 - stress.drawMs) * 0.05;
+
+    DrawRectangle(10, 10, 620, stress.autoTune || stress.sustained >= 0 ? 90 : 65, ColorAlpha(backgroundColor, 0.75f));
+    DrawText(TextFormat("%d balls  %d particles  %d FPS", field.count, field.particleCount, GetFPS()), 20, 20, 20, foregroundColor);
+    DrawText(TextFormat("Update %.2f ms  Draw %.2f ms (CPU)", stress.updateMs, stress.drawMs), 20, 45, 20, LIGHTGRAY);
+    if (stress.autoTune) {
+        DrawText(TextFormat("Finding the limit at %d FPS: holds %d, misses %s", STRESS_AUTO_FPS, stress.holds,
+                            stress.misses > 0 ? TextFormat("%d", stress.misses) : "-"), 20, 70, 20, GOLD);
+    } else if (stress.sustained >= 0) {
+        DrawText(TextFormat("%d balls sustain %d FPS", stress.sustained, STRESS_AUTO_FPS), 20, 70, 20, GREEN);
+    }
+    DrawText("UP/DOWN paddle   +/- balls   A find the limit   M menu", 20, screenHeight - 60, 20, LIGHTGRAY);
 }
 
 void DrawTransition() {
@@ -489,47 +1321,184 @@ void DrawTransition() {
 
 bool IsHighScore(int score, int leaderboardSize) {
     if (leaderboardSize == 0) return true;
-    // Only compare with the highest score (first score after sorting)
-    return score > leaderboardScores[0];
+    // Only compare with the highest score
+    return score > (scoreService ? ScoreClientTopScore() : RankedTopScore(scoreHistory, leaderboard));
 }
 
-int main() {
-    InitWindow(screenWidth, screenHeight, "Ping Pong Game");
-    InitAudioDevice();      // Initialize audio device
-    SetTargetFPS(120);
+int main(int argc, char** argv) {
+    const char* replayFile = NULL;
+    const char* latencyFile = NULL;
+    bool subFrameInput = true;
+    int stressBalls = 0;
+    bool stressAuto = false;
+    const char* scoreSocket = SCORE_SOCKET_DEFAULT;
+    bool localScores = false;
+    DisplaySettings displaySettings = DefaultDisplaySettings();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (strcmp(argv[i], "--input-latency") == 0 && i + 1 < argc) {
+            latencyFile = argv[++i];
+        } else if (strcmp(argv[i], "--frame-input") == 0) {
+            subFrameInput = false;
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc
+                   && sscanf(argv[i + 1], "%dx%d", &displaySettings.windowWidth, &displaySettings.windowHeight) == 2
+                   && displaySettings.windowWidth > 0 && displaySettings.windowHeight > 0) {
+            i++;
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            displaySettings.targetFps = atoi(argv[++i]);
+            if (displaySettings.targetFps != 0 && (displaySettings.targetFps < MIN_TARGET_FPS || displaySettings.targetFps > MAX_TARGET_FPS)) {
+                cerr << "--fps takes " << MIN_TARGET_FPS << " to " << MAX_TARGET_FPS << ", or 0 for uncapped" << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            displaySettings.vsync = true;
+        } else if (strcmp(argv[i], "--fullscreen") == 0) {
+            displaySettings.fullscreen = true;
+        } else if (strcmp(argv[i], "--raylib-pacing") == 0) {
+            displaySettings.precisePacing = false;
+        } else if (strcmp(argv[i], "--no-idle") == 0) {
+            idleScreens = false;
+        } else if (strcmp(argv[i], "--score-socket") == 0 && i + 1 < argc) {
+            scoreSocket = argv[++i];
+        } else if (strcmp(argv[i], "--local-scores") == 0) {
+            localScores = true;
+        } else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stressAuto = strcmp(argv[++i], "auto") == 0;
+            stressBalls = stressAuto ? STRESS_START_BALLS : atoi(argv[i]);
+            if (stressBalls < 1 || stressBalls > STRESS_MAX_BALLS) {
+                cerr << "--stress takes 1 to " << STRESS_MAX_BALLS << " balls, or auto" << endl;
+                return 1;
+            }
+        } else {
+            cerr << "usage: " << argv[0] << " [--trace trace.json] [--replay game.ppr]"
+                 << " [--input-latency latency.csv] [--frame-input]" << endl;
+            cerr << "       [--window WIDTHxHEIGHT] [--fullscreen] [--fps 60-500|0] [--vsync]"
+                 << " [--raylib-pacing] [--no-idle] [--stress BALLS|auto]" << endl;
+            cerr << "       [--score-socket PATH] [--local-scores]" << endl;
+            return 1;
+        }
+    }
+    Replay startReplay;
+    if (replayFile && !ReadReplay(replayFile, startReplay)) {
+        cerr << "Could not read replay " << replayFile << endl;
+        return 1;
+    }
+    if (traceFile) ProfilerStartTrace();
+    exitReports = traceFile || latencyFile;
+    PaddleInputInit(paddleInput, subFrameInput);
+    if (latencyFile && !PaddleInputLogLatency(paddleInput, latencyFile)) {
+        cerr << "Could not write " << latencyFile << endl;
+        return 1;
+    }
 
-    // Load sounds directly
-    bounceSound = LoadSound("resources/bounce.wav");    // Default raylib sound
-    buttonSound = LoadSound("resources/button.wav");    // Default raylib sound
-    gameoverSound = LoadSound("resources/gameover.wav");
-    highscoreSound = LoadSound("resources/highscore.wav");
-    
-    // Set volumes
-    SetSoundVolume(bounceSound, 0.5f);
-    SetSoundVolume(buttonSound, 0.5f);
-    SetSoundVolume(gameoverSound, 0.5f);
-    SetSoundVolume(highscoreSound, 0.8f);  // Higher volume for high score sound
-
-    Vector2 ballPosition = {(float)screenWidth / 2, (float)screenHeight / 2};
-    Vector2 ballVelocity = {-currentBallSpeed, currentBallSpeed};
-    Rectangle paddle = {30, (float)screenHeight / 2 - paddleHeight / 2, (float)paddleWidth, (float)paddleHeight};
-    int score = 0;
-    bool gameOver = false;
+    StartupMark("main");
+    DisplayInit(display, displaySettings, "Ping Pong Game");
+    StartupMark("window");
+    AssetsStart(soundAssets, sizeof(soundAssets) / sizeof(soundAssets[0]));
+
+    GameSimState game;
+    SimReset(game, BALL_SPEED_PRESETS[ballSpeedPreset]);
+    ChooseGameLoop();
+
+    // State from the previous simulation tick, blended with the current one when drawing
+    GameSimState prevGame = game;
 
     bool nameEntered = false;
     char playerName[MAX_NAME_LENGTH] = {'\0'};
     GameState currentState = MENU;
 
-    int leaderboardSize = LoadLeaderboard();
-    int scrollOffset = 0;
+    // Scores load in the background; the leaderboard fills in once they arrive.
+    // With the leaderboard service, the store only writes replays.
+    ScoreLogViewInit(scoreHistory);
+    LeaderboardInit(leaderboard);
+    scoreService = !localScores && ScoreClientStart(scoreSocket);
+    if (scoreService) {
+        cout << "Scores are kept by the leaderboard service at " << scoreSocket << endl;
+        ScoreStoreStart(NULL, NULL);
+    } else {
+        ScoreStoreStart("scores.bin", "scores.txt", "players.bin");
+    }
+    int leaderboardSize = 0;
+    ResetLeaderboardScreen();
 
     bool paused = false;
+    UiScreen lastScreen = SCREEN_MENU;
+    int staticFrames = 0;
+    bool firstFrame = true;
+    double lastFrameEnd = GetTime();
+    clock_t lastFrameCpu = clock();
+    if (replayFile) {
+        StartReplay(startReplay, game, prevGame);
+        nameEntered = true;
+        currentState = GAME;
+    } else if (stressBalls > 0) {
+        StressEnter(stressBalls, stressAuto);
+        currentState = STRESS;
+    }
 
     while (!WindowShouldClose()) {
         // Update music stream
         // UpdateMusicStream(backgroundMusic);
         
+        ProfilerBeginFrame();
+        double frameStart = GetTime();
+        bool wasGameOver = game.gameOver;
+        if (!ui.built || ui.width != screenWidth || ui.height != screenHeight || ui.darkTheme != isDarkTheme) {
+            BuildUiLayout();
+        }
+        if (IsKeyPressed(KEY_F3)) {
+            showSimStats = !showSimStats;
+            exitReports = true;
+        }
+        if (IsKeyPressed(KEY_F4)) {
+            showProfiler = !showProfiler;
+            ProfilerSetEnabled(showProfiler);
+        }
+
+        UiScreen screen = SCREEN_MENU;
+        switch (currentState) {
+            case GAME:
+                screen = !nameEntered ? SCREEN_NAME_INPUT : paused ? SCREEN_PAUSED
+                       : game.gameOver ? SCREEN_GAME_OVER : SCREEN_PLAYING;
+                break;
+            case LEADERBOARD: screen = SCREEN_LEADERBOARD; break;
+            case OPTIONS: screen = SCREEN_OPTIONS; break;
+            case STRESS: screen = SCREEN_STRESS; break;
+            default: break;
+        }
+
+        // The paddle input is read only during play, from a fresh baseline each time play starts
+        if (screen == SCREEN_PLAYING && !playback.active) {
+            if (lastScreen != SCREEN_PLAYING) PaddleInputReset(paddleInput, GetTime());
+            else PaddleInputPoll(paddleInput, GetTime());
+        }
+        lastScreen = screen;
+        {
+            PROFILE_SCOPE(PROFILE_SCORES);
+            if (scoreService) {
+                if (ScoreClientPoll(GetTime())) {
+                    leaderboardSize = ScoreClientTotal();
+                    leaderboardVersion++;
+                }
+                if (!ScoreClientConnected()) leaderboardSize = FallBackToLocalScores();
+            } else if (ScoreStorePoll(scoreHistory)) {
+                leaderboardSize = RankedScoreCount(scoreHistory, leaderboard);
+                leaderboardVersion++;
+            }
+        }
+        if (AssetsPoll()) {
+            AssetsPrintStartup();
+            AudioStart(soundAssets, sizeof(soundAssets) / sizeof(soundAssets[0]));
+        }
+        AudioBeginTick();   // Menu clicks get their own event budget each frame
+
+        bool profileDraw = profilerEnabled;
+        if (profileDraw) ProfilerBeginScope(PROFILE_DRAW);
         BeginDrawing();
+        DisplayBeginFrame(display);
         ClearBackground(backgroundColor);
 
         // Draw fade transition
@@ -539,11 +1508,16 @@ int main() {
             case MENU:
                 DrawMenu(currentState);
                 if (currentState == GAME) {  // If state changed to GAME in DrawMenu
-                    PlaySound(buttonSound);  // Play click sound when starting game
-                    ResetGame(ballPosition, ballVelocity, paddle, score, gameOver);
+                    PlayGameSound(SOUND_BUTTON);  // Play click sound when starting game
+                    ResetGame(game);
+                    prevGame = game;
                     nameEntered = false;
                     memset(playerName, 0, MAX_NAME_LENGTH);
                 }
+                if (IsKeyPressed(KEY_F6)) {
+                    StressEnter(STRESS_START_BALLS, false);
+                    currentState = STRESS;
+                }
                 break;
 
             case GAME:
@@ -552,47 +1526,63 @@ int main() {
                 } else if (paused) {
                     DrawPaused();
                     HandlePause(paused, currentState);
-                } else if (gameOver) {
-                    const char* gameOverText = "Game Over!";
-                    const char* scoreText = TextFormat("Score: %d", score);
-                    const char* menuText = "Press ENTER to return to menu";
-                    
-                    int gameOverWidth = MeasureText(gameOverText, 60);
-                    int scoreWidth = MeasureText(scoreText, 40);
-                    int menuWidth = MeasureText(menuText, 25);
-                    
-                    DrawText(gameOverText, screenWidth/2 - gameOverWidth/2, screenHeight/2 - 120, 60, RED);
-                    DrawText(scoreText, screenWidth/2 - scoreWidth/2, screenHeight/2, 40, foregroundColor);
-                    DrawText(menuText, screenWidth/2 - menuWidth/2, screenHeight/2 + 100, 25, LIGHTGRAY);
+                } else if (game.gameOver) {
+                    const char* scoreText = NumberText(ui.gameOverScore, game.score);
+                    DrawLabel(ui.gameOverTitle, RED);
+                    DrawText(scoreText, screenWidth/2 - ui.gameOverScore.width/2, screenHeight/2, 40, foregroundColor);
+                    DrawLabel(ui.gameOverHint, LIGHTGRAY);
 
                     // Check and display high score message
-                    if (IsHighScore(score, leaderboardSize)) {
-                        const char* newHighScoreText = "New High Score!";
-                        int highScoreWidth = MeasureText(newHighScoreText, 50);
-                        DrawText(newHighScoreText, screenWidth/2 - highScoreWidth/2, 
-                               screenHeight/2 - 180, 50, GOLD);
+                    if (playback.active) {
+                        DrawLabel(playback.verified ? ui.replayVerified : ui.replayMismatch, playback.verified ? GREEN : RED);
+                    } else if (IsHighScore(game.score, leaderboardSize)) {
+                        DrawLabel(ui.newHighScore, GOLD);
+                    }
+                    if (!playback.active) DrawLabel(ui.gameOverReplayHint, LIGHTGRAY);
+
+                    if (showSimStats) {
+                        DrawText(TextFormat("Game over frame: %.2f ms (typical %.2f ms)", gameOverFrameWorkMs, typicalFrameWorkMs),
+                                 20, 20, 20, LIGHTGRAY);
                     }
 
-                    if (IsKeyPressed(KEY_ENTER)) {
-                        PlaySound(buttonSound);  // Play click sound when returning to menu
-                        SaveScore(playerName, score);
-                        leaderboardSize = LoadLeaderboard();
-                        ResetGame(ballPosition, ballVelocity, paddle, score, gameOver);
+                    if (IsKeyPressed(KEY_R) && !playback.active) {
+                        PlayGameSound(SOUND_BUTTON);
+                        leaderboardSize = SubmitScore(playerName, game.score);
+                        StartReplay(recordedReplay, game, prevGame);
+                    } else if (IsKeyPressed(KEY_ENTER)) {
+                        PlayGameSound(SOUND_BUTTON);  // Play click sound when returning to menu
+                        if (playback.active) {
+                            StopReplay();
+                        } else {
+                            leaderboardSize = SubmitScore(playerName, game.score);
+                        }
+                        ResetGame(game);
+                        prevGame = game;
                         currentState = MENU;
                     }
                 } else {
-                    float deltaTime = GetFrameTime();
-                    UpdateGame(deltaTime, ballPosition, ballVelocity, paddle, score, gameOver);
+                    float frameTime = DisplayFrameTime(display);
+                    float alpha = gameLoop.runSimulation(frameTime, game, prevGame);
                     HandlePause(paused, currentState);
+                    gameLoop.drawPlayfield(game, prevGame, alpha);
+                    if (showSimStats) DrawSimStats();
 
-                    DrawCircleV(ballPosition, ballRadius, foregroundColor);
-                    DrawRectangleRec(paddle, foregroundColor);
-                    DrawText(TextFormat("Score: %d", score), 20, 20, 20, foregroundColor);
+                    if (playback.active) {
+                        if (IsKeyPressed(KEY_RIGHT) && playback.speed < MAX_REPLAY_SPEED) playback.speed *= 2;
+                        if (IsKeyPressed(KEY_LEFT) && playback.speed > 1) playback.speed /= 2;
+                        DrawReplayStatus();
+                        if (IsKeyPressed(KEY_M)) {
+                            StopReplay();
+                            ResetGame(game);
+                            prevGame = game;
+                            currentState = MENU;
+                        }
+                    }
                 }
                 break;
 
             case LEADERBOARD:
-                DrawLeaderboard(leaderboardSize, scrollOffset, currentState);
+                DrawLeaderboard(leaderboardSize, playerName, currentState);
                 if (IsKeyPressed(KEY_M)) currentState = MENU;
                 break;
 
@@ -600,20 +1590,86 @@ int main() {
                 DrawOptions(currentState);
                 break;
 
+            case STRESS:
+                UpdateStress(DisplayFrameTime(display));
+                DrawStress();
+                if (IsKeyPressed(KEY_M)) {
+                    StressLeave();
+                    currentState = MENU;
+                }
+                break;
+
             case QUIT:
                 CloseWindow();
                 break;
         }
 
+        // Time this frame's work and single out the frame where the game ended
+        frameWorkMs = (GetTime() - frameStart) * 1000.0;
+        typicalFrameWorkMs += (frameWorkMs - typicalFrameWorkMs) * 0.05;
+        screenWorkMs[screen] += (frameWorkMs - screenWorkMs[screen]) * 0.05;
+        if (showSimStats) {
+            double cpuShare = screenWallSeconds[screen] > 0.0 ? 100.0 * screenCpuSeconds[screen] / screenWallSeconds[screen] : 0.0;
+            DrawText(TextFormat("%s: %.3f ms CPU per frame, %.1f%% CPU   Present error: %.3f ms", uiScreenNames[screen],
+                                screenWorkMs[screen], cpuShare, display.presentErrorMs),
+                     20, screenHeight - 30, 20, LIGHTGRAY);
+        }
+        if (!wasGameOver && game.gameOver) {
+            gameOverFrameWorkMs = frameWorkMs;
+
+            if (playback.active) {
+                playback.verified = game.tick == (long long)playback.replay.header.ticks
+                                 && SimStateChecksum(game) == playback.replay.header.finalChecksum;
+            } else {
+                ReplayFinish(recordedReplay, game);
+                SaveReplay(playerName);
+            }
+        }
+        if (showProfiler) DrawProfiler();
+        DisplayEndFrame(display);
+        if (profileDraw) ProfilerEndScope(PROFILE_DRAW);
+
+        DisplaySetFrameMode(display, ChooseFrameMode(screen, staticFrames));
+        PROFILE_SCOPE(PROFILE_PRESENT);
+        DisplayPace(display);
+        double submitTime = GetTime();
         EndDrawing();
+        DisplayPresented(display);
+        if (firstFrame) StartupMark("first frame");
+        firstFrame = false;
+        if (paddleInput.latencyLog) PaddleInputPresented(paddleInput, submitTime, GetTime());
+
+        // Charge this frame, waits included, to its screen
+        double frameEnd = GetTime();
+        clock_t cpuNow = clock();
+        screenWallSeconds[screen] += frameEnd - lastFrameEnd;
+        screenCpuSeconds[screen] += (double)(cpuNow - lastFrameCpu) / CLOCKS_PER_SEC;
+        lastFrameEnd = frameEnd;
+        lastFrameCpu = cpuNow;
     }
 
     // Cleanup
-    UnloadSound(bounceSound);
-    UnloadSound(buttonSound);
-    UnloadSound(gameoverSound);
-    UnloadSound(highscoreSound);
-    CloseAudioDevice();
+    if (exitReports) PrintScreenCpuReport();
+    PaddleInputClose(paddleInput);
+    if (traceFile) {
+        if (ProfilerWriteTrace(traceFile)) cout << "Wrote trace to " << traceFile << endl;
+        else cerr << "Could not write trace to " << traceFile << endl;
+    }
+    if (scoreService) ScoreClientStop();
+    ScoreStoreStop();
+    ScoreLogViewClose(scoreHistory);
+    AudioStats audio = AudioGetStats();
+    if (exitReports && audio.posted > 0) {
+        printf("Audio: %lld sound events, %lld played, %lld dropped (queue full), %lld over the tick cap, %lld voices cut off\n",
+               audio.posted, audio.played, audio.droppedFull, audio.droppedCap, audio.stolen);
+    }
+    AudioStop();
+    AssetsClose();
+    if (stress.loaded) {
+        UnloadTexture(stress.ballTexture);
+        StressFree(stress.field);
+    }
+    DisplayClose(display);
     CloseWindow();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "player_stats.h"
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const int INITIAL_STATS_SLOTS = 64;
+
+static unsigned int HashName(const char* name) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (; *name; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Names are kept cut to MAX_NAME_LENGTH - 1 characters, like the leaderboard's
+static void CopyName(char (&to)[MAX_NAME_LENGTH], const char* name) {
+    memset(to, 0, sizeof(to));
+    strncpy(to, name, MAX_NAME_LENGTH - 1);
+}
+
+// Slot holding the player, or the empty slot where they would go
+static int FindPlayerSlot(const PlayerStatsTable &stats, const char* name) {
+    int mask = (int)stats.playerSlots.size() - 1;
+    int slot = (int)(HashName(name) & mask);
+    while (stats.playerSlots[slot] >= 0 && strcmp(stats.players[stats.playerSlots[slot]].name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void GrowPlayerSlots(PlayerStatsTable &stats) {
+    size_t size = stats.playerSlots.size() * 2;
+    stats.playerSlots.assign(size, -1);
+    for (size_t i = 0; i < stats.players.size(); i++) {
+        stats.playerSlots[FindPlayerSlot(stats, stats.players[i].name)] = (int)i;
+    }
+}
+
+static void SealRecord(PlayerStatsRecord &record) {
+    record.checksum = Crc32(&record, offsetof(PlayerStatsRecord, checksum));
+}
+
+static bool RecordValid(const PlayerStatsRecord &record) {
+    return record.checksum == Crc32(&record, offsetof(PlayerStatsRecord, checksum))
+        && memchr(record.name, '\0', MAX_NAME_LENGTH) != NULL && record.name[0] != '\0';
+}
+
+// Adds count games to a bucket of the histogram and its Fenwick tree
+static void AddToBucket(PlayerStatsTable &stats, int bucket, uint32_t count) {
+    stats.histogram[bucket] += count;
+    for (int i = bucket + 1; i <= STATS_SCORE_BUCKETS; i += i & -i) stats.tree[i] += count;
+}
+
+// Games in buckets below bucket
+static long long GamesBelow(const PlayerStatsTable &stats, int bucket) {
+    long long games = 0;
+    for (int i = bucket; i > 0; i -= i & -i) games += stats.tree[i];
+    return games;
+}
+
+// Rebuilds the Fenwick tree from the histogram in one pass
+static void BuildTree(PlayerStatsTable &stats) {
+    stats.tree.assign(STATS_SCORE_BUCKETS + 1, 0);
+    stats.games = 0;
+    for (int i = 1; i <= STATS_SCORE_BUCKETS; i++) {
+        stats.tree[i] += stats.histogram[i - 1];
+        stats.games += stats.histogram[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= STATS_SCORE_BUCKETS) stats.tree[parent] += stats.tree[i];
+    }
+}
+
+void PlayerStatsInit(PlayerStatsTable &stats) {
+    stats.players.clear();
+    stats.playerSlots.assign(INITIAL_STATS_SLOTS, -1);
+    stats.histogram.assign(STATS_SCORE_BUCKETS, 0);
+    stats.tree.assign(STATS_SCORE_BUCKETS + 1, 0);
+    stats.games = 0;
+}
+
+int PlayerStatsBucket(int score) {
+    if (score < 0) return 0;
+    return score < STATS_SCORE_BUCKETS ? score : STATS_SCORE_BUCKETS - 1;
+}
+
+int PlayerStatsFind(const PlayerStatsTable &stats, const char* name) {
+    char key[MAX_NAME_LENGTH];
+    CopyName(key, name);
+    return stats.playerSlots[FindPlayerSlot(stats, key)];
+}
+
+int PlayerStatsAdd(PlayerStatsTable &stats, const char* name, const GameSummary &game) {
+    char key[MAX_NAME_LENGTH];
+    CopyName(key, name);
+    if ((stats.players.size() + 1) * 2 > stats.playerSlots.size()) GrowPlayerSlots(stats);
+    int slot = FindPlayerSlot(stats, key);
+    if (stats.playerSlots[slot] < 0) {
+        PlayerStatsRecord record;
+        memset(&record, 0, sizeof(record));
+        memcpy(record.name, key, sizeof(record.name));
+        stats.playerSlots[slot] = (int)stats.players.size();
+        stats.players.push_back(record);
+    }
+
+    int player = stats.playerSlots[slot];
+    PlayerStatsRecord &record = stats.players[player];
+    if (record.games == 0 || game.score > record.best) record.best = game.score;
+    if (game.longestRally > record.longestRally) record.longestRally = game.longestRally;
+    if (game.maxBallSpeed > record.maxBallSpeed) record.maxBallSpeed = game.maxBallSpeed;
+    record.games++;
+    record.totalScore += game.score;
+    SealRecord(record);
+
+    AddToBucket(stats, PlayerStatsBucket(game.score), 1);
+    stats.games++;
+    return player;
+}
+
+float PlayerStatsPercentile(const PlayerStatsTable &stats, int score) {
+    if (stats.games == 0) return 0.0f;
+    return (float)(100.0 * GamesBelow(stats, PlayerStatsBucket(score)) / stats.games);
+}
+
+PlayerSummary PlayerStatsSummary(const PlayerStatsTable &stats, const char* name) {
+    PlayerSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    int player = PlayerStatsFind(stats, name);
+    if (player < 0) return summary;
+
+    const PlayerStatsRecord &record = stats.players[player];
+    summary.games = record.games;
+    summary.best = record.best;
+    summary.mean = record.games > 0 ? (float)((double)record.totalScore / record.games) : 0.0f;
+    summary.percentile = PlayerStatsPercentile(stats, record.best);
+    summary.longestRally = record.longestRally;
+    summary.maxBallSpeed = record.maxBallSpeed;
+    return summary;
+}
+
+static void MakeHeader(PlayerStatsHeader &header, uint32_t playerCount) {
+    memcpy(header.magic, PLAYER_STATS_MAGIC, sizeof(header.magic));
+    header.version = PLAYER_STATS_VERSION;
+    header.playerCount = playerCount;
+    header.bucketCount = STATS_SCORE_BUCKETS;
+}
+
+static bool WriteAllAt(int fd, const void* data, size_t size, off_t offset) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+static off_t HistogramOffset(int bucket) {
+    return (off_t)sizeof(PlayerStatsHeader) + (off_t)bucket * (off_t)sizeof(uint32_t);
+}
+
+static off_t RecordOffset(int player) {
+    return HistogramOffset(STATS_SCORE_BUCKETS) + (off_t)player * (off_t)sizeof(PlayerStatsRecord);
+}
+
+bool ReadPlayerStats(const char* path, PlayerStatsTable &stats, int* badRecords) {
+    PlayerStatsInit(stats);
+    if (badRecords) *badRecords = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < RecordOffset(0)) {
+        close(fd);
+        return false;
+    }
+
+    // The whole file in one read
+    vector<char> data(info.st_size);
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = read(fd, &data[got], data.size() - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fd);
+
+    PlayerStatsHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    if (got < (size_t)RecordOffset(0) || memcmp(header.magic, PLAYER_STATS_MAGIC, sizeof(header.magic)) != 0
+        || header.version != PLAYER_STATS_VERSION || header.bucketCount != (uint32_t)STATS_SCORE_BUCKETS) {
+        return false;
+    }
+
+    memcpy(&stats.histogram[0], &data[HistogramOffset(0)], STATS_SCORE_BUCKETS * sizeof(uint32_t));
+    BuildTree(stats);
+
+    // A crash between writing a new player and the header leaves one record past the count
+    size_t count = (got - RecordOffset(0)) / sizeof(PlayerStatsRecord);
+    if (count > header.playerCount) count = header.playerCount;
+    stats.players.reserve(count);
+    size_t slots = INITIAL_STATS_SLOTS;
+    while (slots < count * 2) slots *= 2;
+    stats.playerSlots.assign(slots, -1);
+    for (size_t i = 0; i < count; i++) {
+        PlayerStatsRecord record;
+        memcpy(&record, &data[RecordOffset((int)i)], sizeof(record));
+        int slot = RecordValid(record) ? FindPlayerSlot(stats, record.name) : -1;
+        if (slot < 0 || stats.playerSlots[slot] >= 0) {
+            if (badRecords) (*badRecords)++;
+            continue;
+        }
+        stats.playerSlots[slot] = (int)stats.players.size();
+        stats.players.push_back(record);
+    }
+    if (badRecords && count < header.playerCount) *badRecords += (int)(header.playerCount - count);
+    return true;
+}
+
+bool WritePlayerStats(const char* path, const PlayerStatsTable &stats) {
+    PlayerStatsHeader header;
+    MakeHeader(header, (uint32_t)stats.players.size());
+    FileChunk chunks[] = {
+        {&header, sizeof(header)},
+        {stats.histogram.data(), stats.histogram.size() * sizeof(uint32_t)},
+        {stats.players.data(), stats.players.size() * sizeof(PlayerStatsRecord)}
+    };
+    return WriteFileAtomic(path, chunks, 3);
+}
+
+void PlayerStatsFromLog(const ScoreRecord* records, int count, PlayerStatsTable &stats) {
+    PlayerStatsInit(stats);
+    GameSummary game = {0, 0, 0.0f};
+    for (int i = 0; i < count; i++) {
+        if (!ScoreRecordValid(records[i])) continue;
+        game.score = records[i].score;
+        PlayerStatsAdd(stats, records[i].name, game);
+    }
+}
+
+bool UpdatePlayerStatsFile(int fd, const PlayerStatsTable &stats, int player, int score) {
+    // Record first: a header counting a record that is not there yet would be worse
+    PlayerStatsHeader header;
+    MakeHeader(header, (uint32_t)stats.players.size());
+    int bucket = PlayerStatsBucket(score);
+    return WriteAllAt(fd, &stats.players[player], sizeof(PlayerStatsRecord), RecordOffset(player))
+        && WriteAllAt(fd, &stats.histogram[bucket], sizeof(uint32_t), HistogramOffset(bucket))
+        && WriteAllAt(fd, &header, sizeof(header), 0);
+}
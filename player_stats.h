@@ -0,0 +1,107 @@
+#ifndef PLAYER_STATS_H
+#define PLAYER_STATS_H
+
+#include <stdint.h>
+#include <vector>
+#include "leaderboard.h"
+#include "score_log.h"
+
+// Per-player aggregates, updated as each game ends instead of recomputed
+// from the score log, so a player's summary costs the same for ten games
+// or ten million: the name lookup is a hash probe, and the percentile
+// comes from a Fenwick tree over a histogram of every game's score, whose
+// size depends only on STATS_SCORE_BUCKETS.
+//
+// Player stats file (players.bin):
+//
+//   header      16 bytes: "PPPS", version, player count, bucket count
+//   histogram   one uint32 per score bucket: games that ended with that score
+//   players     80 bytes each, in the order the players first finished a game
+//
+// A finished game rewrites its player's record, one histogram count and,
+// for a new player, the header, in place. Every record carries a CRC-32,
+// so one torn by a crash is skipped on the next load. The file holds the
+// structs below as they are in memory (see score_log.h on byte order).
+
+const char PLAYER_STATS_MAGIC[4] = {'P', 'P', 'P', 'S'};
+const uint32_t PLAYER_STATS_VERSION = 1;
+const int STATS_SCORE_BUCKETS = 16384;      // One per score; higher scores share the last
+
+struct PlayerStatsHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t playerCount;
+    uint32_t bucketCount;
+};
+
+struct PlayerStatsRecord {
+    char name[MAX_NAME_LENGTH];     // NUL padded
+    char reserved[2];
+    uint32_t games;
+    int32_t best;
+    int32_t longestRally;           // Most paddle hits between two points
+    int64_t totalScore;
+    float maxBallSpeed;             // Fastest the ball went, pixels/s
+    uint32_t checksum;              // CRC-32 of the bytes above
+};
+static_assert(sizeof(PlayerStatsRecord) == 80, "player stats records are 80 bytes on disk");
+
+// What a finished game adds to its player's stats
+struct GameSummary {
+    int score;
+    int longestRally;
+    float maxBallSpeed;
+};
+
+// A player's stats as the leaderboard shows them
+struct PlayerSummary {
+    uint32_t games;         // 0 if the player has not finished a game
+    int32_t best;
+    float mean;
+    float percentile;       // Share of all recorded games that scored below best, 0 to 100
+    int32_t longestRally;
+    float maxBallSpeed;
+};
+static_assert(sizeof(PlayerSummary) == 24, "player summaries are 24 bytes on the wire");
+
+struct PlayerStatsTable {
+    std::vector<PlayerStatsRecord> players;
+    std::vector<int> playerSlots;       // Open-addressing name index: player, or -1
+    std::vector<uint32_t> histogram;    // Games per score bucket
+    std::vector<uint32_t> tree;         // Fenwick tree over histogram
+    long long games;
+};
+
+void PlayerStatsInit(PlayerStatsTable &stats);
+
+// Player index, or -1. O(1) on average
+int PlayerStatsFind(const PlayerStatsTable &stats, const char* name);
+
+// Adds one finished game and returns its player's index. O(1) on average
+// plus O(log STATS_SCORE_BUCKETS) for the histogram.
+int PlayerStatsAdd(PlayerStatsTable &stats, const char* name, const GameSummary &game);
+
+PlayerSummary PlayerStatsSummary(const PlayerStatsTable &stats, const char* name);
+
+// Share of recorded games that scored below score, 0 to 100. O(log STATS_SCORE_BUCKETS)
+float PlayerStatsPercentile(const PlayerStatsTable &stats, int score);
+
+int PlayerStatsBucket(int score);
+
+// Loads a stats file; false if it is missing or not a stats file.
+// badRecords counts records that failed their checksum and were skipped,
+// after which the file no longer matches the table and must be rewritten.
+bool ReadPlayerStats(const char* path, PlayerStatsTable &stats, int* badRecords);
+
+// Atomically replaces the file with the whole table
+bool WritePlayerStats(const char* path, const PlayerStatsTable &stats);
+
+// Builds stats from a score log, for logs that predate the stats file.
+// Rallies and ball speeds were not recorded, so they start at 0.
+void PlayerStatsFromLog(const ScoreRecord* records, int count, PlayerStatsTable &stats);
+
+// Writes what PlayerStatsAdd changed for this player and score in place,
+// without syncing. fd is the stats file opened for reading and writing.
+bool UpdatePlayerStatsFile(int fd, const PlayerStatsTable &stats, int player, int score);
+
+#endif
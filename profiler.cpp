@@ -0,0 +1,139 @@
+#include "profiler.h"
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+const char* profileSectionNames[PROFILE_SECTION_COUNT] = {"update", "draw", "scores", "sound", "present"};
+
+bool profilerEnabled = false;
+
+struct TraceEvent {
+    int section;
+    long long startUs;
+    long long durationUs;
+};
+
+static chrono::steady_clock::time_point profilerEpoch = chrono::steady_clock::now();
+
+// Open scopes, innermost last, with the time their children took
+static double scopeStart[MAX_PROFILE_DEPTH];
+static double scopeChildren[MAX_PROFILE_DEPTH];
+static int scopeDepth = 0;
+static int scopeOverflow = 0;   // Scopes opened past MAX_PROFILE_DEPTH, not timed
+
+// Current frame, then the ring of finished ones
+static double frameStart = -1.0;
+static double frameSections[PROFILE_SECTION_COUNT];
+static double historyFrameMs[PROFILE_HISTORY];
+static double historySectionMs[PROFILE_HISTORY][PROFILE_SECTION_COUNT];
+static int historyCount = 0;
+static int historyNext = 0;
+
+static bool tracing = false;
+static vector<TraceEvent> traceEvents;
+
+static double NowMs() {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+void ProfilerSetEnabled(bool enabled) {
+    profilerEnabled = enabled || tracing;
+    if (!profilerEnabled) {
+        scopeDepth = scopeOverflow = 0;
+        frameStart = -1.0;
+    }
+}
+
+void ProfilerStartTrace() {
+    tracing = true;
+    traceEvents.reserve(65536);
+    ProfilerSetEnabled(true);
+}
+
+void ProfilerBeginFrame() {
+    if (!profilerEnabled) return;
+    double now = NowMs();
+    if (frameStart >= 0.0) {
+        historyFrameMs[historyNext] = now - frameStart;
+        for (int i = 0; i < PROFILE_SECTION_COUNT; i++) historySectionMs[historyNext][i] = frameSections[i];
+        historyNext = (historyNext + 1) % PROFILE_HISTORY;
+        if (historyCount < PROFILE_HISTORY) historyCount++;
+    }
+    frameStart = now;
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) frameSections[i] = 0.0;
+}
+
+void ProfilerBeginScope(int section) {
+    (void)section;
+    if (scopeDepth == MAX_PROFILE_DEPTH) {
+        scopeOverflow++;
+        return;
+    }
+    scopeStart[scopeDepth] = NowMs();
+    scopeChildren[scopeDepth] = 0.0;
+    scopeDepth++;
+}
+
+void ProfilerEndScope(int section) {
+    if (scopeOverflow > 0) {
+        scopeOverflow--;
+        return;
+    }
+    if (scopeDepth == 0) return;
+    scopeDepth--;
+    double elapsed = NowMs() - scopeStart[scopeDepth];
+
+    // Sections are exclusive: time in nested scopes counts for those only
+    frameSections[section] += elapsed - scopeChildren[scopeDepth];
+    if (scopeDepth > 0) scopeChildren[scopeDepth - 1] += elapsed;
+
+    if (tracing && traceEvents.size() < (size_t)MAX_TRACE_EVENTS) {
+        TraceEvent event;
+        event.section = section;
+        event.startUs = (long long)(scopeStart[scopeDepth] * 1000.0);
+        event.durationUs = (long long)(elapsed * 1000.0);
+        traceEvents.push_back(event);
+    }
+}
+
+double ProfilerFrameMs(int framesAgo) {
+    if (framesAgo < 0 || framesAgo >= historyCount) return 0.0;
+    return historyFrameMs[(historyNext - 1 - framesAgo + PROFILE_HISTORY) % PROFILE_HISTORY];
+}
+
+void ProfilerGetStats(ProfilerStats &stats) {
+    stats.frames = historyCount;
+    stats.p50Ms = stats.p99Ms = stats.maxMs = 0.0;
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) stats.sectionMs[s] = 0.0;
+    if (historyCount == 0) return;
+
+    double sorted[PROFILE_HISTORY];
+    for (int i = 0; i < historyCount; i++) {
+        sorted[i] = historyFrameMs[i];
+        for (int s = 0; s < PROFILE_SECTION_COUNT; s++) stats.sectionMs[s] += historySectionMs[i][s];
+    }
+    sort(sorted, sorted + historyCount);
+    stats.p50Ms = sorted[historyCount / 2];
+    stats.p99Ms = sorted[min(historyCount - 1, historyCount * 99 / 100)];
+    stats.maxMs = sorted[historyCount - 1];
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) stats.sectionMs[s] /= historyCount;
+}
+
+bool ProfilerWriteTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    // Chrome trace event format: complete ("X") events in microseconds
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < traceEvents.size(); i++) {
+        const TraceEvent &event = traceEvents[i];
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1}%s\n",
+                profileSectionNames[event.section], event.startUs, event.durationUs,
+                i + 1 < traceEvents.size() ? "," : "");
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Frame profiler: scoped timers per section, a rolling history of frame
+// times and an optional Chrome trace (open it in chrome://tracing or
+// Perfetto). Main thread only. While disabled a scope is one branch on a
+// global flag and never reads the clock.
+
+enum ProfileSection {
+    PROFILE_UPDATE,         // Simulation ticks
+    PROFILE_DRAW,           // Building the frame's draw calls
+    PROFILE_SCORES,         // Leaderboard and score file work
+    PROFILE_SOUND,          // Audio calls
+    PROFILE_PRESENT,        // EndDrawing: buffer swap and frame pacing wait
+    PROFILE_SECTION_COUNT
+};
+
+extern const char* profileSectionNames[PROFILE_SECTION_COUNT];
+
+const int PROFILE_HISTORY = 240;        // Frames kept for the graph and percentiles
+const int MAX_PROFILE_DEPTH = 16;
+const int MAX_TRACE_EVENTS = 2000000;   // About 64 MB; later events are dropped
+
+// Over the frames in the history
+struct ProfilerStats {
+    int frames;
+    double p50Ms, p99Ms, maxMs;
+    double sectionMs[PROFILE_SECTION_COUNT];    // Average per frame, excluding nested sections
+};
+
+extern bool profilerEnabled;
+
+void ProfilerSetEnabled(bool enabled);
+// Records every scope from now on for ProfilerWriteTrace; enables the profiler
+void ProfilerStartTrace();
+
+// Call once per frame, at the same point of the loop
+void ProfilerBeginFrame();
+
+void ProfilerBeginScope(int section);
+void ProfilerEndScope(int section);
+
+// Frame time in ms, 0 the newest finished frame; 0 if not recorded
+double ProfilerFrameMs(int framesAgo);
+void ProfilerGetStats(ProfilerStats &stats);
+
+bool ProfilerWriteTrace(const char* path);
+
+struct ProfileScope {
+    int section;
+    bool active;
+    explicit ProfileScope(int section) : section(section), active(profilerEnabled) {
+        if (active) ProfilerBeginScope(section);
+    }
+    ~ProfileScope() {
+        if (active) ProfilerEndScope(section);
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(section)
+
+#endif
@@ -0,0 +1,178 @@
+#include "replay.h"
+#include "score_log.h"
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+uint32_t SimStateChecksum(const GameSimState &state) {
+    // Packed field by field so struct padding never reaches the checksum.
+    // The opponent is only included when there is one.
+    unsigned char bytes[6 * sizeof(float) + sizeof(int32_t) + 1 + sizeof(int64_t)];
+    unsigned char* p = bytes;
+    memcpy(p, &state.ballX, sizeof(float)); p += sizeof(float);
+    memcpy(p, &state.ballY, sizeof(float)); p += sizeof(float);
+    memcpy(p, &state.ballVelocityX, sizeof(float)); p += sizeof(float);
+    memcpy(p, &state.ballVelocityY, sizeof(float)); p += sizeof(float);
+    memcpy(p, &state.paddleY, sizeof(float)); p += sizeof(float);
+    int32_t score = state.score;
+    memcpy(p, &score, sizeof(score)); p += sizeof(score);
+    *p++ = state.gameOver ? 1 : 0;
+    int64_t tick = state.tick;
+    memcpy(p, &tick, sizeof(tick)); p += sizeof(tick);
+    if (state.opponent) {
+        memcpy(p, &state.opponentY, sizeof(float)); p += sizeof(float);
+    }
+    return Crc32(bytes, p - bytes);
+}
+
+float ReplayTickTime(const ReplayHeader &header) {
+    return (float)(1.0 / header.tickRate);
+}
+
+OpponentLevel ReplayOpponent(const ReplayHeader &header) {
+    int level = (header.flags & REPLAY_OPPONENT_MASK) >> REPLAY_OPPONENT_SHIFT;
+    return level < OPPONENT_LEVEL_COUNT ? (OpponentLevel)level : OPPONENT_NONE;
+}
+
+static uint32_t ReplayChecksum(const ReplayHeader &header, const unsigned char* inputs) {
+    vector<unsigned char> bytes(offsetof(ReplayHeader, checksum) + header.inputBytes);
+    memcpy(&bytes[0], &header, offsetof(ReplayHeader, checksum));
+    if (header.inputBytes > 0) memcpy(&bytes[offsetof(ReplayHeader, checksum)], inputs, header.inputBytes);
+    return Crc32(&bytes[0], bytes.size());
+}
+
+void ReplayBegin(Replay &replay, float ballSpeed, int tickRate, bool darkTheme, OpponentLevel opponent, uint32_t seed) {
+    memset(&replay.header, 0, sizeof(replay.header));
+    memcpy(replay.header.magic, REPLAY_MAGIC, sizeof(replay.header.magic));
+    replay.header.version = REPLAY_VERSION;
+    replay.header.flags = (uint16_t)((darkTheme ? REPLAY_DARK_THEME : 0) | opponent << REPLAY_OPPONENT_SHIFT);
+    replay.header.seed = seed;
+    replay.header.tickRate = (uint32_t)tickRate;
+    replay.header.ballSpeed = ballSpeed;
+    replay.inputs.clear();
+    replay.runInput = -1;
+    replay.runLength = 0;
+}
+
+// One int per distinct tick input: up, down, analog flag, then the axis byte
+static int ReplayInputCode(const SimInput &input) {
+    return (input.up ? 1 : 0) | (input.down ? 2 : 0) | (input.axis != 0 ? 4 : 0) | ((unsigned char)input.axis << 3);
+}
+
+static void FlushRun(Replay &replay) {
+    if (replay.runLength == 0) return;
+    uint64_t value = (uint64_t)(replay.runLength - 1) << 3 | (uint64_t)(replay.runInput & 7);
+    while (value >= 0x80) {
+        replay.inputs.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    replay.inputs.push_back((unsigned char)value);
+    if (replay.runInput & 4) replay.inputs.push_back((unsigned char)(replay.runInput >> 3));
+    replay.runLength = 0;
+}
+
+void ReplayRecord(Replay &replay, const SimInput &input) {
+    int code = ReplayInputCode(input);
+    if (code != replay.runInput || replay.runLength == 0xFFFFFFFFu) {
+        FlushRun(replay);
+        replay.runInput = code;
+    }
+    replay.runLength++;
+    replay.header.ticks++;
+}
+
+void ReplayFinish(Replay &replay, const GameSimState &finalState) {
+    FlushRun(replay);
+    replay.header.finalScore = finalState.score;
+    replay.header.finalChecksum = SimStateChecksum(finalState);
+    replay.header.inputBytes = (uint32_t)replay.inputs.size();
+    replay.header.checksum = ReplayChecksum(replay.header, replay.inputs.empty() ? NULL : &replay.inputs[0]);
+}
+
+void EncodeReplay(const Replay &replay, vector<unsigned char> &bytes) {
+    bytes.resize(sizeof(ReplayHeader) + replay.inputs.size());
+    memcpy(&bytes[0], &replay.header, sizeof(ReplayHeader));
+    if (!replay.inputs.empty()) memcpy(&bytes[sizeof(ReplayHeader)], &replay.inputs[0], replay.inputs.size());
+}
+
+bool DecodeReplay(const unsigned char* data, size_t size, Replay &replay) {
+    if (size < sizeof(ReplayHeader)) return false;
+    ReplayHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 || header.version != REPLAY_VERSION
+        || header.tickRate == 0 || header.inputBytes != size - sizeof(ReplayHeader)
+        || header.checksum != ReplayChecksum(header, data + sizeof(ReplayHeader))) {
+        return false;
+    }
+    replay.header = header;
+    replay.inputs.assign(data + sizeof(ReplayHeader), data + size);
+    replay.runInput = -1;
+    replay.runLength = 0;
+    return true;
+}
+
+bool ReadReplay(const char* path, Replay &replay) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    vector<unsigned char> data;
+    unsigned char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + n);
+    fclose(file);
+    return !data.empty() && DecodeReplay(&data[0], data.size(), replay);
+}
+
+void ReplayPlayerStart(ReplayPlayer &player, const Replay &replay) {
+    player.replay = &replay;
+    player.offset = 0;
+    player.input.up = player.input.down = false;
+    player.input.axis = 0;
+    player.runLeft = 0;
+    player.tick = 0;
+}
+
+bool ReplayPlayerNext(ReplayPlayer &player, SimInput &input) {
+    const vector<unsigned char> &inputs = player.replay->inputs;
+    if (player.tick >= player.replay->header.ticks) return false;
+    if (player.runLeft == 0) {
+        uint64_t value = 0;
+        int shift = 0;
+        while (player.offset < inputs.size() && shift < 64) {
+            unsigned char byte = inputs[player.offset++];
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) break;
+        }
+        player.input.up = (value & 1) != 0;
+        player.input.down = (value & 2) != 0;
+        player.input.axis = 0;
+        if ((value & 4) && player.offset < inputs.size()) {
+            player.input.axis = (signed char)inputs[player.offset++];
+        }
+        player.runLeft = (uint32_t)(value >> 3) + 1;
+    }
+    input = player.input;
+    player.runLeft--;
+    player.tick++;
+    return true;
+}
+
+bool ReplayVerify(const Replay &replay, GameSimState &finalState) {
+    const float tickTime = ReplayTickTime(replay.header);
+    ReplayPlayer player;
+    ReplayPlayerStart(player, replay);
+    OpponentLevel opponent = ReplayOpponent(replay.header);
+    SimReset(finalState, replay.header.ballSpeed, opponent != OPPONENT_NONE);
+    PredictorAI ai;
+    PredictorAIReset(ai, opponent, replay.header.tickRate, replay.header.seed);
+
+    SimInput input;
+    while (!finalState.gameOver && ReplayPlayerNext(player, input)) {
+        if (opponent == OPPONENT_NONE) SimStep(finalState, input, tickTime);
+        else SimStepVersus(finalState, input, PredictorAIInput(ai, finalState), tickTime);
+    }
+    return finalState.tick == (long long)replay.header.ticks
+        && finalState.score == replay.header.finalScore
+        && SimStateChecksum(finalState) == replay.header.finalChecksum;
+}
@@ -0,0 +1,86 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "game_sim.h"
+
+// Game replays: the settings a game started with and the paddle input of
+// every tick. The rules are deterministic, so stepping the same inputs
+// through SimStep reproduces the game exactly; the final state's checksum
+// is stored to prove it.
+//
+// Inputs are stored as runs of identical ticks, each run one varint of
+// (length - 1) << 3 | up | down << 1 | analog << 2, followed by the axis
+// byte when analog is set. Holding a key for a second at 240 Hz costs two
+// bytes, so a keyboard game takes a few bytes per second of play; a moving
+// stick or mouse costs up to three bytes per tick.
+//
+// The flags hold the theme and the opponent level. The opponent's moves
+// are not stored: its AI is deterministic given the header's seed, so
+// playback runs it again.
+//
+// File layout: ReplayHeader, then header.inputBytes of runs. The header
+// checksum covers both.
+
+#define REPLAY_MAGIC "PPRP"
+const uint16_t REPLAY_VERSION = 1;
+const uint16_t REPLAY_DARK_THEME = 1;   // header.flags
+const int REPLAY_OPPONENT_SHIFT = 1;    // header.flags bits 1-2: OpponentLevel
+const uint16_t REPLAY_OPPONENT_MASK = 3 << REPLAY_OPPONENT_SHIFT;
+
+struct ReplayHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t seed;              // Seeds the opponent's aim error
+    uint32_t tickRate;
+    float ballSpeed;
+    uint32_t ticks;
+    int32_t finalScore;
+    uint32_t finalChecksum;     // SimStateChecksum of the last state
+    uint32_t inputBytes;
+    uint32_t checksum;          // Crc32 of the fields above and the inputs
+};
+
+struct Replay {
+    ReplayHeader header;
+    std::vector<unsigned char> inputs;
+    int runInput;               // ReplayInputCode of the run being recorded, -1 before the first tick
+    uint32_t runLength;
+};
+
+// Reads a replay back one tick at a time
+struct ReplayPlayer {
+    const Replay* replay;
+    size_t offset;              // Next run in replay->inputs
+    SimInput input;
+    uint32_t runLeft;           // Ticks left in the current run
+    uint32_t tick;
+};
+
+// Final state fingerprint; covers every field bit for bit
+uint32_t SimStateChecksum(const GameSimState &state);
+
+// Same tick length the game steps with
+float ReplayTickTime(const ReplayHeader &header);
+OpponentLevel ReplayOpponent(const ReplayHeader &header);
+
+void ReplayBegin(Replay &replay, float ballSpeed, int tickRate, bool darkTheme, OpponentLevel opponent, uint32_t seed);
+void ReplayRecord(Replay &replay, const SimInput &input);
+void ReplayFinish(Replay &replay, const GameSimState &finalState);
+
+void EncodeReplay(const Replay &replay, std::vector<unsigned char> &bytes);
+bool DecodeReplay(const unsigned char* data, size_t size, Replay &replay);
+bool ReadReplay(const char* path, Replay &replay);
+
+void ReplayPlayerStart(ReplayPlayer &player, const Replay &replay);
+// False once every recorded tick has been played
+bool ReplayPlayerNext(ReplayPlayer &player, SimInput &input);
+
+// Plays the whole replay through SimStep. True if it ends where the
+// recording did, with the same checksum.
+bool ReplayVerify(const Replay &replay, GameSimState &finalState);
+
+#endif
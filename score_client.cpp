@@ -0,0 +1,256 @@
+#include "score_client.h"
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+// Pages beyond this many are dropped all at once
+const size_t MAX_CACHED_PAGES = 256;
+
+struct PendingRequest {
+    uint32_t id;
+    ScoreOp op;
+    int page;               // SCORE_OP_RANGE
+    int generation;         // Cache generation the page was asked for in
+    SubmittedGame game;     // SCORE_OP_SUBMIT
+};
+
+static int serviceFd = -1;
+static bool connected = false;
+static vector<unsigned char> output;
+static size_t outputSent = 0;
+static vector<unsigned char> input;
+
+// The daemon answers in request order, so the oldest pending request is the next answer
+static deque<PendingRequest> pending;
+static uint32_t nextId = 1;
+
+static int total = 0;
+static int topScore = 0;
+static unordered_map<int, vector<ScoreRow> > pages;
+static unordered_set<int> requestedPages;
+static int generation = 0;
+static double nextRefresh = 0.0;
+
+static uint32_t playerRequest = 0;
+static bool playerAnswered = false;
+static int playerRank = 0;
+
+static uint32_t statsRequest = 0;
+static bool statsAnswered = false;
+static PlayerSummary playerStats;
+
+static void Disconnect() {
+    if (serviceFd >= 0) close(serviceFd);
+    serviceFd = -1;
+    connected = false;
+}
+
+static void Send(ScoreOp op, const char* name, int value, int count, int page, const GameSummary* game = NULL) {
+    PendingRequest request;
+    memset(&request, 0, sizeof(request));
+    request.id = nextId++;
+    request.op = op;
+    request.page = page;
+    request.generation = generation;
+    if (game) {
+        strncpy(request.game.name, name, MAX_NAME_LENGTH - 1);
+        request.game.game = *game;
+        EncodeScoreRequest(output, request.id, op, name, value, count, game->longestRally, game->maxBallSpeed);
+    } else {
+        EncodeScoreRequest(output, request.id, op, name, value, count);
+    }
+    pending.push_back(request);
+}
+
+static void Flush() {
+    while (connected && outputSent < output.size()) {
+        ssize_t wrote = send(serviceFd, &output[outputSent], output.size() - outputSent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (wrote > 0) {
+            outputSent += wrote;
+        } else if (wrote < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (wrote == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) Disconnect();
+            return;
+        }
+    }
+    output.clear();
+    outputSent = 0;
+}
+
+// Returns true if the board changed
+static bool Apply(const ScoreAnswer &answer, const PendingRequest &request) {
+    bool changed = answer.header.total != total || answer.header.topScore != topScore;
+    if (changed) {
+        total = answer.header.total;
+        topScore = answer.header.topScore;
+        pages.clear();
+        requestedPages.clear();
+        generation++;
+    }
+
+    if (request.op == SCORE_OP_RANGE && request.page >= 0 && request.generation == generation) {
+        if (pages.size() >= MAX_CACHED_PAGES) pages.clear();
+        vector<ScoreRow> &rows = pages[request.page];
+        rows = answer.rows;
+        requestedPages.erase(request.page);
+    } else if (request.op == SCORE_OP_PLAYER_RANK && request.id == playerRequest) {
+        playerRank = answer.header.status == SCORE_STATUS_OK ? answer.header.rank : 0;
+        playerAnswered = true;
+    } else if (request.op == SCORE_OP_PLAYER_STATS && request.id == statsRequest) {
+        playerStats = answer.stats;
+        statsAnswered = true;
+    }
+    return changed;
+}
+
+bool ScoreClientStart(const char* socketPath) {
+    serviceFd = ScoreConnect(socketPath);
+    if (serviceFd < 0 || !SetNonBlocking(serviceFd)) {
+        Disconnect();
+        return false;
+    }
+    connected = true;
+    total = topScore = 0;
+    pages.clear();
+    requestedPages.clear();
+    pending.clear();
+    output.clear();
+    input.clear();
+    outputSent = 0;
+
+    // Totals, so the game knows the board before anyone opens it
+    Send(SCORE_OP_RANGE, "", 1, 0, -1);
+    Flush();
+    return connected;
+}
+
+void ScoreClientStop() {
+    Disconnect();
+    pending.clear();
+}
+
+bool ScoreClientConnected() {
+    return connected;
+}
+
+bool ScoreClientPoll(double now) {
+    if (!connected) return false;
+    if (now >= nextRefresh && pending.empty()) {
+        Send(SCORE_OP_RANGE, "", 1, 0, -1);
+        nextRefresh = now + SCORE_REFRESH_SECONDS;
+    }
+    Flush();
+
+    unsigned char chunk[16 * 1024];
+    while (connected) {
+        ssize_t got = recv(serviceFd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (got > 0) {
+            input.insert(input.end(), chunk, chunk + got);
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) Disconnect();
+            break;
+        }
+    }
+
+    bool changed = false;
+    size_t offset = 0;
+    ScoreAnswer answer;
+    while (true) {
+        int used = DecodeScoreAnswer(input.data() + offset, input.size() - offset, answer);
+        if (used == 0) break;
+        if (used < 0 || pending.empty() || answer.header.id != pending.front().id) {
+            Disconnect();
+            break;
+        }
+        changed = Apply(answer, pending.front()) || changed;
+        pending.pop_front();
+        offset += used;
+    }
+    input.erase(input.begin(), input.begin() + offset);
+    return changed;
+}
+
+bool ScoreClientBusy() {
+    return connected && !pending.empty();
+}
+
+int ScoreClientTotal() {
+    return total;
+}
+
+int ScoreClientTopScore() {
+    return topScore;
+}
+
+void ScoreClientSubmit(const char* name, const GameSummary &game) {
+    Send(SCORE_OP_SUBMIT, name, game.score, 0, -1, &game);
+    Flush();
+}
+
+bool ScoreClientRowsReady(int first, int last) {
+    if (last > total) last = total;
+    bool ready = true;
+    for (int page = (first - 1) / SCORE_PAGE_ROWS; first <= last && page <= (last - 1) / SCORE_PAGE_ROWS; page++) {
+        if (pages.count(page)) continue;
+        ready = false;
+        if (connected && !requestedPages.count(page)) {
+            Send(SCORE_OP_RANGE, "", page * SCORE_PAGE_ROWS + 1, SCORE_PAGE_ROWS, page);
+            requestedPages.insert(page);
+        }
+    }
+    Flush();
+    return ready;
+}
+
+bool ScoreClientRowAt(int rank, const char* &name, int &score) {
+    if (rank < 1) return false;
+    unordered_map<int, vector<ScoreRow> >::const_iterator page = pages.find((rank - 1) / SCORE_PAGE_ROWS);
+    if (page == pages.end()) return false;
+    size_t row = (rank - 1) % SCORE_PAGE_ROWS;
+    if (row >= page->second.size()) return false;
+    name = page->second[row].name;
+    score = page->second[row].score;
+    return true;
+}
+
+void ScoreClientFindPlayer(const char* name) {
+    playerAnswered = false;
+    playerRank = 0;
+    playerRequest = nextId;
+    Send(SCORE_OP_PLAYER_RANK, name, 0, 0, -1);
+    Flush();
+}
+
+bool ScoreClientPlayerRank(int &rank) {
+    rank = playerRank;
+    return playerAnswered || !connected;
+}
+
+void ScoreClientFindStats(const char* name) {
+    statsAnswered = false;
+    memset(&playerStats, 0, sizeof(playerStats));
+    statsRequest = nextId;
+    Send(SCORE_OP_PLAYER_STATS, name, 0, 0, -1);
+    Flush();
+}
+
+bool ScoreClientPlayerStats(PlayerSummary &stats) {
+    stats = playerStats;
+    return statsAnswered || !connected;
+}
+
+void ScoreClientUnconfirmed(vector<SubmittedGame> &games) {
+    games.clear();
+    for (size_t i = 0; i < pending.size(); i++) {
+        if (pending[i].op == SCORE_OP_SUBMIT) games.push_back(pending[i].game);
+    }
+}
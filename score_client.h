@@ -0,0 +1,60 @@
+#ifndef SCORE_CLIENT_H
+#define SCORE_CLIENT_H
+
+#include <vector>
+#include "score_protocol.h"
+
+// The game's side of the leaderboard service (score_protocol.h). Requests
+// are written without waiting and answers are read by ScoreClientPoll once
+// a frame, so the game never blocks on the daemon. Ranked rows are cached
+// a page at a time and dropped whenever the board changes size, which the
+// client checks every SCORE_REFRESH_SECONDS to notice other games' scores.
+
+const int SCORE_PAGE_ROWS = 32;
+const double SCORE_REFRESH_SECONDS = 1.0;
+
+struct SubmittedGame {
+    char name[MAX_NAME_LENGTH];
+    GameSummary game;
+};
+
+// Connects to a running daemon; false if none answers on socketPath
+bool ScoreClientStart(const char* socketPath);
+void ScoreClientStop();
+
+// False once the daemon has gone away
+bool ScoreClientConnected();
+
+// Sends what is queued and takes in the answers that arrived. now is in
+// seconds. Returns true when the board changed.
+bool ScoreClientPoll(double now);
+
+// Requests still unanswered
+bool ScoreClientBusy();
+
+// Games on the board and the best score, as of the last answer
+int ScoreClientTotal();
+int ScoreClientTopScore();
+
+void ScoreClientSubmit(const char* name, const GameSummary &game);
+
+// True if ranks first to last are cached; otherwise asks for the missing pages
+bool ScoreClientRowsReady(int first, int last);
+
+// Name and score at a 1-based rank. False if it is not cached or past the end.
+bool ScoreClientRowAt(int rank, const char* &name, int &score);
+
+// Asks for the rank of a player's best game. ScoreClientPlayerRank is
+// true once the answer is in, with rank 0 if the player has no games.
+void ScoreClientFindPlayer(const char* name);
+bool ScoreClientPlayerRank(int &rank);
+
+// Asks for a player's stats. ScoreClientPlayerStats is true once the
+// answer is in, with games 0 if the player has none.
+void ScoreClientFindStats(const char* name);
+bool ScoreClientPlayerStats(PlayerSummary &stats);
+
+// Games sent but not confirmed by the daemon, to save locally once it is gone
+void ScoreClientUnconfirmed(std::vector<SubmittedGame> &games);
+
+#endif
@@ -0,0 +1,246 @@
+#include "score_log.h"
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+struct Crc32Table {
+    uint32_t entries[256];
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+uint32_t Crc32(const void* data, size_t size) {
+    // Built on first use; the score store, asset loaders and daemon may all
+    // get here at once, and a local static is initialized exactly once
+    static const Crc32Table table;
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void MakeScoreRecord(ScoreRecord &record, const char* name, int score, uint32_t time) {
+    memset(&record, 0, sizeof(record));
+    strncpy(record.name, name, MAX_NAME_LENGTH - 1);
+    record.score = score;
+    record.time = time;
+    record.checksum = Crc32(&record, offsetof(ScoreRecord, checksum));
+}
+
+bool ScoreRecordValid(const ScoreRecord &record) {
+    return record.checksum == Crc32(&record, offsetof(ScoreRecord, checksum))
+        && memchr(record.name, '\0', MAX_NAME_LENGTH) != NULL;
+}
+
+static void MakeHeader(ScoreLogHeader &header) {
+    memcpy(header.magic, SCORE_LOG_MAGIC, sizeof(header.magic));
+    header.version = SCORE_LOG_VERSION;
+    header.recordSize = sizeof(ScoreRecord);
+    header.reserved = 0;
+}
+
+bool ScoreLogHeaderValid(const ScoreLogHeader &header) {
+    return memcmp(header.magic, SCORE_LOG_MAGIC, sizeof(header.magic)) == 0
+        && header.version == SCORE_LOG_VERSION
+        && header.recordSize == sizeof(ScoreRecord);
+}
+
+static bool WriteAll(int fd, const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool ReadScoreLog(const char* path, vector<ScoreRecord> &records, ScoreLogStats* stats) {
+    records.clear();
+    if (stats) stats->badRecords = stats->trailingBytes = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(ScoreLogHeader)) {
+        close(fd);
+        return false;
+    }
+
+    // The whole file in one read
+    vector<char> data(info.st_size);
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = read(fd, &data[got], data.size() - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fd);
+
+    ScoreLogHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    if (got < sizeof(header) || !ScoreLogHeaderValid(header)) return false;
+
+    size_t body = got - sizeof(header);
+    size_t count = body / sizeof(ScoreRecord);
+    records.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        ScoreRecord record;
+        memcpy(&record, &data[sizeof(header) + i * sizeof(ScoreRecord)], sizeof(record));
+        if (ScoreRecordValid(record)) {
+            records.push_back(record);
+        } else if (stats) {
+            stats->badRecords++;
+        }
+    }
+    if (stats) stats->trailingBytes = (int)(body % sizeof(ScoreRecord));
+    return true;
+}
+
+int LoadScoreLog(const char* path, Leaderboard &board) {
+    vector<ScoreRecord> records;
+    LeaderboardClear(board);
+    if (ReadScoreLog(path, records, NULL)) {
+        for (size_t i = 0; i < records.size(); i++) {
+            LeaderboardAppend(board, records[i].name, records[i].score);
+        }
+    }
+    LeaderboardRebuild(board);
+    return LeaderboardSize(board);
+}
+
+// The rename only survives a power loss once the directory entry is on disk
+static bool SyncParentDirectory(const char* path) {
+    string directory(path);
+    size_t slash = directory.rfind('/');
+    directory = slash == string::npos ? "." : (slash == 0 ? "/" : directory.substr(0, slash));
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+bool WriteFileAtomic(const char* path, const FileChunk* chunks, int count) {
+    string tempPath = string(path) + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) ok = WriteAll(fd, chunks[i].data, chunks[i].size);
+    ok = ok && fsync(fd) == 0;
+    int error = errno;
+    close(fd);
+
+    // The rename is atomic: readers see the old file or the complete new one
+    if (!ok || rename(tempPath.c_str(), path) != 0) {
+        if (ok) error = errno;
+        unlink(tempPath.c_str());
+        errno = error;
+        return false;
+    }
+    return SyncParentDirectory(path);
+}
+
+bool WriteScoreLog(const char* path, const ScoreRecord* records, int count) {
+    ScoreLogHeader header;
+    MakeHeader(header);
+    FileChunk chunks[] = {{&header, sizeof(header)}, {records, (size_t)count * sizeof(ScoreRecord)}};
+    return WriteFileAtomic(path, chunks, 2);
+}
+
+int OpenScoreLogForAppend(const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        if (!WriteScoreLog(path, NULL, 0)) return -1;
+    }
+
+    int fd = open(path, O_RDWR | O_APPEND);
+    if (fd < 0) return -1;
+
+    ScoreLogHeader header;
+    if (fstat(fd, &info) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || !ScoreLogHeaderValid(header)) {
+        close(fd);
+        return -1;
+    }
+
+    // Cut off a record torn by a crash so new records stay aligned
+    off_t body = info.st_size - (off_t)sizeof(header);
+    off_t aligned = (off_t)sizeof(header) + body / (off_t)sizeof(ScoreRecord) * (off_t)sizeof(ScoreRecord);
+    if (aligned != info.st_size && ftruncate(fd, aligned) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool AppendScoreRecords(int fd, const ScoreRecord* records, int count) {
+    return WriteAll(fd, records, (size_t)count * sizeof(ScoreRecord)) && fsync(fd) == 0;
+}
+
+void BestRecordPerPlayer(const ScoreRecord* records, int count, vector<ScoreRecord> &best) {
+    unordered_map<string, int> bestIndex;
+    for (int i = 0; i < count; i++) {
+        if (!ScoreRecordValid(records[i])) continue;
+        unordered_map<string, int>::iterator found = bestIndex.find(records[i].name);
+        if (found == bestIndex.end()) {
+            bestIndex[records[i].name] = i;
+        } else if (records[i].score > records[found->second].score) {
+            found->second = i;
+        }
+    }
+
+    vector<bool> keep(count, false);
+    for (unordered_map<string, int>::iterator it = bestIndex.begin(); it != bestIndex.end(); ++it) {
+        keep[it->second] = true;
+    }
+    best.clear();
+    for (int i = 0; i < count; i++) {
+        if (keep[i]) best.push_back(records[i]);
+    }
+}
+
+bool ImportTextScores(const char* textPath, const char* logPath) {
+    ifstream file(textPath);
+    if (!file.is_open()) return false;
+
+    // Each line is the name, which may contain spaces, then the score
+    vector<ScoreRecord> records;
+    uint32_t now = (uint32_t)time(NULL);
+    string line;
+    while (getline(file, line)) {
+        size_t end = line.find_last_not_of(" \t\r");
+        if (end == string::npos) continue;
+        size_t scoreStart = line.find_last_of(" \t", end);
+        if (scoreStart == string::npos) continue;
+        string scoreText = line.substr(scoreStart + 1, end - scoreStart);
+        char* parsedEnd;
+        long score = strtol(scoreText.c_str(), &parsedEnd, 10);
+        size_t nameEnd = line.find_last_not_of(" \t", scoreStart);
+        if (*parsedEnd != '\0' || nameEnd == string::npos) continue;
+
+        ScoreRecord record;
+        MakeScoreRecord(record, line.substr(0, nameEnd + 1).c_str(), (int)score, now);
+        records.push_back(record);
+    }
+    return WriteScoreLog(logPath, records.empty() ? NULL : &records[0], (int)records.size());
+}
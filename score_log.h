@@ -0,0 +1,95 @@
+#ifndef SCORE_LOG_H
+#define SCORE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "leaderboard.h"
+
+// Binary, append-only score log (scores.bin).
+//
+//   header   16 bytes: "PPSL", version, record size, reserved
+//   records  64 bytes each, appended one game at a time
+//
+// Every record carries a CRC-32, so a record torn by a crash is detected
+// and skipped; a partial record at the end is cut off before the next
+// append. Rewrites (compaction, clearing, importing) go to a temporary
+// file that is renamed over the log, so the log is always either the old
+// or the new version.
+//
+// Headers and records are written as the structs below, in the host's
+// byte order, and read back with memcpy. Only little-endian hosts are
+// supported, so every file this game writes is little-endian; the check
+// below stops a build for any other host. The other binary formats
+// (asset bundle, player stats, replays, the leaderboard protocol) are
+// stored the same way and rely on the same check.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary score, asset and replay files are stored in native byte order; only little-endian hosts are supported"
+#endif
+
+const char SCORE_LOG_MAGIC[4] = {'P', 'P', 'S', 'L'};
+const uint32_t SCORE_LOG_VERSION = 1;
+
+struct ScoreLogHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct ScoreRecord {
+    char name[MAX_NAME_LENGTH];     // NUL padded, may contain spaces
+    char reserved[2];
+    int32_t score;
+    uint32_t time;                  // Unix time the game was saved
+    uint32_t checksum;              // CRC-32 of the bytes above
+};
+static_assert(sizeof(ScoreRecord) == 64, "score log records are 64 bytes on disk");
+
+// What a read found besides the valid records
+struct ScoreLogStats {
+    int badRecords;         // Failed their checksum
+    int trailingBytes;      // Partial record at the end
+};
+
+uint32_t Crc32(const void* data, size_t size);
+void MakeScoreRecord(ScoreRecord &record, const char* name, int score, uint32_t time);
+bool ScoreRecordValid(const ScoreRecord &record);
+bool ScoreLogHeaderValid(const ScoreLogHeader &header);
+
+// Reads the whole log with one read call. False if it is missing or not a score log.
+bool ReadScoreLog(const char* path, std::vector<ScoreRecord> &records, ScoreLogStats* stats);
+
+// Loads every valid record into board, in file order
+int LoadScoreLog(const char* path, Leaderboard &board);
+
+// One piece of a file written by WriteFileAtomic
+struct FileChunk {
+    const void* data;
+    size_t size;
+};
+
+// Writes the chunks to path.tmp, syncs it and renames it over path, so
+// readers see the old file or the complete new one, then syncs the
+// directory so the rename itself survives a power loss. On failure errno
+// is what the failing call set.
+bool WriteFileAtomic(const char* path, const FileChunk* chunks, int count);
+
+// Atomically replaces the log with exactly these records
+bool WriteScoreLog(const char* path, const ScoreRecord* records, int count);
+
+// Opens the log for appending, creating it or cutting off a torn tail first.
+// Returns a file descriptor, or -1.
+int OpenScoreLogForAppend(const char* path);
+
+// Appends records with a single write and waits for them to reach the disk
+bool AppendScoreRecords(int fd, const ScoreRecord* records, int count);
+
+// Keeps only each player's best valid record (first one on ties), in file order
+void BestRecordPerPlayer(const ScoreRecord* records, int count, std::vector<ScoreRecord> &best);
+
+// Converts an old scores.txt, one "name score" per line, into a log. The
+// score is the last word on the line, so names may contain spaces.
+bool ImportTextScores(const char* textPath, const char* logPath);
+
+#endif
@@ -0,0 +1,135 @@
+#include "score_protocol.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+static void Append(vector<unsigned char> &out, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+void EncodeScoreRequest(vector<unsigned char> &out, uint32_t id, ScoreOp op, const char* name, int value, int count,
+                        int rally, float ballSpeed) {
+    size_t nameLength = name ? strlen(name) : 0;
+    if (nameLength > MAX_NAME_LENGTH - 1) nameLength = MAX_NAME_LENGTH - 1;
+    ScoreRequest request;
+    request.id = id;
+    request.op = (uint8_t)op;
+    request.nameLength = (uint8_t)nameLength;
+    request.count = (uint16_t)(count < 0 ? 0 : (count > MAX_SCORE_ROWS ? MAX_SCORE_ROWS : count));
+    request.value = value;
+    request.rally = rally;
+    request.ballSpeed = ballSpeed;
+    Append(out, &request, sizeof(request));
+    Append(out, name, nameLength);
+}
+
+int DecodeScoreRequest(const unsigned char* data, size_t size, ScoreRequest &request, char* name) {
+    if (size < sizeof(ScoreRequest)) return 0;
+    memcpy(&request, data, sizeof(request));
+    if (request.nameLength >= MAX_NAME_LENGTH) return -1;
+    if (size < sizeof(ScoreRequest) + request.nameLength) return 0;
+    memcpy(name, data + sizeof(ScoreRequest), request.nameLength);
+    name[request.nameLength] = '\0';
+    return (int)(sizeof(ScoreRequest) + request.nameLength);
+}
+
+void EncodeScoreAnswer(vector<unsigned char> &out, const ScoreAnswerHeader &header) {
+    Append(out, &header, sizeof(header));
+}
+
+void EncodeScoreRow(vector<unsigned char> &out, const char* name, int score) {
+    size_t nameLength = strlen(name);
+    if (nameLength > MAX_NAME_LENGTH - 1) nameLength = MAX_NAME_LENGTH - 1;
+    ScoreRowHeader row;
+    row.score = score;
+    row.nameLength = (uint8_t)nameLength;
+    memset(row.reserved, 0, sizeof(row.reserved));
+    Append(out, &row, sizeof(row));
+    Append(out, name, nameLength);
+}
+
+void EncodePlayerSummary(vector<unsigned char> &out, const PlayerSummary &stats) {
+    Append(out, &stats, sizeof(stats));
+}
+
+int DecodeScoreAnswer(const unsigned char* data, size_t size, ScoreAnswer &answer) {
+    if (size < sizeof(ScoreAnswerHeader)) return 0;
+    memcpy(&answer.header, data, sizeof(answer.header));
+    if (answer.header.rowCount > MAX_SCORE_ROWS) return -1;
+
+    size_t offset = sizeof(ScoreAnswerHeader);
+    answer.rows.resize(answer.header.rowCount);
+    for (int i = 0; i < answer.header.rowCount; i++) {
+        ScoreRowHeader row;
+        if (size < offset + sizeof(row)) return 0;
+        memcpy(&row, data + offset, sizeof(row));
+        offset += sizeof(row);
+        if (row.nameLength >= MAX_NAME_LENGTH) return -1;
+        if (size < offset + row.nameLength) return 0;
+        answer.rows[i].score = row.score;
+        memcpy(answer.rows[i].name, data + offset, row.nameLength);
+        answer.rows[i].name[row.nameLength] = '\0';
+        offset += row.nameLength;
+    }
+
+    memset(&answer.stats, 0, sizeof(answer.stats));
+    if (answer.header.op == SCORE_OP_PLAYER_STATS && answer.header.status == SCORE_STATUS_OK) {
+        if (size < offset + sizeof(answer.stats)) return 0;
+        memcpy(&answer.stats, data + offset, sizeof(answer.stats));
+        offset += sizeof(answer.stats);
+    }
+    return (int)offset;
+}
+
+static bool SocketAddress(const char* path, sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) return false;
+    strcpy(address.sun_path, path);
+    return true;
+}
+
+int ScoreConnect(const char* path) {
+    sockaddr_un address;
+    if (!SocketAddress(path, address)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int ScoreListen(const char* path) {
+    sockaddr_un address;
+    if (!SocketAddress(path, address)) return -1;
+
+    // A socket file nobody answers on is left over from a daemon that died
+    int running = ScoreConnect(path);
+    if (running >= 0) {
+        close(running);
+        errno = EADDRINUSE;
+        return -1;
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0 || !SetNonBlocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool SetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
@@ -0,0 +1,104 @@
+#ifndef SCORE_PROTOCOL_H
+#define SCORE_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "leaderboard.h"
+#include "player_stats.h"
+
+// Leaderboard service protocol. leaderboard_daemon owns the score log and
+// answers every game on the machine over a Unix domain socket, so
+// cabinets sharing a machine share one ranking.
+//
+// A connection carries a stream of requests, each a ScoreRequest followed
+// by nameLength name bytes (no NUL). Clients may send any number before
+// reading the answers (pipelining); the daemon answers each connection's
+// requests in order, each with a ScoreAnswerHeader followed by rowCount
+// rows, a ScoreRowHeader and nameLength name bytes per row, or for a
+// successful PLAYER_STATS a PlayerSummary instead of rows. The request id
+// is echoed back. Messages are the structs below copied as they are, so
+// both ends must share a byte order; they always run on the same machine.
+
+const char* const SCORE_SOCKET_DEFAULT = "/tmp/ping_pong_scores.sock";
+const int MAX_SCORE_ROWS = 100;     // Rows in one answer
+
+enum ScoreOp {
+    SCORE_OP_SUBMIT = 1,    // name, value: score, rally, ballSpeed. Answer: rank of the new game
+    SCORE_OP_TOP,           // count: rows from rank 1
+    SCORE_OP_RANGE,         // value: first rank, count: rows (0 just asks for the totals)
+    SCORE_OP_PLAYER_RANK,   // name. Answer: rank and score of the player's best game, rank 0 if none
+    SCORE_OP_PLAYER_STATS   // name. Answer: as PLAYER_RANK, then the player's PlayerSummary
+};
+
+enum ScoreStatus {
+    SCORE_STATUS_OK,
+    SCORE_STATUS_BAD_REQUEST
+};
+
+struct ScoreRequest {
+    uint32_t id;
+    uint8_t op;
+    uint8_t nameLength;     // Below MAX_NAME_LENGTH
+    uint16_t count;         // TOP and RANGE: rows wanted; the daemon sends at most MAX_SCORE_ROWS
+    int32_t value;
+    int32_t rally;          // SUBMIT: the game's longest rally
+    float ballSpeed;        // SUBMIT: the fastest the ball went, pixels/s
+};
+static_assert(sizeof(ScoreRequest) == 20, "score requests are 20 bytes on the wire");
+
+// Every answer carries the board's size and top score, so a client keeps
+// both current without asking
+struct ScoreAnswerHeader {
+    uint32_t id;
+    uint8_t op;
+    uint8_t status;
+    uint16_t rowCount;
+    int32_t rank;           // SUBMIT and PLAYER_RANK: the game's rank; TOP and RANGE: the first row's
+    int32_t score;          // PLAYER_RANK: the player's best score
+    int32_t total;          // Games on the board
+    int32_t topScore;
+};
+static_assert(sizeof(ScoreAnswerHeader) == 24, "score answers are 24 bytes on the wire");
+
+struct ScoreRowHeader {
+    int32_t score;
+    uint8_t nameLength;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(ScoreRowHeader) == 8, "score rows are 8 bytes on the wire");
+
+struct ScoreRow {
+    int score;
+    char name[MAX_NAME_LENGTH];
+};
+
+struct ScoreAnswer {
+    ScoreAnswerHeader header;
+    std::vector<ScoreRow> rows;
+    PlayerSummary stats;    // PLAYER_STATS
+};
+
+// Appends one request to out. Names are cut to MAX_NAME_LENGTH - 1 bytes.
+void EncodeScoreRequest(std::vector<unsigned char> &out, uint32_t id, ScoreOp op, const char* name, int value, int count,
+                        int rally = 0, float ballSpeed = 0.0f);
+
+// Decodes the request at the front of data, copying its name. Returns the
+// bytes it took, 0 if it is not all there yet, or -1 if it is malformed.
+int DecodeScoreRequest(const unsigned char* data, size_t size, ScoreRequest &request, char* name);
+
+// Answers are built as a header, then the rows one at a time
+void EncodeScoreAnswer(std::vector<unsigned char> &out, const ScoreAnswerHeader &header);
+void EncodeScoreRow(std::vector<unsigned char> &out, const char* name, int score);
+void EncodePlayerSummary(std::vector<unsigned char> &out, const PlayerSummary &stats);
+
+// Same return values as DecodeScoreRequest
+int DecodeScoreAnswer(const unsigned char* data, size_t size, ScoreAnswer &answer);
+
+// Socket setup; both return a file descriptor or -1. ScoreListen replaces
+// a stale socket file but fails if a daemon is answering on it.
+int ScoreConnect(const char* path);
+int ScoreListen(const char* path);
+bool SetNonBlocking(int fd);
+
+#endif
@@ -0,0 +1,351 @@
+#include "score_store.h"
+#include "score_log.h"
+#include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+enum ScoreJobType {
+    JOB_APPEND,
+    JOB_CLEAR,
+    JOB_FILE
+};
+
+struct ScoreJob {
+    ScoreJobType type;
+    ScoreRecord record;
+    GameSummary game;               // JOB_APPEND
+    string path;                    // JOB_FILE
+    vector<unsigned char> data;
+};
+
+// Worker state, shared with the main thread under storeMutex
+static string storePath;
+static string legacyPath;
+static string statsPath;
+static bool storeCompacts = true;
+static thread storeThread;
+static mutex storeMutex;
+static condition_variable storeCondition;
+static deque<ScoreJob> storeJobs;
+static bool storeStopping = false;
+
+// Initial load handoff
+static ScoreLogView loadedHistory;
+static PlayerStatsTable loadedStats;
+static bool loadReady = false;
+static bool loadMerged = false;
+static bool discardLoad = false;        // Cleared before the load arrived
+
+// Owned by the main thread: the caller's stats, and the games submitted
+// before the loaded stats arrived, to apply again on top of them
+static PlayerStatsTable mainStats;
+struct EarlyGame {
+    string name;
+    GameSummary game;
+};
+static vector<EarlyGame> earlyGames;
+
+// Owned by the worker thread
+static int logFile = -1;
+static int logRecords = 0;
+static int logPlayers = 0;              // Counted at startup or compaction
+static unordered_set<string> newPlayers;    // Submitted since; may repeat logged players
+static PlayerStatsTable workerStats;
+static int statsFile = -1;
+
+static uint64_t NameHash(const char* name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (; *name; name++) hash = (hash ^ (unsigned char)*name) * 1099511628211ull;
+    return hash;
+}
+
+// Distinct names in the log, by hash so ten million names stay cheap
+static int CountLogPlayers(const ScoreLogView &view) {
+    vector<uint64_t> hashes(view.count);
+    for (int i = 0; i < view.count; i++) {
+        const ScoreRecord &record = ScoreLogViewRecord(view, i);
+        hashes[i] = memchr(record.name, '\0', MAX_NAME_LENGTH) ? NameHash(record.name) : 0;
+    }
+    sort(hashes.begin(), hashes.end());
+    return (int)(unique(hashes.begin(), hashes.end()) - hashes.begin());
+}
+
+static void CompactIfWorthIt() {
+    if (!storeCompacts) return;
+    int players = logPlayers + (int)newPlayers.size();
+    if (logRecords < COMPACT_MIN_RECORDS || logRecords < 2 * players) return;
+
+    ScoreLogView view;
+    ScoreLogViewInit(view);
+    if (!ScoreLogViewOpen(view, storePath.c_str())) return;
+    vector<ScoreRecord> best;
+    BestRecordPerPlayer(view.records, view.count, best);
+    ScoreLogViewClose(view);
+
+    // A player mapping the old log keeps reading it; the rename only
+    // replaces the name
+    close(logFile);
+    if (WriteScoreLog(storePath.c_str(), best.empty() ? NULL : &best[0], (int)best.size())) {
+        logRecords = logPlayers = (int)best.size();
+        newPlayers.clear();
+    }
+    logFile = OpenScoreLogForAppend(storePath.c_str());
+}
+
+static bool WriteWholeFile(const string &path, const vector<unsigned char> &data) {
+    FileChunk chunk = {data.data(), data.size()};
+    if (WriteFileAtomic(path.c_str(), &chunk, 1)) return true;
+
+    // The first replay creates the replays directory
+    size_t slash = path.rfind('/');
+    if (errno != ENOENT || slash == string::npos) return false;
+    mkdir(path.substr(0, slash).c_str(), 0755);
+    return WriteFileAtomic(path.c_str(), &chunk, 1);
+}
+
+// Replaces the stats file with the worker's table and reopens it for updates
+static void RewriteStatsFile() {
+    if (statsFile >= 0) close(statsFile);
+    statsFile = -1;
+    if (WritePlayerStats(statsPath.c_str(), workerStats)) statsFile = open(statsPath.c_str(), O_RDWR);
+}
+
+// Stats as of the log the worker just mapped: the stats file, or the log itself the first time
+static void LoadStats(const ScoreLogView &history) {
+    int badRecords = 0;
+    if (ReadPlayerStats(statsPath.c_str(), workerStats, &badRecords) && badRecords == 0) {
+        statsFile = open(statsPath.c_str(), O_RDWR);
+    } else {
+        if (badRecords == 0) PlayerStatsFromLog(history.records, history.count, workerStats);
+        RewriteStatsFile();
+    }
+}
+
+static void WriteJobs(const deque<ScoreJob> &jobs) {
+    vector<ScoreRecord> pending;
+    bool statsChanged = false;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const ScoreJob &job = jobs[i];
+        if (job.type == JOB_CLEAR) {
+            pending.clear();
+            if (logFile >= 0) close(logFile);
+            WriteScoreLog(storePath.c_str(), NULL, 0);
+            logFile = OpenScoreLogForAppend(storePath.c_str());
+            logRecords = logPlayers = 0;
+            newPlayers.clear();
+            if (!statsPath.empty()) {
+                PlayerStatsInit(workerStats);
+                RewriteStatsFile();
+            }
+        } else if (job.type == JOB_FILE) {
+            WriteWholeFile(job.path, job.data);
+        } else {
+            pending.push_back(job.record);
+            newPlayers.insert(job.record.name);
+            if (!statsPath.empty()) {
+                int player = PlayerStatsAdd(workerStats, job.record.name, job.game);
+                if (statsFile >= 0) UpdatePlayerStatsFile(statsFile, workerStats, player, job.game.score);
+                statsChanged = true;
+            }
+        }
+    }
+
+    // One write and one sync for the whole batch, and one for its stats
+    if (!pending.empty() && logFile >= 0 && AppendScoreRecords(logFile, &pending[0], (int)pending.size())) {
+        logRecords += (int)pending.size();
+    }
+    if (statsChanged && statsFile >= 0) fsync(statsFile);
+    CompactIfWorthIt();
+}
+
+// Without a log only whole-file jobs are run
+static void FileWorker() {
+    {
+        lock_guard<mutex> lock(storeMutex);
+        loadReady = true;
+    }
+    while (true) {
+        deque<ScoreJob> jobs;
+        {
+            unique_lock<mutex> lock(storeMutex);
+            storeCondition.wait(lock, [] { return storeStopping || !storeJobs.empty(); });
+            if (storeJobs.empty() && storeStopping) break;
+            jobs.swap(storeJobs);
+        }
+        for (size_t i = 0; i < jobs.size(); i++) {
+            if (jobs[i].type == JOB_FILE) WriteWholeFile(jobs[i].path, jobs[i].data);
+        }
+    }
+}
+
+static void StoreWorker() {
+    // First run after switching formats: bring the old text scores over
+    struct stat info;
+    if (stat(storePath.c_str(), &info) != 0 && stat(legacyPath.c_str(), &info) == 0) {
+        ImportTextScores(legacyPath.c_str(), storePath.c_str());
+    }
+
+    // Cut off a torn tail before mapping, so the view ends on a record
+    logFile = OpenScoreLogForAppend(storePath.c_str());
+
+    ScoreLogView history;
+    ScoreLogViewInit(history);
+    ScoreLogViewOpen(history, storePath.c_str());
+    logRecords = ScoreLogViewCount(history);
+    // Build the first page of the ranking and count the valid records here
+    // rather than on the game-over frame
+    ScoreLogViewAtRank(history, 1);
+    ScoreLogViewValidCount(history);
+    if (!statsPath.empty()) LoadStats(history);
+    {
+        lock_guard<mutex> lock(storeMutex);
+        swap(loadedHistory, history);
+        loadedStats = workerStats;
+        loadReady = true;
+    }
+
+    if (logRecords >= COMPACT_MIN_RECORDS) {
+        ScoreLogView view;
+        ScoreLogViewInit(view);
+        if (ScoreLogViewOpen(view, storePath.c_str())) logPlayers = CountLogPlayers(view);
+        ScoreLogViewClose(view);
+    } else {
+        logPlayers = logRecords;
+    }
+    newPlayers.clear();
+    CompactIfWorthIt();
+
+    while (true) {
+        deque<ScoreJob> jobs;
+        {
+            unique_lock<mutex> lock(storeMutex);
+            storeCondition.wait(lock, [] { return storeStopping || !storeJobs.empty(); });
+            if (storeJobs.empty() && storeStopping) break;
+            jobs.swap(storeJobs);
+        }
+        WriteJobs(jobs);
+    }
+
+    if (logFile >= 0) close(logFile);
+    logFile = -1;
+    if (statsFile >= 0) close(statsFile);
+    statsFile = -1;
+}
+
+static void QueueJob(const ScoreJob &job) {
+    {
+        lock_guard<mutex> lock(storeMutex);
+        storeJobs.push_back(job);
+    }
+    storeCondition.notify_one();
+}
+
+void ScoreStoreStart(const char* logPath, const char* legacyTextPath, const char* statsFilePath, bool compact) {
+    storePath = logPath ? logPath : "";
+    storeCompacts = compact;
+    legacyPath = legacyTextPath ? legacyTextPath : "";
+    statsPath = logPath && statsFilePath ? statsFilePath : "";
+    storeStopping = false;
+    loadReady = loadMerged = discardLoad = false;
+    ScoreLogViewInit(loadedHistory);
+    PlayerStatsInit(loadedStats);
+    PlayerStatsInit(workerStats);
+    PlayerStatsInit(mainStats);
+    earlyGames.clear();
+    storeThread = thread(logPath ? StoreWorker : FileWorker);
+}
+
+void ScoreStoreStop() {
+    {
+        lock_guard<mutex> lock(storeMutex);
+        storeStopping = true;
+    }
+    storeCondition.notify_one();
+    if (storeThread.joinable()) storeThread.join();
+    ScoreLogViewClose(loadedHistory);
+}
+
+bool ScoreStorePoll(ScoreLogView &history) {
+    if (loadMerged) return false;
+
+    lock_guard<mutex> lock(storeMutex);
+    if (!loadReady) return false;
+
+    // The log was mapped before anything submitted here was written, so
+    // the two never overlap
+    ScoreLogViewClose(history);
+    if (!discardLoad) {
+        swap(history, loadedHistory);
+        swap(mainStats, loadedStats);
+        for (size_t i = 0; i < earlyGames.size(); i++) {
+            PlayerStatsAdd(mainStats, earlyGames[i].name.c_str(), earlyGames[i].game);
+        }
+    }
+    ScoreLogViewClose(loadedHistory);
+    PlayerStatsInit(loadedStats);
+    earlyGames.clear();
+    loadMerged = true;
+    return true;
+}
+
+bool ScoreStoreLoaded() {
+    return loadMerged;
+}
+
+const PlayerStatsTable &ScoreStoreStats() {
+    return mainStats;
+}
+
+void ScoreStoreSubmit(Leaderboard &recent, const char* name, int score, int longestRally, float maxBallSpeed) {
+    LeaderboardAdd(recent, name, score);
+
+    ScoreJob job;
+    job.type = JOB_APPEND;
+    MakeScoreRecord(job.record, name, score, (uint32_t)time(NULL));
+    job.game.score = score;
+    job.game.longestRally = longestRally;
+    job.game.maxBallSpeed = maxBallSpeed;
+    if (!statsPath.empty()) {
+        PlayerStatsAdd(mainStats, name, job.game);
+        if (!loadMerged && !discardLoad) {
+            EarlyGame early = {name, job.game};
+            earlyGames.push_back(early);
+        }
+    }
+    QueueJob(job);
+}
+
+void ScoreStoreClear(ScoreLogView &history, Leaderboard &recent) {
+    ScoreLogViewClose(history);
+    LeaderboardClear(recent);
+    PlayerStatsInit(mainStats);
+    earlyGames.clear();
+    if (!loadMerged) discardLoad = true;
+
+    ScoreJob job;
+    job.type = JOB_CLEAR;
+    QueueJob(job);
+}
+
+void ScoreStoreWriteFile(const char* path, const vector<unsigned char> &data) {
+    ScoreJob job;
+    job.type = JOB_FILE;
+    job.path = path;
+    job.data = data;
+    QueueJob(job);
+}
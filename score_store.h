@@ -0,0 +1,52 @@
+#ifndef SCORE_STORE_H
+#define SCORE_STORE_H
+
+#include <vector>
+#include "leaderboard.h"
+#include "score_view.h"
+#include "player_stats.h"
+
+// Score log persistence on a background I/O thread. The caller holds the
+// scores as a mapped view of the log as it was at startup plus a
+// Leaderboard of the games submitted since (see RankedScoreAt).
+// Submissions and clears update those immediately and are written to disk
+// later by the worker, so the game never waits on the file. The worker
+// also compacts the log to each player's best score once it is mostly
+// repeat entries.
+//
+// Per-player stats (player_stats.h) are kept the same way: the caller's
+// copy is updated on submit, and the worker applies each game to its own
+// copy and rewrites that player's record in the stats file.
+
+// Log size, in records, before compaction is considered
+const int COMPACT_MIN_RECORDS = 1024;
+
+// Starts the worker, which imports legacyTextPath if there is no log yet
+// and then maps the log and loads statsPath, building the stats from the
+// log if that file is missing. With a NULL logPath the worker only writes
+// files (ScoreStoreWriteFile), for a game whose scores are kept elsewhere;
+// with a NULL statsPath no stats are kept. With compact false the log keeps
+// every game, for a caller whose ranks and totals count every game and
+// must read the same after a restart (the leaderboard daemon).
+void ScoreStoreStart(const char* logPath, const char* legacyTextPath, const char* statsPath = NULL, bool compact = true);
+
+// Writes out everything still queued and stops the worker
+void ScoreStoreStop();
+
+// Hands over the mapped history once the worker has opened it. Scores
+// submitted before then are already in recent. Returns true on that call,
+// which also replaces ScoreStoreStats with the loaded stats.
+bool ScoreStorePoll(ScoreLogView &history);
+bool ScoreStoreLoaded();
+
+// Stats of every player, as of the last submit
+const PlayerStatsTable &ScoreStoreStats();
+
+void ScoreStoreSubmit(Leaderboard &recent, const char* name, int score, int longestRally = 0, float maxBallSpeed = 0.0f);
+void ScoreStoreClear(ScoreLogView &history, Leaderboard &recent);
+
+// Writes a whole file (a replay, say) on the worker, replacing it
+// atomically and creating its directory if needed
+void ScoreStoreWriteFile(const char* path, const std::vector<unsigned char> &data);
+
+#endif
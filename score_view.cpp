@@ -0,0 +1,345 @@
+#include "score_view.h"
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// First top-K size; each growth at least doubles it
+const int TOP_INDEX_START = 1024;
+
+void ScoreLogViewInit(ScoreLogView &view) {
+    view.map = NULL;
+    view.mapSize = 0;
+    view.records = NULL;
+    view.count = 0;
+    view.validCount = -1;
+    view.top.clear();
+    view.topComplete = true;
+    view.build.reset();
+}
+
+bool ScoreLogViewOpen(ScoreLogView &view, const char* path) {
+    ScoreLogViewClose(view);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(ScoreLogHeader)) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping outlives the descriptor, and a compaction renaming a new
+    // log over this one leaves the mapped file intact
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    ScoreLogHeader header;
+    memcpy(&header, map, sizeof(header));
+    if (!ScoreLogHeaderValid(header)) {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    view.map = (const char*)map;
+    view.mapSize = info.st_size;
+    view.records = (const ScoreRecord*)(view.map + sizeof(ScoreLogHeader));
+    view.count = (int)((info.st_size - sizeof(ScoreLogHeader)) / sizeof(ScoreRecord));
+    view.topComplete = view.count == 0;
+    view.validCount = view.count == 0 ? 0 : -1;
+    return true;
+}
+
+void ScoreLogViewClose(ScoreLogView &view) {
+    // Stops any background build before the mapping goes away
+    view.build.reset();
+    if (view.map) munmap((void*)view.map, view.mapSize);
+    ScoreLogViewInit(view);
+    vector<int>().swap(view.top);
+}
+
+int ScoreLogViewCount(const ScoreLogView &view) {
+    return view.count;
+}
+
+int ScoreLogViewValidCount(ScoreLogView &view) {
+    if (view.validCount >= 0) return view.validCount;
+    if (view.topComplete) {
+        view.validCount = (int)view.top.size();
+    } else {
+        view.validCount = 0;
+        for (int i = 0; i < view.count; i++) {
+            if (ScoreRecordValid(view.records[i])) view.validCount++;
+        }
+    }
+    return view.validCount;
+}
+
+const ScoreRecord &ScoreLogViewRecord(const ScoreLogView &view, int record) {
+    return view.records[record];
+}
+
+// Orders (score, record) pairs best first: higher score, then earlier in the file
+struct EntryBetter {
+    bool operator()(const pair<int, int> &a, const pair<int, int> &b) const {
+        if (a.first != b.first) return a.first > b.first;
+        return a.second < b.second;
+    }
+};
+
+struct TopIndexBuild {
+    ScoreLogView source;        // The mapping only, without an index
+    int size;                   // K
+    vector<int> top;
+    bool complete;
+    atomic<bool> cancel;
+    atomic<bool> done;
+    thread worker;
+
+    ~TopIndexBuild() {
+        cancel = true;
+        if (worker.joinable()) worker.join();
+    }
+};
+
+// Finds the best k valid records. False if cancelled part way.
+static bool BuildTopIndex(const ScoreLogView &view, int k, vector<int> &top, bool &complete, const atomic<bool>* cancel) {
+    EntryBetter better;
+
+    vector<pair<int, int> > heap;
+    if (k >= view.count / 4) {
+        // Deep ranks: most records make it in anyway, so collect them all
+        // and select rather than pay for a huge heap
+        heap.reserve(view.count);
+        for (int i = 0; i < view.count; i++) {
+            if (cancel && (i & 0xFFFF) == 0 && *cancel) return false;
+            if (ScoreRecordValid(view.records[i])) heap.push_back(make_pair((int)view.records[i].score, i));
+        }
+        if ((int)heap.size() > k) {
+            nth_element(heap.begin(), heap.begin() + k, heap.end(), better);
+            heap.resize(k);
+        }
+    } else {
+        // Heap of the best k seen so far with the worst of them on top.
+        // Only records that would get in are checksummed.
+        heap.reserve(k);
+        for (int i = 0; i < view.count; i++) {
+            if (cancel && (i & 0xFFFF) == 0 && *cancel) return false;
+            pair<int, int> entry(view.records[i].score, i);
+            if ((int)heap.size() < k) {
+                if (!ScoreRecordValid(view.records[i])) continue;
+                heap.push_back(entry);
+                push_heap(heap.begin(), heap.end(), better);
+            } else if (better(entry, heap.front())) {
+                if (!ScoreRecordValid(view.records[i])) continue;
+                pop_heap(heap.begin(), heap.end(), better);
+                heap.back() = entry;
+                push_heap(heap.begin(), heap.end(), better);
+            }
+        }
+    }
+    sort(heap.begin(), heap.end(), better);
+
+    top.resize(heap.size());
+    for (size_t i = 0; i < heap.size(); i++) top[i] = heap[i].second;
+    complete = (int)heap.size() < k;
+
+    // The scan touched every page; let them go so only the rows that are
+    // read later count against resident memory
+    madvise((void*)view.map, view.mapSize, MADV_DONTNEED);
+    return true;
+}
+
+static int NextTopSize(const ScoreLogView &view, int rank) {
+    return min(view.count, max(rank, max(TOP_INDEX_START, 2 * (int)view.top.size())));
+}
+
+static bool HasRank(const ScoreLogView &view, int rank) {
+    return rank < 1 || rank > view.count || rank <= (int)view.top.size() || view.topComplete;
+}
+
+static void AdoptBuild(ScoreLogView &view) {
+    view.build->worker.join();
+    if (view.build->top.size() > view.top.size() || view.build->complete) {
+        view.top.swap(view.build->top);
+        view.topComplete = view.build->complete;
+        if (view.topComplete) view.validCount = (int)view.top.size();
+    }
+    view.build.reset();
+}
+
+void ScoreLogViewRequestRank(ScoreLogView &view, int rank) {
+    if (ScoreLogViewReady(view, rank)) return;
+    if (view.build && view.build->size >= rank) return;
+    view.build.reset();
+
+    // The worker reads the mapping through its own copy of the fields, so
+    // the view can be moved meanwhile; closing it cancels and joins the
+    // worker before unmapping
+    shared_ptr<TopIndexBuild> build(new TopIndexBuild);
+    ScoreLogViewInit(build->source);
+    build->source.map = view.map;
+    build->source.mapSize = view.mapSize;
+    build->source.records = view.records;
+    build->source.count = view.count;
+    build->size = NextTopSize(view, rank);
+    build->complete = false;
+    build->cancel = false;
+    build->done = false;
+
+    TopIndexBuild* target = build.get();
+    target->worker = thread([target] {
+        BuildTopIndex(target->source, target->size, target->top, target->complete, &target->cancel);
+        target->done = true;
+    });
+    view.build = build;
+}
+
+bool ScoreLogViewReady(ScoreLogView &view, int rank) {
+    if (view.build && view.build->done) AdoptBuild(view);
+    return HasRank(view, rank);
+}
+
+int ScoreLogViewAtRank(ScoreLogView &view, int rank) {
+    if (rank < 1 || rank > view.count) return -1;
+    if (!ScoreLogViewReady(view, rank)) {
+        if (view.build && view.build->size >= rank) {
+            AdoptBuild(view);
+        } else {
+            view.build.reset();
+            BuildTopIndex(view, NextTopSize(view, rank), view.top, view.topComplete, NULL);
+            if (view.topComplete) view.validCount = (int)view.top.size();
+        }
+    }
+    return rank <= (int)view.top.size() ? view.top[rank - 1] : -1;
+}
+
+int ScoreLogViewTopScore(ScoreLogView &view) {
+    int record = ScoreLogViewAtRank(view, 1);
+    return record >= 0 ? view.records[record].score : 0;
+}
+
+int RankedScoreCount(ScoreLogView &history, const Leaderboard &recent) {
+    return ScoreLogViewValidCount(history) + LeaderboardSize(recent);
+}
+
+int RankedTopScore(ScoreLogView &history, const Leaderboard &recent) {
+    if (LeaderboardSize(recent) == 0) return ScoreLogViewTopScore(history);
+    if (ScoreLogViewAtRank(history, 1) < 0) return LeaderboardTopScore(recent);
+    return max(ScoreLogViewTopScore(history), LeaderboardTopScore(recent));
+}
+
+// 0-based position of the history entry at a 0-based history rank in the
+// combined order, or -1 if there is no such entry
+static long long CombinedPosition(ScoreLogView &history, const Leaderboard &recent, int historyRank) {
+    int record = ScoreLogViewAtRank(history, historyRank + 1);
+    if (record < 0) return -1;
+    // Recent entries scoring strictly higher come first
+    int ahead = LeaderboardRankForScore(recent, history.records[record].score + 1) - 1;
+    return (long long)historyRank + ahead;
+}
+
+bool RankedScoreAt(ScoreLogView &history, const Leaderboard &recent, int rank, const char* &name, int &score) {
+    if (rank < 1) return false;
+    long long position = rank - 1;
+
+    // Find the last history entry at or before this position. Positions grow
+    // with history rank, so a binary search works.
+    int low = -1;
+    int high = (int)min<long long>(position, ScoreLogViewValidCount(history) - 1);
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        long long at = CombinedPosition(history, recent, mid);
+        if (at >= 0 && at <= position) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    if (low >= 0 && CombinedPosition(history, recent, low) == position) {
+        const ScoreRecord &record = history.records[ScoreLogViewAtRank(history, low + 1)];
+        name = record.name;
+        score = record.score;
+        return true;
+    }
+
+    // Otherwise it is a recent entry, after low + 1 history entries
+    int entry = LeaderboardEntryAtRank(recent, (int)(position - low));
+    if (entry < 0) return false;
+    name = LeaderboardName(recent, entry);
+    score = LeaderboardScore(recent, entry);
+    return true;
+}
+
+void RankedPlayerSearchStart(RankedPlayerSearch &search, const Leaderboard &recent, const char* name) {
+    strncpy(search.name, name, MAX_NAME_LENGTH - 1);
+    search.name[MAX_NAME_LENGTH - 1] = '\0';
+    search.recentEntry = LeaderboardFindPlayer(recent, search.name);
+    search.historyRecord = -1;
+    search.phase = 0;
+    search.next = 0;
+    search.targetScore = 0;
+    search.targetRecord = 0;
+    search.ahead = 0;
+    search.rank = 0;
+}
+
+bool RankedPlayerSearchStep(RankedPlayerSearch &search, const ScoreLogView &history, const Leaderboard &recent, int budget) {
+    if (search.phase == 0) {
+        // The player's best record in the log, the first one on ties
+        int end = (int)min<long long>(history.count, (long long)search.next + budget);
+        for (int i = search.next; i < end; i++) {
+            const ScoreRecord &record = history.records[i];
+            if (strncmp(record.name, search.name, MAX_NAME_LENGTH) != 0) continue;
+            if (search.historyRecord >= 0 && record.score <= history.records[search.historyRecord].score) continue;
+            if (ScoreRecordValid(record)) search.historyRecord = i;
+        }
+        budget -= end - search.next;
+        search.next = end;
+        if (end < history.count) return false;
+
+        // The log wins ties with this session, so its record counts when equal
+        if (search.historyRecord >= 0 && (search.recentEntry < 0
+            || history.records[search.historyRecord].score >= LeaderboardScore(recent, search.recentEntry))) {
+            search.targetScore = history.records[search.historyRecord].score;
+            search.targetRecord = search.historyRecord;
+        } else if (search.recentEntry >= 0) {
+            search.targetScore = LeaderboardScore(recent, search.recentEntry);
+            search.targetRecord = history.count;
+        } else {
+            search.phase = 2;
+            return true;
+        }
+        search.phase = 1;
+        search.next = 0;
+    }
+
+    if (search.phase == 1) {
+        // Count valid log records ranked ahead of the target
+        int end = (int)min<long long>(history.count, (long long)search.next + max(budget, 1));
+        for (int i = search.next; i < end; i++) {
+            const ScoreRecord &record = history.records[i];
+            bool isAhead = record.score > search.targetScore || (record.score == search.targetScore && i < search.targetRecord);
+            if (isAhead && ScoreRecordValid(record)) search.ahead++;
+        }
+        search.next = end;
+        if (end < history.count) return false;
+
+        if (search.targetRecord < history.count) {
+            search.rank = search.ahead + LeaderboardRankForScore(recent, search.targetScore + 1);
+        } else {
+            search.rank = search.ahead + LeaderboardRankOf(recent, search.recentEntry);
+        }
+        search.phase = 2;
+    }
+    return true;
+}
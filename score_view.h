@@ -0,0 +1,81 @@
+#ifndef SCORE_VIEW_H
+#define SCORE_VIEW_H
+
+#include <vector>
+#include <memory>
+#include "score_log.h"
+#include "leaderboard.h"
+
+// Read-only, memory-mapped view of a score log. Opening it costs the same
+// for ten records or ten million: records are used in place, names are
+// never copied, and only the pages actually read become resident. The
+// ranking is a top-K index built on first use and grown when a rank past
+// it is asked for, so showing the first page of the leaderboard scans the
+// file once and keeps K record numbers. A screen can instead ask for a
+// deep rank to be prepared on a background thread and keep drawing.
+
+struct ScoreLogView {
+    const char* map;
+    size_t mapSize;
+    const ScoreRecord* records;
+    int count;                  // Records in the file when it was opened
+    int validCount;             // Records that pass their checksum, -1 until counted
+    std::vector<int> top;       // Best valid records, best first, ties in file order
+    bool topComplete;           // top holds every valid record
+
+    std::shared_ptr<struct TopIndexBuild> build;   // Larger index being built in the background
+};
+
+void ScoreLogViewInit(ScoreLogView &view);
+bool ScoreLogViewOpen(ScoreLogView &view, const char* path);
+void ScoreLogViewClose(ScoreLogView &view);
+
+int ScoreLogViewCount(const ScoreLogView &view);
+// Records that pass their checksum, which is what the ranking holds.
+// Checksums the whole log on the first call unless the index already
+// holds every valid record; later calls are O(1).
+int ScoreLogViewValidCount(ScoreLogView &view);
+const ScoreRecord &ScoreLogViewRecord(const ScoreLogView &view, int record);
+
+// Record at a 1-based rank, or -1 past the last valid record. Grows the
+// top-K index when rank is past it: O(n log K) for that call, O(1) after.
+int ScoreLogViewAtRank(ScoreLogView &view, int rank);
+
+// Background growth. RequestRank starts building an index that covers
+// rank on another thread; Ready takes it over once it is finished and is
+// true when AtRank(rank) will not scan.
+void ScoreLogViewRequestRank(ScoreLogView &view, int rank);
+bool ScoreLogViewReady(ScoreLogView &view, int rank);
+
+// Highest valid score, or 0 when there is none
+int ScoreLogViewTopScore(ScoreLogView &view);
+
+// The full leaderboard is the history mapped at startup followed by the
+// games submitted since, which live in a Leaderboard. History entries
+// rank ahead of recent ones with the same score, as they were saved first.
+int RankedScoreCount(ScoreLogView &history, const Leaderboard &recent);
+int RankedTopScore(ScoreLogView &history, const Leaderboard &recent);
+
+// Name and score at a 1-based rank. False if rank is past the end.
+bool RankedScoreAt(ScoreLogView &history, const Leaderboard &recent, int rank, const char* &name, int &score);
+
+// Finds the rank of a player's best game a slice of the log at a time,
+// so a screen can look up a name among millions without stalling
+struct RankedPlayerSearch {
+    char name[MAX_NAME_LENGTH];
+    int recentEntry;            // Player's best entry in recent, or -1
+    int historyRecord;          // Player's best record in the log, or -1
+    int phase;                  // 0 find the best record, 1 count ahead of it, 2 done
+    int next;                   // Next record to scan
+    int targetScore;            // The player's best game, as a position in the log:
+    int targetRecord;           // log records before it rank ahead on equal scores
+    int ahead;                  // Log records ranked ahead of the player's best game
+    int rank;                   // Result, 0 if the player has no games
+};
+
+void RankedPlayerSearchStart(RankedPlayerSearch &search, const Leaderboard &recent, const char* name);
+
+// Scans up to budget records; true once search.rank is final
+bool RankedPlayerSearchStep(RankedPlayerSearch &search, const ScoreLogView &history, const Leaderboard &recent, int budget);
+
+#endif
@@ -0,0 +1,251 @@
+#include "stress_field.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// Pool arrays are aligned to a cache line
+const int STRESS_ALIGN = 64;
+
+// Particles leave a hit at a random speed in this range, pixels/s
+const float PARTICLE_MIN_SPEED = 60.0f;
+const float PARTICLE_MAX_SPEED = 180.0f;
+
+static void* AllocPool(int count, int size) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, STRESS_ALIGN, (count > 0 ? count : 1) * size) != 0) abort();
+    memset(memory, 0, (count > 0 ? count : 1) * size);
+    return memory;
+}
+
+void StressInit(StressField &field, int capacity, int particleCapacity, unsigned int seed) {
+    field.capacity = capacity;
+    field.count = 0;
+    field.ballX = (float*)AllocPool(capacity, sizeof(float));
+    field.ballY = (float*)AllocPool(capacity, sizeof(float));
+    field.ballVelocityX = (float*)AllocPool(capacity, sizeof(float));
+    field.ballVelocityY = (float*)AllocPool(capacity, sizeof(float));
+
+    field.particleCapacity = particleCapacity;
+    field.particleCount = 0;
+    field.particleX = (float*)AllocPool(particleCapacity, sizeof(float));
+    field.particleY = (float*)AllocPool(particleCapacity, sizeof(float));
+    field.particleVelocityX = (float*)AllocPool(particleCapacity, sizeof(float));
+    field.particleVelocityY = (float*)AllocPool(particleCapacity, sizeof(float));
+    field.particleLife = (float*)AllocPool(particleCapacity, sizeof(float));
+
+    field.gridColumns = (int)ceil(screenWidth / STRESS_CELL_SIZE);
+    field.gridRows = (int)ceil(screenHeight / STRESS_CELL_SIZE);
+    field.cellStart = (int*)AllocPool(field.gridColumns * field.gridRows + 1, sizeof(int));
+    field.cellBalls = (int*)AllocPool(capacity, sizeof(int));
+    field.ballCell = (int*)AllocPool(capacity, sizeof(int));
+
+    field.paddleY = (float)screenHeight / 2 - paddleHeight / 2;
+    field.seed = seed;
+    field.ballHits = 0;
+    field.paddleHits = 0;
+}
+
+void StressFree(StressField &field) {
+    free(field.ballX);
+    free(field.ballY);
+    free(field.ballVelocityX);
+    free(field.ballVelocityY);
+    free(field.particleX);
+    free(field.particleY);
+    free(field.particleVelocityX);
+    free(field.particleVelocityY);
+    free(field.particleLife);
+    free(field.cellStart);
+    free(field.cellBalls);
+    free(field.ballCell);
+    field.capacity = 0;
+    field.count = 0;
+    field.particleCapacity = 0;
+    field.particleCount = 0;
+}
+
+void StressSetCount(StressField &field, int count, float speed) {
+    if (count > field.capacity) count = field.capacity;
+    if (count < 0) count = 0;
+    const float twoPi = 6.28318530717958647692f;
+    for (int i = field.count; i < count; i++) {
+        // Right of the paddle, so no ball starts inside it
+        field.ballX[i] = SimRandomFloat(field.seed, paddleX + paddleWidth + STRESS_BALL_RADIUS, screenWidth - STRESS_BALL_RADIUS);
+        field.ballY[i] = SimRandomFloat(field.seed, STRESS_BALL_RADIUS, screenHeight - STRESS_BALL_RADIUS);
+        float angle = SimRandomFloat(field.seed, 0.0f, twoPi);
+        field.ballVelocityX[i] = speed * cos(angle);
+        field.ballVelocityY[i] = speed * sin(angle);
+    }
+    field.count = count;
+}
+
+static void SpawnParticles(StressField &field, float x, float y) {
+    const float twoPi = 6.28318530717958647692f;
+    for (int k = 0; k < STRESS_PARTICLES_PER_HIT && field.particleCount < field.particleCapacity; k++) {
+        int p = field.particleCount++;
+        float angle = SimRandomFloat(field.seed, 0.0f, twoPi);
+        float speed = SimRandomFloat(field.seed, PARTICLE_MIN_SPEED, PARTICLE_MAX_SPEED);
+        field.particleX[p] = x;
+        field.particleY[p] = y;
+        field.particleVelocityX[p] = speed * cos(angle);
+        field.particleVelocityY[p] = speed * sin(angle);
+        field.particleLife[p] = STRESS_PARTICLE_LIFE;
+    }
+}
+
+// Counting sort of the balls by cell: count, prefix sum, scatter
+static void BuildGrid(StressField &field) {
+    int cells = field.gridColumns * field.gridRows;
+    memset(field.cellStart, 0, (cells + 1) * sizeof(int));
+    for (int i = 0; i < field.count; i++) {
+        int column = (int)(field.ballX[i] * (1.0f / STRESS_CELL_SIZE));
+        int row = (int)(field.ballY[i] * (1.0f / STRESS_CELL_SIZE));
+        column = column < 0 ? 0 : (column >= field.gridColumns ? field.gridColumns - 1 : column);
+        row = row < 0 ? 0 : (row >= field.gridRows ? field.gridRows - 1 : row);
+        int cell = row * field.gridColumns + column;
+        field.ballCell[i] = cell;
+        field.cellStart[cell + 1]++;
+    }
+    for (int c = 0; c < cells; c++) field.cellStart[c + 1] += field.cellStart[c];
+
+    // cellStart[c + 1] serves as the write cursor for cell c, ending at the start of cell c + 1
+    for (int i = 0; i < field.count; i++) {
+        field.cellBalls[field.cellStart[field.ballCell[i] + 1]++] = i;
+    }
+    for (int c = cells; c > 0; c--) field.cellStart[c] = field.cellStart[c - 1];
+    field.cellStart[0] = 0;
+}
+
+// Equal masses: swap the velocity components along the line between the
+// centers, then push the balls apart so they no longer overlap
+static void CollideBalls(StressField &field, int a, int b) {
+    const float minDistance = 2.0f * STRESS_BALL_RADIUS;
+    float dx = field.ballX[b] - field.ballX[a];
+    float dy = field.ballY[b] - field.ballY[a];
+    float distanceSquared = dx * dx + dy * dy;
+    if (distanceSquared >= minDistance * minDistance || distanceSquared == 0.0f) return;
+
+    float distance = sqrt(distanceSquared);
+    float nx = dx / distance;
+    float ny = dy / distance;
+    float approach = (field.ballVelocityX[a] - field.ballVelocityX[b]) * nx +
+                     (field.ballVelocityY[a] - field.ballVelocityY[b]) * ny;
+    if (approach > 0.0f) {
+        field.ballVelocityX[a] -= approach * nx;
+        field.ballVelocityY[a] -= approach * ny;
+        field.ballVelocityX[b] += approach * nx;
+        field.ballVelocityY[b] += approach * ny;
+        field.ballHits++;
+        SpawnParticles(field, field.ballX[a] + dx * 0.5f, field.ballY[a] + dy * 0.5f);
+    }
+
+    float push = (minDistance - distance) * 0.5f;
+    field.ballX[a] -= push * nx;
+    field.ballY[a] -= push * ny;
+    field.ballX[b] += push * nx;
+    field.ballY[b] += push * ny;
+}
+
+static void CollideCells(StressField &field, int cellA, int cellB) {
+    for (int i = field.cellStart[cellA]; i < field.cellStart[cellA + 1]; i++) {
+        // Within one cell, each pair is tested once
+        int first = cellA == cellB ? i + 1 : field.cellStart[cellB];
+        for (int j = first; j < field.cellStart[cellB + 1]; j++) {
+            CollideBalls(field, field.cellBalls[i], field.cellBalls[j]);
+        }
+    }
+}
+
+void StressStep(StressField &field, const SimInput &input, float deltaTime, const SimParams &params) {
+    const float r = STRESS_BALL_RADIUS;
+
+    // Move the paddle the same way the game does
+    if (input.axis != 0) {
+        field.paddleY += params.paddleSpeed * deltaTime * ((float)input.axis / SIM_AXIS_MAX);
+    } else {
+        if (input.up) field.paddleY -= params.paddleSpeed * deltaTime;
+        if (input.down) field.paddleY += params.paddleSpeed * deltaTime;
+    }
+    field.paddleY = fmin((float)(screenHeight - paddleHeight), fmax(0.0f, field.paddleY));
+
+    // Move the balls and reflect them off the four walls
+    float* x = field.ballX;
+    float* y = field.ballY;
+    float* vx = field.ballVelocityX;
+    float* vy = field.ballVelocityY;
+    for (int i = 0; i < field.count; i++) {
+        x[i] += vx[i] * deltaTime;
+        y[i] += vy[i] * deltaTime;
+        if (x[i] < r) { x[i] = r; vx[i] = fabs(vx[i]); }
+        if (x[i] > screenWidth - r) { x[i] = screenWidth - r; vx[i] = -fabs(vx[i]); }
+        if (y[i] < r) { y[i] = r; vy[i] = fabs(vy[i]); }
+        if (y[i] > screenHeight - r) { y[i] = screenHeight - r; vy[i] = -fabs(vy[i]); }
+    }
+
+    BuildGrid(field);
+
+    // Each cell against itself and the four neighbours ahead of it, so every
+    // neighbouring pair of cells is visited once
+    for (int row = 0; row < field.gridRows; row++) {
+        for (int column = 0; column < field.gridColumns; column++) {
+            int cell = row * field.gridColumns + column;
+            if (field.cellStart[cell] == field.cellStart[cell + 1]) continue;
+            CollideCells(field, cell, cell);
+            if (column + 1 < field.gridColumns) {
+                CollideCells(field, cell, cell + 1);
+                if (row > 0) CollideCells(field, cell, cell - field.gridColumns + 1);
+                if (row + 1 < field.gridRows) CollideCells(field, cell, cell + field.gridColumns + 1);
+            }
+            if (row + 1 < field.gridRows) CollideCells(field, cell, cell + field.gridColumns);
+        }
+    }
+
+    // Paddle: only the cells it covers, widened by a radius
+    int firstColumn = (int)((paddleX - r) / STRESS_CELL_SIZE);
+    int lastColumn = (int)((paddleX + paddleWidth + r) / STRESS_CELL_SIZE);
+    int firstRow = (int)fmax(0.0f, (field.paddleY - r) / STRESS_CELL_SIZE);
+    int lastRow = (int)fmin((float)(field.gridRows - 1), (field.paddleY + paddleHeight + r) / STRESS_CELL_SIZE);
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn < 0 ? 0 : firstColumn; column <= lastColumn; column++) {
+            int cell = row * field.gridColumns + column;
+            for (int k = field.cellStart[cell]; k < field.cellStart[cell + 1]; k++) {
+                int i = field.cellBalls[k];
+                // Closest point of the paddle to the ball's center
+                float closestX = fmin(paddleX + paddleWidth, fmax(paddleX, x[i]));
+                float closestY = fmin(field.paddleY + paddleHeight, fmax(field.paddleY, y[i]));
+                float dx = x[i] - closestX;
+                float dy = y[i] - closestY;
+                if (dx * dx + dy * dy >= r * r) continue;
+
+                if (x[i] < paddleX + paddleWidth * 0.5f) {
+                    x[i] = paddleX - r;
+                    vx[i] = -fabs(vx[i]);
+                } else {
+                    x[i] = paddleX + paddleWidth + r;
+                    vx[i] = fabs(vx[i]);
+                }
+                field.paddleHits++;
+                SpawnParticles(field, closestX, closestY);
+            }
+        }
+    }
+
+    // Age the particles; a dead one is replaced by the last
+    for (int p = 0; p < field.particleCount; ) {
+        field.particleLife[p] -= deltaTime;
+        if (field.particleLife[p] <= 0.0f) {
+            int last = --field.particleCount;
+            field.particleX[p] = field.particleX[last];
+            field.particleY[p] = field.particleY[last];
+            field.particleVelocityX[p] = field.particleVelocityX[last];
+            field.particleVelocityY[p] = field.particleVelocityY[last];
+            field.particleLife[p] = field.particleLife[last];
+            continue;
+        }
+        field.particleX[p] += field.particleVelocityX[p] * deltaTime;
+        field.particleY[p] += field.particleVelocityY[p] * deltaTime;
+        p++;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef STRESS_FIELD_H
+#define STRESS_FIELD_H
+
+#include "game_sim.h"
+
+// Stress mode: many small balls bouncing off every wall, the paddle and each
+// other, with a few short-lived particles thrown off at each hit. Nothing is
+// scored and nothing ends; it measures how far physics and drawing scale.
+//
+// Balls and particles live in structure-of-arrays pools; removing one moves
+// the last into its slot. Each step sorts the balls into a uniform grid of
+// ball-sized cells (a counting sort, so no allocation), and collisions are
+// only tested against the neighbouring cells.
+
+const float STRESS_BALL_RADIUS = 4.0f;
+const float STRESS_CELL_SIZE = 2.0f * STRESS_BALL_RADIUS;   // Touching balls are at most one cell apart
+const int STRESS_PARTICLES_PER_HIT = 3;
+const float STRESS_PARTICLE_LIFE = 0.4f;                    // Seconds
+
+struct StressField {
+    int capacity;
+    int count;
+    float* ballX;
+    float* ballY;
+    float* ballVelocityX;
+    float* ballVelocityY;
+
+    int particleCapacity;
+    int particleCount;
+    float* particleX;
+    float* particleY;
+    float* particleVelocityX;
+    float* particleVelocityY;
+    float* particleLife;        // Seconds left
+
+    // Grid, rebuilt every step: the balls of cell c are
+    // cellBalls[cellStart[c]] to cellBalls[cellStart[c + 1] - 1]
+    int gridColumns;
+    int gridRows;
+    int* cellStart;
+    int* cellBalls;
+    int* ballCell;
+
+    float paddleY;
+    unsigned int seed;
+    long long ballHits;         // Totals since StressInit
+    long long paddleHits;
+};
+
+void StressInit(StressField &field, int capacity, int particleCapacity, unsigned int seed);
+void StressFree(StressField &field);
+
+// Adds balls at random places and directions (speed in pixels/s), or drops
+// the most recently added, until there are count (at most capacity)
+void StressSetCount(StressField &field, int count, float speed);
+
+// Moves every ball and particle and resolves the contacts; input moves the paddle
+void StressStep(StressField &field, const SimInput &input, float deltaTime, const SimParams &params = DEFAULT_SIM_PARAMS);
+
+#endif
@@ -0,0 +1,87 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threadCount) : pending(0), queued(0), nextQueue(0), stopping(false) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(new WorkerQueue());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(thread(&ThreadPool::WorkerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    for (size_t i = 0; i < queues.size(); i++) {
+        delete queues[i];
+    }
+}
+
+void ThreadPool::Submit(function<void()> task) {
+    WorkerQueue* queue = queues[nextQueue++ % queues.size()];
+    pending++;
+    {
+        lock_guard<mutex> lock(queue->mutex);
+        queue->tasks.push_back(task);
+    }
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        queued++;
+    }
+    wakeCondition.notify_one();
+}
+
+void ThreadPool::Wait() {
+    unique_lock<mutex> lock(wakeMutex);
+    doneCondition.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::PopOwn(int worker, function<void()> &task) {
+    WorkerQueue* queue = queues[worker];
+    lock_guard<mutex> lock(queue->mutex);
+    if (queue->tasks.empty()) return false;
+    task = queue->tasks.back();
+    queue->tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::Steal(int worker, function<void()> &task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkerQueue* victim = queues[(worker + i) % queues.size()];
+        lock_guard<mutex> lock(victim->mutex);
+        if (victim->tasks.empty()) continue;
+        task = victim->tasks.front();
+        victim->tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+    while (true) {
+        function<void()> task;
+        if (PopOwn(worker, task) || Steal(worker, task)) {
+            queued--;
+            task();
+            if (--pending == 0) {
+                lock_guard<mutex> lock(wakeMutex);
+                doneCondition.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing to run anywhere: sleep until a submit or shutdown
+        unique_lock<mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+// Fixed-size work-stealing thread pool. Each worker owns a task queue and
+// takes from its back; idle workers steal from the front of the others.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    // Queues a task, spreading submissions round-robin over the workers
+    void Submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished
+    void Wait();
+
+    int ThreadCount() const { return (int)workers.size(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    bool PopOwn(int worker, std::function<void()> &task);
+    bool Steal(int worker, std::function<void()> &task);
+    void WorkerLoop(int worker);
+
+    std::vector<std::thread> workers;
+    std::vector<WorkerQueue*> queues;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    std::atomic<int> pending;       // Submitted but not finished
+    std::atomic<int> queued;        // Submitted but not started
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "ui_layout.h"
+#include <cstdio>
+
+using namespace std;
+
+UiLabel MakeLabel(const char* text, int x, int y, int fontSize) {
+    UiLabel label;
+    label.text = text;
+    label.x = x;
+    label.y = y;
+    label.fontSize = fontSize;
+    label.width = MeasureText(text, fontSize);
+    return label;
+}
+
+UiLabel MakeCenteredLabel(const char* text, int centerX, int y, int fontSize) {
+    UiLabel label = MakeLabel(text, 0, y, fontSize);
+    label.x = centerX - label.width / 2;
+    return label;
+}
+
+UiButton MakeButton(Rectangle bounds, const char* text, int fontSize, int textOffsetY) {
+    UiButton button;
+    button.bounds = bounds;
+    button.text = text;
+    button.fontSize = fontSize;
+    button.textX = (int)(bounds.x + (bounds.width - MeasureText(text, fontSize)) / 2);
+    button.textY = (int)bounds.y + textOffsetY;
+    return button;
+}
+
+void InitNumberText(UiNumberText &text, const char* format, int fontSize) {
+    text.format = format;
+    text.fontSize = fontSize;
+    text.valid = false;
+}
+
+const char* NumberText(UiNumberText &text, int value) {
+    if (!text.valid || text.value != value) {
+        snprintf(text.text, sizeof(text.text), text.format, value);
+        text.width = MeasureText(text.text, text.fontSize);
+        text.value = value;
+        text.valid = true;
+    }
+    return text.text;
+}
+
+void DrawLabel(const UiLabel &label, Color color) {
+    DrawText(label.text, label.x, label.y, label.fontSize, color);
+}
+
+bool ButtonHovered(const UiButton &button, Vector2 mousePoint) {
+    return CheckCollisionPointRec(mousePoint, button.bounds);
+}
+
+void DrawButtons(const UiButton* buttons, const Color* fills, int count, Color border, Color caption) {
+    if (fills) {
+        for (int i = 0; i < count; i++) DrawRectangleRec(buttons[i].bounds, fills[i]);
+        for (int i = 0; i < count; i++) {
+            const Rectangle &b = buttons[i].bounds;
+            DrawRectangleLines((int)b.x, (int)b.y, (int)b.width, (int)b.height, border);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        DrawText(buttons[i].text, buttons[i].textX, buttons[i].textY, buttons[i].fontSize, caption);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef UI_LAYOUT_H
+#define UI_LAYOUT_H
+
+#include "raylib.h"
+
+// Retained UI pieces. Text widths and button geometry are measured when a
+// screen's layout is built instead of every frame, and numbers shown as
+// text are only formatted again when their value changes.
+
+struct UiLabel {
+    const char* text;
+    int x, y;
+    int fontSize;
+    int width;
+};
+
+struct UiButton {
+    Rectangle bounds;
+    const char* text;
+    int textX, textY;       // Caption position, centered in bounds
+    int fontSize;
+};
+
+// Text made from one int with a printf format, e.g. "Score: %d"
+struct UiNumberText {
+    const char* format;
+    int fontSize;
+    int value;
+    bool valid;
+    char text[64];
+    int width;
+};
+
+UiLabel MakeLabel(const char* text, int x, int y, int fontSize);
+UiLabel MakeCenteredLabel(const char* text, int centerX, int y, int fontSize);
+UiButton MakeButton(Rectangle bounds, const char* text, int fontSize, int textOffsetY);
+
+void InitNumberText(UiNumberText &text, const char* format, int fontSize);
+// Returns the text for value, formatting and measuring it only on change
+const char* NumberText(UiNumberText &text, int value);
+
+void DrawLabel(const UiLabel &label, Color color);
+bool ButtonHovered(const UiButton &button, Vector2 mousePoint);
+
+// Draws buttons in passes, all fills, then all outlines, then all
+// captions, so each run of draw calls is one kind of primitive.
+// fills may be NULL for caption-only buttons.
+void DrawButtons(const UiButton* buttons, const Color* fills, int count, Color border, Color caption);
+
+#endif